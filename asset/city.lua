@@ -30,6 +30,7 @@ components = {
         }
     },
     model = {
-        path = "res/model/city/city.fbx"
+        path = "res/model/city/city.fbx",
+        occluder = true
     }
 }
@@ -0,0 +1,16 @@
+-- Benchmark entity, bobs up and down every update.
+speed = 1.0
+elapsed = 0.0
+
+function update(evt)
+    local dt = evt:to_update().delta
+    elapsed = elapsed + dt
+    if elapsed > 1.0 then
+        elapsed = 0.0
+        speed = -speed
+    end
+    local tf = this:entity():get_transform()
+    tf.translation.y = tf.translation.y + speed * dt
+end
+
+this:register_event(event.update, update)
@@ -1,25 +1,52 @@
 #version 410 core
 layout (location = 0) in vec3 in_pos;
-layout (location = 1) in vec3 in_normal;
+layout (location = 1) in vec2 in_normal; // Octahedral encoded
 layout (location = 2) in vec2 in_uvs;
-layout (location = 3) in ivec4 in_bone_index;
-layout (location = 4) in vec4 in_bone_weight;
+layout (location = 4) in uvec4 in_bone_index;
+layout (location = 5) in vec4 in_bone_weight;
 
-const int MAX_BONES = 100;
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+} u_camera;
 
 uniform struct Matrices {
     mat4 model;
-    mat4 view;
-    mat4 projection;
 } u_matrices;
 
-uniform mat4 u_bones[MAX_BONES];
+// Skinning matrices of every posed entity this frame, 4 texels each.
+uniform struct Skin {
+    samplerBuffer bones;
+    int offset; // -1 when not posed
+} u_skin;
 
 out VertexData {
     vec2 uvs;
 } o;
 
+mat4 get_bone(int bone) {
+    int texel = (u_skin.offset + bone) * 4;
+
+    return mat4(texelFetch(u_skin.bones, texel),
+                texelFetch(u_skin.bones, texel + 1),
+                texelFetch(u_skin.bones, texel + 2),
+                texelFetch(u_skin.bones, texel + 3));
+}
+
 void main() {
+    vec4 position = vec4(in_pos, 1.0);
+    float weight  = dot(in_bone_weight, vec4(1.0));
+
+    // Without a pose the mesh is drawn as it was modelled.
+    if (u_skin.offset >= 0 && weight > 0.0) {
+        mat4 skin = get_bone(int(in_bone_index.x)) * in_bone_weight.x +
+                    get_bone(int(in_bone_index.y)) * in_bone_weight.y +
+                    get_bone(int(in_bone_index.z)) * in_bone_weight.z +
+                    get_bone(int(in_bone_index.w)) * in_bone_weight.w;
+
+        position = vec4((skin * position).xyz / weight, 1.0);
+    }
+
     o.uvs = in_uvs;
-    gl_Position = u_matrices.projection * u_matrices.view * u_matrices.model * vec4(in_pos, 1.0);
+    gl_Position = u_camera.projection * u_camera.view * u_matrices.model * position;
 }
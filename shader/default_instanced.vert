@@ -0,0 +1,19 @@
+#version 410 core
+layout (location = 0) in vec3 in_pos;
+layout (location = 1) in vec2 in_normal; // Octahedral encoded
+layout (location = 2) in vec2 in_uvs;
+layout (location = 8) in mat4 in_model;
+
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+} u_camera;
+
+out VertexData {
+    vec2 uvs;
+} o;
+
+void main() {
+    o.uvs = in_uvs;
+    gl_Position = u_camera.projection * u_camera.view * in_model * vec4(in_pos, 1.0);
+}
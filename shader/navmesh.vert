@@ -1,12 +1,15 @@
 #version 410 core
 layout (location = 0) in vec3 in_pos;
-layout (location = 1) in vec3 in_normal;
+layout (location = 1) in vec2 in_normal; // Octahedral encoded
 layout (location = 2) in vec2 in_uvs;
 
-uniform struct Matrices {
-    mat4 model;
+layout (std140) uniform Camera {
     mat4 view;
     mat4 projection;
+} u_camera;
+
+uniform struct Matrices {
+    mat4 model;
 } u_matrices;
 
 out VertexData {
@@ -17,5 +20,5 @@ out VertexData {
 void main() {
     o.uvs = in_uvs;
     o.pos = in_pos;
-    gl_Position = u_matrices.projection * u_matrices.view * u_matrices.model * vec4(in_pos, 1.0);
+    gl_Position = u_camera.projection * u_camera.view * u_matrices.model * vec4(in_pos, 1.0);
 }
@@ -1,21 +1,53 @@
 #version 410 core
-layout (location = 0) in vec3 in_pos;
-layout (location = 1) in vec3 in_normal;
-layout (location = 2) in vec2 in_uvs;
+layout (location = 0) in vec2 in_grid;
 
-uniform struct Matrices {
-    mat4 model;
+layout (std140) uniform Camera {
     mat4 view;
     mat4 projection;
+} u_camera;
+
+uniform struct Matrices {
+    mat4 model;
 } u_matrices;
 
+uniform struct Terrain {
+    sampler2D heights;
+    vec2 size;
+    vec3 camera;
+    vec2 offset;
+    float scale;
+    vec2 morph;
+} u_terrain;
+
 out VertexData {
     vec2 uvs;
     vec3 pos;
 } o;
 
+float height_at(vec2 sample) {
+    return texture(u_terrain.heights, (sample + 0.5) / u_terrain.size).r;
+}
+
+vec3 terrain_pos(vec2 sample) {
+    return vec3(sample.x - u_terrain.size.x / 2.0, height_at(sample),
+                sample.y - u_terrain.size.y / 2.0);
+}
+
 void main() {
-    o.uvs = in_uvs;
-    o.pos = in_pos;
-    gl_Position = u_matrices.projection * u_matrices.view * u_matrices.model * vec4(in_pos, 1.0);
+    vec2 last = u_terrain.size - 1.0;
+    vec2 sample = min(u_terrain.offset + in_grid * u_terrain.scale, last);
+
+    // Slide odd grid vertices onto their even neighbours as the patch nears
+    // the end of its range, so it matches the coarser level past it.
+    float distance = length(u_terrain.camera - terrain_pos(sample));
+    float k = clamp((distance - u_terrain.morph.x) /
+                    max(u_terrain.morph.y - u_terrain.morph.x, 0.001), 0.0, 1.0);
+    vec2 odd = fract(in_grid * 0.5) * 2.0;
+    sample = min(sample - odd * u_terrain.scale * k, last);
+
+    vec3 pos = terrain_pos(sample);
+
+    o.uvs = sample / 2.0;
+    o.pos = pos;
+    gl_Position = u_camera.projection * u_camera.view * u_matrices.model * vec4(pos, 1.0);
 }
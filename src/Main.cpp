@@ -1,14 +1,30 @@
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
 #include "afk/Afk.hpp"
 
 using std::exception;
+using namespace std::string_literals;
 
-auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
+auto main(int argc, char **argv) -> int {
   auto &afk = Afk::Engine::get();
 
+  for (auto i = 1; i < argc; ++i) {
+    if (argv[i] == "--headless"s) {
+      afk.headless = true;
+    } else if (argv[i] == "--pipelined"s) {
+      afk.pipelined = true;
+    } else if ((argv[i] == "--record"s || argv[i] == "--replay"s) && i + 1 < argc) {
+      auto &file_path = argv[i] == "--record"s ? afk.record_path : afk.replay_path;
+      file_path       = argv[++i];
+    } else {
+      std::cerr << "Unknown argument '" << argv[i] << "'\n";
+      return EXIT_FAILURE;
+    }
+  }
+
   afk.initialize();
 
   while (afk.get_is_running()) {
@@ -16,5 +32,7 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     afk.render();
   }
 
+  afk.shutdown();
+
   return EXIT_SUCCESS;
 }
@@ -1,6 +1,11 @@
 #include "afk/Afk.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
 #include <memory>
+#include <random>
 #include <string>
 #include <utility>
 
@@ -16,12 +21,16 @@
 #include "afk/component/ScriptsComponent.hpp"
 #include "afk/component/TagComponent.hpp"
 #include "afk/debug/Assert.hpp"
+#include "afk/debug/Profiler.hpp"
 #include "afk/io/Log.hpp"
 #include "afk/io/ModelSource.hpp"
+#include "afk/memory/MemoryHooks.hpp"
+#include "afk/memory/MemoryTracker.hpp"
 #include "afk/physics/PhysicsBody.hpp"
 #include "afk/physics/RigidBodyType.hpp"
 #include "afk/physics/shape/Box.hpp"
 #include "afk/physics/shape/Sphere.hpp"
+#include "afk/renderer/AnimationSystem.hpp"
 #include "afk/renderer/ModelRenderSystem.hpp"
 #include "afk/script/Bindings.hpp"
 #include "afk/script/LuaInclude.hpp"
@@ -39,8 +48,29 @@ using Movement = Afk::Camera::Movement;
 
 auto Engine::initialize() -> void {
   afk_assert(!this->is_initialized, "Engine already initialized");
+  afk_assert(this->record_path.empty() || this->replay_path.empty(),
+             "Can't record and replay at the same time");
+
+  // Seed everything random, from the recording when replaying.
+  auto device = std::random_device{};
+  auto seed   = (std::uint64_t{device()} << 32) | device();
+
+  if (!this->replay_path.empty()) {
+    seed = this->replay.play(this->replay_path);
+    this->event_manager.ignore_window_input = true;
+  } else if (!this->record_path.empty()) {
+    this->replay.record(this->record_path, seed);
+  }
+
+  this->seed_generator.seed(seed);
+  this->random.seed(static_cast<std::mt19937::result_type>(seed));
+
+  afk_profile_thread("Main");
+  this->job_system.initialize();
+  this->scheduler.initialize(&this->job_system);
+  this->add_systems();
 
-  this->renderer.initialize();
+  this->renderer.initialize(this->headless);
   this->event_manager.initialize(this->renderer.window);
   //  this->renderer.set_wireframe(true);
 
@@ -48,24 +78,61 @@ auto Engine::initialize() -> void {
   // init crowds with the navmesh
   // then add components
 
-  this->ui.initialize(this->renderer.window);
-  this->lua = luaL_newstate();
+  if (!this->headless) {
+    this->ui.initialize(this->renderer.window);
+  }
+
+  this->lua = Memory::new_lua_state();
   luaL_openlibs(this->lua);
   Afk::add_engine_bindings(this->lua);
 
   this->terrain_manager.initialize();
+
+  // Whatever the engine holds from here on should be gone by shutdown.
+  Memory::set_baseline();
+
+  if (this->default_scene) {
+    this->load_default_scene();
+    this->load_scene_models();
+  }
+
+  this->save_previous_transforms();
+  this->last_update    = Afk::Engine::get_time();
+  this->is_initialized = true;
+}
+
+auto Engine::load_default_scene() -> void {
   const int terrain_width  = 128;
   const int terrain_length = 128;
+  const auto nav_mesh_path = std::filesystem::path{"res/gen/navmesh/human.nmesh"};
+
+  // The nav mesh may be baked from the box, so import it on a worker while the
+  // terrain generates.
+  auto imports   = Thread::JobCounter{};
+  auto box_model = Model{};
+  this->job_system.run(
+      [this, &box_model] {
+        box_model = Model{"res/model/box/box.obj"};
+        this->renderer.decode_textures(box_model);
+      },
+      &imports);
+
   this->terrain_manager.generate_terrain(terrain_width, terrain_length, 0.05f, 7.5f);
-  this->renderer.load_model(this->terrain_manager.get_model());
+  this->renderer.load_terrain(this->terrain_manager.height_map,
+                              this->terrain_manager.quad_tree.get_patch_size());
+  this->job_system.wait(imports);
 
   auto terrain_entity           = registry.create();
   auto terrain_transform        = Transform{terrain_entity};
   terrain_transform.translation = glm::vec3{0.0f, -10.0f, 0.0f};
-  registry.assign<Afk::ModelSource>(terrain_entity, terrain_entity,
-                                    terrain_manager.get_model().file_path,
-                                    "shader/terrain.prog");
-  registry.assign<Afk::Model>(terrain_entity, terrain_entity, terrain_manager.get_model());
+  this->terrain_manager.set_entity(terrain_entity, "shader/terrain.prog");
+
+  // Only baking the nav mesh needs the terrain's triangles, and it's usually
+  // loaded already baked.
+  if (!std::filesystem::exists(nav_mesh_path)) {
+    registry.assign<Afk::Model>(terrain_entity, terrain_entity, terrain_manager.get_model());
+  }
+
   registry.assign<Afk::Transform>(terrain_entity, terrain_transform);
   registry.assign<Afk::PhysicsBody>(terrain_entity, terrain_entity, &this->physics_body_system,
                                     terrain_transform, 0.3f, 0.0f, 0.0f, 0.0f,
@@ -79,7 +146,7 @@ auto Engine::initialize() -> void {
   auto box_transform        = Transform{box_entity};
   box_transform.translation = glm::vec3{0.0f, -15.0f, 0.0f};
   box_transform.scale       = glm::vec3(5.0f);
-  auto box_model            = Model(box_entity, "res/model/box/box.obj");
+  box_model.owning_entity   = box_entity;
   this->renderer.load_model(box_model);
   registry.assign<Afk::ModelSource>(box_entity, box_entity, box_model.file_path,
                                     "shader/default.prog");
@@ -98,7 +165,7 @@ auto Engine::initialize() -> void {
                                                           // .ent;
 
   // nav mesh needs to be generated BEFORE agents, otherwise agents may be added to the nav mesh
-  this->nav_mesh_manager.initialise("res/gen/navmesh/human.nmesh");
+  this->nav_mesh_manager.initialise(nav_mesh_path);
   //  this->nav_mesh_manager.initialise("res/gen/navmesh/solo_navmesh.bin", this->terrain_manager.get_model().meshes[0], terrain_transform);
   this->crowds.init(this->nav_mesh_manager.get_nav_mesh());
 
@@ -199,8 +266,18 @@ auto Engine::initialize() -> void {
                                     Afk::Box(1.0f, 1.0f, 1.0f));
 
   this->difficulty_manager.init(AI::DifficultyManager::Difficulty::NORMAL);
+}
 
-  this->is_initialized = true;
+auto Engine::load_scene_models() -> void {
+  afk_profile_zone("Engine::load_scene_models");
+  auto imports = Thread::JobCounter{};
+
+  for (const auto entity : this->registry.view<ModelSource>()) {
+    this->renderer.import_model(this->registry.get<ModelSource>(entity).get_name(), imports);
+  }
+
+  this->job_system.wait(imports);
+  this->renderer.upload_imported_models();
 }
 
 auto Engine::get() -> Engine & {
@@ -210,55 +287,287 @@ auto Engine::get() -> Engine & {
 }
 
 auto Engine::exit() -> void {
-  lua_close(this->lua);
   this->is_running = false;
 }
 
+auto Engine::shutdown() -> void {
+  this->renderer.wait_for_imports();
+
+  // Scripts hold references into the Lua state, so they go first.
+  this->registry.clear();
+  lua_close(this->lua);
+  this->lua = nullptr;
+  Memory::log_leaks();
+}
+
 auto Engine::render() -> void {
-  Afk::queue_models(&this->registry, &this->renderer);
-
-  this->renderer.clear_screen({135.0f, 206.0f, 235.0f, 1.0f});
-  this->ui.prepare();
-  this->renderer.draw();
-  this->event_manager.pump_render();
-  this->ui.draw();
-  this->renderer.swap_buffers();
+  afk_profile_zone("Engine::render");
+
+  if (!this->pipelined) {
+    this->queue_frame(this->renderer.get_window_size());
+    this->renderer.swap_frame_packets();
+  }
+
+  // Models asked for from the simulation, which may be on a worker, are only
+  // uploaded here on the GL thread.
+  this->renderer.upload_imported_models();
+
+  if (this->headless) {
+    this->renderer.draw();
+  } else {
+    this->renderer.clear_screen({135.0f, 206.0f, 235.0f, 1.0f});
+
+    if (!this->pipelined) {
+      this->ui.prepare();
+      this->event_manager.pump_render();
+      this->ui.draw();
+    }
+
+    this->renderer.draw();
+    this->ui.submit();
+    this->renderer.swap_buffers();
+  }
+
+  if (this->pipelined) {
+    // Hand the world back to the main thread before the next frame.
+    this->job_system.wait(this->simulation_counter);
+  }
+
+  this->frame_arena.reset();
 }
 
 auto Engine::update() -> void {
-  this->event_manager.pump_events();
-  this->crowds.update(this->get_delta_time());
-  for (auto &agent_ent : this->registry.view<Afk::AI::AgentComponent>()) {
-    auto &agent = this->registry.get<Afk::AI::AgentComponent>(agent_ent);
-    agent.update();
+  afk_profile_zone("Engine::update");
+  const auto now             = Afk::Engine::get_time();
+  const auto wall_frame_time = now - this->last_update;
+  this->last_update          = now;
+
+  this->event_manager.poll_events();
+
+  const auto frame_time = this->begin_frame(wall_frame_time);
+
+  if (!this->is_running) {
+    return;
   }
 
-  if (glfwWindowShouldClose(this->renderer.window)) {
-    this->is_running = false;
+  if (!this->headless) {
+    if (glfwWindowShouldClose(this->renderer.window)) {
+      this->is_running = false;
+    }
+
+    if (this->ui.show_menu) {
+      glfwSetInputMode(this->renderer.window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+    } else {
+      glfwSetInputMode(this->renderer.window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    }
   }
 
-  if (this->ui.show_menu) {
-    glfwSetInputMode(this->renderer.window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-  } else {
-    glfwSetInputMode(this->renderer.window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+  ++this->frame_count;
+
+  if (!this->pipelined) {
+    this->advance(frame_time);
+    return;
   }
 
-  // this->update_camera();
+  // Draw what the last step produced while this step runs on a worker. The
+  // UI and render callbacks read the world, so they have to go first.
+  this->renderer.swap_frame_packets();
 
-  this->physics_body_system.update(&this->registry, this->get_delta_time());
+  if (!this->headless) {
+    this->ui.prepare();
+    this->event_manager.pump_render();
+    this->ui.draw();
+  }
 
-  ++this->frame_count;
-  this->last_update = Afk::Engine::get_time();
+  const auto window_size = this->renderer.get_window_size();
+
+  this->job_system.run(
+      [this, frame_time, window_size] {
+        this->advance(frame_time);
+        this->queue_frame(window_size);
+      },
+      &this->simulation_counter);
+}
+
+auto Engine::add_systems() -> void {
+  using System = Thread::SystemScheduler::System;
+
+  // Event callbacks run arbitrary Lua, which can touch anything, and the Lua
+  // state must only be used from the thread stepping the simulation.
+  this->scheduler.add_system(
+      System{"events", [this]([[maybe_unused]] float dt) { this->event_manager.pump_events(); }}
+          .exclusive()
+          .on_main_thread());
+
+  // Crowds and physics share nothing, so they step side by side. Agents feed
+  // the crowd's new positions into their bodies afterwards, which physics
+  // picks up the following step.
+  this->scheduler.add_system(
+      System{"crowds", [this](float dt) { this->crowds.update(dt); }}.writes<AI::Crowds>());
+
+  // Only clocks advance here, poses are sampled for the entities drawn.
+  this->scheduler.add_system(
+      System{"animations",
+             [this](float dt) { Afk::advance_animations(&this->registry, dt); }}
+          .writes<Afk::AnimComponent>());
+
+  this->scheduler.add_system(
+      System{"physics",
+             [this](float dt) { this->physics_body_system.update(&this->registry, dt); }}
+          .reads<Afk::TagComponent>()
+          .writes<Afk::PhysicsBodySystem>()
+          .writes<Afk::PhysicsBody>()
+          .writes<Afk::Transform>()
+          .writes<Afk::RenderTree>()
+          .writes<Afk::EventManager>());
+
+  this->scheduler.add_system(
+      System{"agents",
+             [this]([[maybe_unused]] float dt) {
+               afk_profile_zone("Agents");
+               for (auto &agent_ent : this->registry.view<Afk::AI::AgentComponent>()) {
+                 auto &agent = this->registry.get<Afk::AI::AgentComponent>(agent_ent);
+                 agent.update();
+               }
+             }}
+          .writes<AI::AgentComponent>()
+          .writes<AI::Crowds>()
+          .writes<std::mt19937>()
+          .writes<Afk::PhysicsBody>()
+          .writes<Afk::Transform>()
+          .writes<Afk::RenderTree>());
+}
+
+auto Engine::advance(float frame_time) -> void {
+  if (!this->fixed_timestep) {
+    this->simulate(frame_time);
+    return;
+  }
+
+  const auto step = 1.0f / this->simulation_rate;
+  auto substeps   = 0;
+
+  this->accumulator += frame_time;
+
+  while (this->accumulator >= step && substeps < this->max_substeps) {
+    this->save_previous_transforms();
+    this->simulate(step);
+    this->accumulator -= step;
+    ++substeps;
+  }
+
+  // Drop whatever we couldn't catch up on rather than spiralling.
+  if (substeps == this->max_substeps) {
+    this->accumulator = std::fmod(this->accumulator, step);
+  }
+}
+
+auto Engine::queue_frame(glm::ivec2 window_size) -> void {
+  afk_profile_zone("Engine::queue_frame");
+  const auto alpha = this->get_interpolation_alpha();
+
+  // Draw the camera where it was at the interpolated point in time, so it
+  // doesn't jitter relative to the interpolated world.
+  const auto camera_position = this->camera.get_position();
+  this->camera.set_position(glm::mix(this->previous_camera_position, camera_position, alpha));
+
+  const auto projection = this->camera.get_projection_matrix(window_size.x, window_size.y);
+  const auto view       = this->camera.get_view_matrix();
+
+  this->renderer.queue_camera(projection, view);
+  Afk::queue_models(&this->registry, &this->renderer, &this->render_tree,
+                    Afk::make_frustum(projection * view), alpha);
+  this->terrain_manager.queue_draw(projection * view, this->camera.get_position());
+
+  this->camera.set_position(camera_position);
+}
+
+auto Engine::begin_frame(float frame_time) -> float {
+  auto frame = Replay::Frame{};
+  const auto step_time =
+      this->frame_time_override > 0.0f ? this->frame_time_override : frame_time;
+
+  switch (this->replay.get_mode()) {
+    case Replay::Mode::Play: {
+      if (!this->replay.read_frame(frame)) {
+        this->replay.log_frame_times();
+        this->is_running = false;
+        return 0.0f;
+      }
+
+      // The first frame time includes initialization.
+      if (this->frame_count > 0) {
+        this->replay.add_frame_time(frame_time);
+      }
+
+      for (const auto &event : frame.events) {
+        this->event_manager.queue_input(event);
+      }
+
+      this->event_manager.take_frame_input();
+      break;
+    }
+    case Replay::Mode::Record: {
+      frame.frame_time = step_time;
+      frame.seed       = this->seed_generator();
+      frame.events     = this->event_manager.take_frame_input();
+      this->replay.write_frame(frame);
+      break;
+    }
+    case Replay::Mode::None: {
+      frame.frame_time = step_time;
+      frame.seed       = this->seed_generator();
+      this->event_manager.take_frame_input();
+      break;
+    }
+  }
+
+  // A fresh seed every frame keeps replays in step even when a change alters
+  // how many random numbers a frame uses.
+  this->random.seed(static_cast<std::mt19937::result_type>(frame.seed));
+
+  return frame.frame_time;
+}
+
+auto Engine::simulate(float dt) -> void {
+  afk_profile_zone("Engine::simulate");
+  this->delta_time = dt;
+  this->simulation_time += dt;
+  this->scheduler.run(dt);
+}
+
+auto Engine::save_previous_transforms() -> void {
+  this->registry.view<Afk::Transform>().each([this](const auto entity, const auto &transform) {
+    this->registry.assign_or_replace<Afk::PreviousTransform>(entity, entity, transform);
+  });
+
+  this->previous_camera_position = this->camera.get_position();
 }
 
 auto Engine::get_time() -> float {
-  return static_cast<float>(glfwGetTime());
+  // Not glfwGetTime(), GLFW is never initialized when running headless.
+  using Clock = std::chrono::steady_clock;
+  static const auto start_time = Clock::now();
+
+  return std::chrono::duration<float>(Clock::now() - start_time).count();
 }
 
 auto Engine::get_delta_time() -> float {
-  return this->get_time() - this->last_update;
+  return this->delta_time;
+}
+
+auto Engine::get_simulation_time() const -> float {
+  return this->simulation_time;
 }
 
 auto Engine::get_is_running() const -> bool {
   return this->is_running;
 }
+
+auto Engine::get_interpolation_alpha() const -> float {
+  if (!this->fixed_timestep) {
+    return 1.0f;
+  }
+
+  return std::clamp(this->accumulator * this->simulation_rate, 0.0f, 1.0f);
+}
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <filesystem>
+#include <random>
+
 #include <entt/entt.hpp>
 #include <glm/glm.hpp>
 
@@ -7,10 +11,15 @@
 #include "afk/ai/DifficultyManager.hpp"
 #include "afk/ai/NavMeshManager.hpp"
 #include "afk/event/EventManager.hpp"
+#include "afk/event/Replay.hpp"
+#include "afk/memory/FrameArena.hpp"
 #include "afk/physics/PhysicsBodySystem.hpp"
 #include "afk/renderer/Camera.hpp"
+#include "afk/renderer/RenderTree.hpp"
 #include "afk/renderer/Renderer.hpp"
 #include "afk/terrain/TerrainManager.hpp"
+#include "afk/thread/JobSystem.hpp"
+#include "afk/thread/SystemScheduler.hpp"
 #include "afk/ui/Ui.hpp"
 #include "entt/entt.hpp"
 
@@ -20,13 +29,22 @@ namespace Afk {
   public:
     static constexpr const char *GAME_NAME = "ICT397";
 
+    /**
+     * Memory for data that only lives for a frame, recycled at the end of
+     * render()
+     */
+    Memory::FrameArena frame_arena{};
+
     Renderer renderer                   = {};
     EventManager event_manager          = {};
     Ui ui                               = {};
     Camera camera                       = {};
+    RenderTree render_tree              = {};
     TerrainManager terrain_manager      = {};
     AI::NavMeshManager nav_mesh_manager = {};
     AI::Crowds crowds                   = {};
+    Thread::JobSystem job_system        = {};
+    Thread::SystemScheduler scheduler   = {};
 
     entt::registry registry;
     Afk::PhysicsBodySystem physics_body_system{glm::vec3(0.0f, -9.81f, 0.0f)};
@@ -34,6 +52,56 @@ namespace Afk {
 
     GameObject camera_entity = registry.create();
 
+    /**
+     * Step the simulation at a fixed rate and interpolate transforms between
+     * the last two simulation states when rendering
+     */
+    bool fixed_timestep = true;
+    /**
+     * Simulation steps per second when using a fixed timestep
+     */
+    float simulation_rate = 60.0f;
+    /**
+     * Maximum simulation steps per frame, any time beyond this is dropped
+     */
+    int max_substeps = 5;
+    /**
+     * Run without a window, GPU or UI; draw commands are recorded but never
+     * submitted. Must be set before initialization.
+     */
+    bool headless = false;
+    /**
+     * Simulate the next frame on a worker while the main thread draws the
+     * last one, at the cost of a frame of latency. Must be set before
+     * initialization.
+     */
+    bool pipelined = false;
+    /**
+     * Record every frame's input, frame time and random seed to this file.
+     * Must be set before initialization.
+     */
+    std::filesystem::path record_path = {};
+    /**
+     * Play back a recording instead of live input and wall clock frame times,
+     * exiting when it ends. Must be set before initialization.
+     */
+    std::filesystem::path replay_path = {};
+    /**
+     * Advance every frame by this many seconds instead of the wall clock
+     * time, zero uses the clock. Ignored when replaying.
+     */
+    float frame_time_override = 0.0f;
+    /**
+     * Populate the world with the default scene, turn this off to build a
+     * scene by hand after initialization. Must be set before initialization.
+     */
+    bool default_scene = true;
+    /**
+     * Random numbers for simulation code, reseeded every frame so recordings
+     * replay exactly. Systems using it must declare they write it.
+     */
+    std::mt19937 random = {};
+
     Engine()               = default;
     ~Engine()              = default;
     Engine(Engine &&)      = delete;
@@ -43,21 +111,63 @@ namespace Afk {
 
     static auto get() -> Engine &;
 
+    /**
+     * Stop running after the current frame
+     */
     auto exit() -> void;
     auto initialize() -> void;
+    /**
+     * Import every model the scene's entities draw on worker threads, then
+     * upload them all, rather than loading each on the frame it is first
+     * drawn
+     */
+    auto load_scene_models() -> void;
+    /**
+     * Destroy the scene and report any memory it leaked, once the engine has
+     * stopped running
+     */
+    auto shutdown() -> void;
     auto render() -> void;
     auto update() -> void;
 
     auto static get_time() -> float;
     auto get_delta_time() -> float;
+    /**
+     * Get the total time simulated so far, which unlike get_time() is the
+     * same every time a recording is replayed
+     */
+    auto get_simulation_time() const -> float;
     auto get_is_running() const -> bool;
+    /**
+     * Get how far between the previous and current simulation state the
+     * renderer currently is
+     */
+    auto get_interpolation_alpha() const -> float;
 
     AI::DifficultyManager difficulty_manager = {};
 
   private:
-    bool is_initialized = false;
-    bool is_running     = true;
-    int frame_count     = {};
-    float last_update   = {};
+    bool is_initialized   = false;
+    bool is_running       = true;
+    int frame_count       = {};
+    float last_update     = {};
+    float delta_time      = {};
+    float accumulator     = {};
+    float simulation_time = {};
+
+    Replay replay                  = {};
+    std::mt19937_64 seed_generator = {};
+
+    Thread::JobCounter simulation_counter = {};
+
+    glm::vec3 previous_camera_position = {};
+
+    auto add_systems() -> void;
+    auto load_default_scene() -> void;
+    auto advance(float frame_time) -> void;
+    auto simulate(float dt) -> void;
+    auto queue_frame(glm::ivec2 window_size) -> void;
+    auto begin_frame(float frame_time) -> float;
+    auto save_previous_transforms() -> void;
   };
 }
@@ -4,6 +4,8 @@
 
 #include <glm/glm.hpp>
 
+#include "afk/debug/Profiler.hpp"
+
 using Afk::AI::Crowds;
 
 auto Crowds::current_crowd() -> dtCrowd & {
@@ -11,6 +13,7 @@ auto Crowds::current_crowd() -> dtCrowd & {
 }
 
 auto Crowds::update(float dt_seconds) -> void {
+  afk_profile_zone("Crowds::update");
   this->crowd->update(dt_seconds, nullptr);
 }
 
@@ -38,8 +41,8 @@ auto Crowds::request_move(AgentID id, glm::vec3 pos, float search_dist) -> void
   this->crowd->requestMoveTarget(id, nearest_poly, &nearest_pos.x);
 }
 
-auto Crowds::init(NavMeshManager::nav_mesh_ptr nav_mesh) -> void {
-  if (!this->crowd->init(25,            // max agents
+auto Crowds::init(NavMeshManager::nav_mesh_ptr nav_mesh, int max_agents) -> void {
+  if (!this->crowd->init(max_agents,    // max agents
                          10.f,          // max agent radius
                          nav_mesh.get() // nav mesh
                          )) {
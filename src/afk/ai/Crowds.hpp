@@ -29,8 +29,9 @@ namespace Afk {
       auto update(float dt_seconds) -> void;
       /**
        * Initialize nav mesh
+       * \param max_agents most agents the crowd can hold at once
        */
-      auto init(NavMeshManager::nav_mesh_ptr nav_mesh) -> void;
+      auto init(NavMeshManager::nav_mesh_ptr nav_mesh, int max_agents = 25) -> void;
       /**
        * Get current crowd
        * \todo façade
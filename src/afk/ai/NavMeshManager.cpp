@@ -2,12 +2,14 @@
 
 #include <fstream>
 #include <memory>
+#include <vector>
 
 #include <glm/gtc/type_ptr.inl>
 
 #include "DetourNavMesh.h"
 #include "DetourNavMeshBuilder.h"
 #include "DetourNavMeshQuery.h"
+#include "afk/Afk.hpp"
 #include "afk/component/TagComponent.hpp"
 #include "afk/debug/Assert.hpp"
 #include "afk/io/Log.hpp"
@@ -139,33 +141,42 @@ bool NavMeshManager::bake() {
   auto temp_status = nav_mesh->init(&params);
   afk_assert(!dtStatusFailed(temp_status), "Failed to init nav mesh");
 
-  glm::vec3 tile_bmin = {0.0f, bmin.y, 0.0f};
-  glm::vec3 tile_bmax = {0.0f, bmax.y, 0.0f};
-  for (int y = 0; y < tile_height; y++) {
-    for (int x = 0; x < tile_width; x++) {
-      tile_bmin.x = bmin.x + x * tile_cell_size;
-      tile_bmin.z = bmin.z + y * tile_cell_size;
-      tile_bmax.x = bmin.x + (x + 1) * tile_cell_size;
-      tile_bmax.z = bmin.z + (y + 1) * tile_cell_size;
-      //      std::cout << "bounds: "  << tile_bmin.x << ", " << tile_bmin.z << " - " << tile_bmax.x <<  ", " << tile_bmax.z << std::endl;
-      //      continue;
-
-      int data_size = 0;
-      auto data     = this->build_tile_nav_mesh(x, y, tile_bmin, tile_bmax,
-                                            grid_cell_size, tile_size, data_size,
-                                            chunky_mesh, vertices, triangles);
-
-      if (data) {
-        // Remove any previous data (navmesh owns and deletes the data).
-        nav_mesh->removeTile(nav_mesh->getTileRefAt(x, y, 0), nullptr, nullptr);
-        // Let the navmesh own the data.
-        temp_status = nav_mesh->addTile(data, data_size, DT_TILE_FREE_DATA, 0, nullptr);
-        //        std::cout << "after add tile: " << temp_status << " " << data << std::endl;
-        if (dtStatusFailed(temp_status)) {
-          dtFree(data);
-          //          afk_assert(!dtStatusFailed(temp_status),
-          //                     "failed to add tile to nav mesh");
-        }
+  struct TileData {
+    unsigned char *data = nullptr;
+    int data_size       = 0;
+  };
+
+  // Tiles are independent, so build them all in parallel then add them to the
+  // nav mesh in order.
+  const auto tile_count = static_cast<size_t>(tile_width * tile_height);
+  auto tiles            = std::vector<TileData>(tile_count);
+
+  Afk::Engine::get().job_system.parallel_for(0, tile_count, [&](size_t i) {
+    const auto x = static_cast<int>(i) % tile_width;
+    const auto y = static_cast<int>(i) / tile_width;
+
+    const auto tile_bmin = glm::vec3{bmin.x + x * tile_cell_size, bmin.y,
+                                     bmin.z + y * tile_cell_size};
+    const auto tile_bmax = glm::vec3{bmin.x + (x + 1) * tile_cell_size, bmax.y,
+                                     bmin.z + (y + 1) * tile_cell_size};
+
+    tiles[i].data = this->build_tile_nav_mesh(x, y, tile_bmin, tile_bmax, grid_cell_size,
+                                              tile_size, tiles[i].data_size,
+                                              chunky_mesh, vertices, triangles);
+  });
+
+  for (size_t i = 0; i < tile_count; i++) {
+    const auto x = static_cast<int>(i) % tile_width;
+    const auto y = static_cast<int>(i) / tile_width;
+    auto &tile   = tiles[i];
+
+    if (tile.data) {
+      // Remove any previous data (navmesh owns and deletes the data).
+      nav_mesh->removeTile(nav_mesh->getTileRefAt(x, y, 0), nullptr, nullptr);
+      // Let the navmesh own the data.
+      temp_status = nav_mesh->addTile(tile.data, tile.data_size, DT_TILE_FREE_DATA, 0, nullptr);
+      if (dtStatusFailed(temp_status)) {
+        dtFree(tile.data);
       }
     }
   }
@@ -425,6 +436,7 @@ void NavMeshManager::create_height_field_model(const rcHeightfield &height_field
     }
   }
 
+  mesh.update_bounds();
   height_field_model.meshes.push_back(std::move(mesh));
 }
 
@@ -457,6 +469,7 @@ void NavMeshManager::create_nav_mesh_model(const dtNavMesh &navMesh) {
     }
   }
 
+  mesh.update_bounds();
   nav_mesh_model.meshes.push_back(std::move(mesh));
 }
 
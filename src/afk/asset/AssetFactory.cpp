@@ -10,6 +10,7 @@
 #include "afk/debug/Assert.hpp"
 #include "afk/io/ModelSource.hpp"
 #include "afk/io/Path.hpp"
+#include "afk/memory/MemoryHooks.hpp"
 #include "afk/physics/PhysicsBody.hpp"
 #include "afk/physics/RigidBodyType.hpp"
 #include "afk/physics/Transform.hpp"
@@ -97,11 +98,13 @@ static auto load_object_asset(lua_State *lua) -> Asset {
   } // phys
   auto mdl = LuaRef{components["model"]};
   if (!mdl.isNil()) {
-    auto shader = mdl["shader"];
+    auto shader   = mdl["shader"];
+    auto occluder = mdl["occluder"];
     reg.assign<Afk::ModelSource>(
         obj.ent, Afk::ModelSource{obj.ent, mdl["path"].cast<std::string>(),
                                   shader.isNil() ? "shader/default.prog"
-                                                 : shader.cast<std::string>()});
+                                                 : shader.cast<std::string>(),
+                                  !occluder.isNil() && occluder.cast<bool>()});
   }
   auto script = LuaRef{components["script"]};
   if (!script.isNil()) {
@@ -120,7 +123,7 @@ auto Afk::Asset::game_asset_factory(const std::filesystem::path &path) -> Asset
   // For the purpose of simplicity and not having to write a new parser, we will simply
   // use a stripped down lua state (no opening libraries)
   // to load our game assets.
-  lua_State *lua = luaL_newstate();
+  lua_State *lua = Afk::Memory::new_lua_state();
   // required for luabridge if not using openlibs
   luaL_requiref(lua, "_G", &luaopen_base, 1);
   lua_pop(lua, 1);
@@ -61,6 +61,7 @@ auto AgentComponent::update() -> void {
     tf.translation.x = agent->npos[0];
     tf.translation.y = agent->npos[1];
     tf.translation.z = agent->npos[2];
+    Afk::Engine::get().render_tree.mark_moved(this->owning_entity);
   }
   // Update the agent goal
   auto next_pos = current_behaviour->update(tf.translation);
@@ -1,6 +1,23 @@
 #include "afk/component/AnimComponent.hpp"
+
+#include <utility>
+
 using Afk::AnimComponent;
 
 AnimComponent::AnimComponent(GameObject _owner, AnimComponent::Status _status,
                              const std::string &_name, float _time)
   : BaseComponent(_owner), status(_status), name(_name), time(_time) {}
+
+auto AnimComponent::play(const std::string &_name, float _fade_time) -> void {
+  this->fading_name = std::move(this->name);
+  this->fading_time = this->time;
+  this->name        = _name;
+  this->time        = 0.0f;
+  this->fade        = _fade_time > 0.0f ? 0.0f : 1.0f;
+  this->fade_time   = _fade_time;
+
+  // The old clip's cache is where it left off, so it moves with it.
+  std::swap(this->sampler.cache, this->sampler.fading_cache);
+  std::swap(this->sampler.clip, this->sampler.fading_clip);
+  std::swap(this->sampler.clip_name, this->sampler.fading_clip_name);
+}
@@ -1,7 +1,13 @@
 #pragma once
+#include <memory>
 #include <string>
 
+#include <ozz/animation/runtime/animation.h>
+#include <ozz/animation/runtime/sampling_job.h>
+
 #include "afk/component/BaseComponent.hpp"
+#include "afk/renderer/Renderer.hpp"
+#include "afk/renderer/Rig.hpp"
 
 namespace Afk {
   /**
@@ -14,8 +20,30 @@ namespace Afk {
      */
     enum class Status { Paused, Playing, Stopped };
 
+    /**
+     * What the animation system keeps between frames to sample an entity
+     */
+    struct Sampler {
+      using Cache = std::unique_ptr<ozz::animation::SamplingCache>;
+
+      Renderer::ModelId model                      = {};
+      std::shared_ptr<const Rig> rig               = {};
+      std::string clip_name                        = {};
+      std::string fading_clip_name                 = {};
+      const ozz::animation::Animation *clip        = nullptr;
+      const ozz::animation::Animation *fading_clip = nullptr;
+      // Keyframes each clip was last sampled at, so sampling resumes there.
+      Cache cache                                  = {};
+      Cache fading_cache                           = {};
+    };
+
     AnimComponent(GameObject _owner, AnimComponent::Status _status,
                   const std::string &_name, float _time);
+    /**
+     * Switch to another animation from its start, blending out of the current
+     * one over a number of seconds
+     */
+    auto play(const std::string &_name, float fade_time = 0.25f) -> void;
     /**
      * Current anim status
      */
@@ -28,5 +56,18 @@ namespace Afk {
      * Animation time
      */
     float time = {};
+    /**
+     * Animation being blended out of, its time, and how far through the fade
+     * is from 0 to 1, where it no longer shows
+     */
+    std::string fading_name = {};
+    float fading_time       = {};
+    float fade              = 1.0f;
+    /**
+     * Seconds the current fade lasts
+     */
+    float fade_time = {};
+
+    Sampler sampler = {};
   };
 }
@@ -2,6 +2,7 @@
 
 #include "afk/component/ScriptsComponent.hpp"
 #include "afk/debug/Assert.hpp"
+#include "afk/debug/Profiler.hpp"
 #include "afk/event/EventManager.hpp"
 #include "afk/io/Path.hpp"
 #include "afk/script/Bindings.hpp"
@@ -13,7 +14,10 @@ using Afk::LuaScript;
 auto LuaScript::register_fn(int event_val, LuaRef func) -> void {
   auto event_type = static_cast<Afk::Event::Type>(event_val);
   this->registered_events->push_back(RegisteredLuaCall{
-      event_type, Afk::EventManager::Callback{std::function<void(Afk::Event)>{func}}});
+      event_type, Afk::EventManager::Callback{[func](Afk::Event event) {
+        afk_profile_zone("Lua callback");
+        func(event);
+      }}});
   auto &evt = this->registered_events->at(this->registered_events->size() - 1);
   event_manager->register_event(event_type, evt.callback);
 }
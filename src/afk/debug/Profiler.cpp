@@ -0,0 +1,160 @@
+#include "afk/debug/Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "afk/debug/Assert.hpp"
+#include "afk/io/Log.hpp"
+#include "afk/io/Path.hpp"
+
+using namespace std::string_literals;
+using Afk::Profiler;
+using std::filesystem::path;
+
+static thread_local void *current_buffer = nullptr;
+
+static auto write_json_string(std::ostream &stream, const std::string &value) -> void {
+  stream << '"';
+
+  for (const auto c : value) {
+    switch (c) {
+      case '"': stream << "\\\""; break;
+      case '\\': stream << "\\\\"; break;
+      case '\n': stream << "\\n"; break;
+      default: stream << c; break;
+    }
+  }
+
+  stream << '"';
+}
+
+auto Profiler::get() -> Profiler & {
+  static auto instance = Profiler{};
+
+  return instance;
+}
+
+auto Profiler::now() -> std::uint64_t {
+  using namespace std::chrono;
+  static const auto start_time = steady_clock::now();
+
+  return static_cast<std::uint64_t>(
+      duration_cast<nanoseconds>(steady_clock::now() - start_time).count());
+}
+
+auto Profiler::record(const char *name, std::uint64_t start, std::uint64_t end) -> void {
+  auto &buffer = this->get_buffer();
+  const auto head = buffer.head.load(std::memory_order_relaxed);
+  auto &entry     = buffer.entries[head & (ZONE_CAPACITY - 1)];
+
+  entry.name.store(name, std::memory_order_relaxed);
+  entry.start.store(start, std::memory_order_relaxed);
+  entry.end.store(end, std::memory_order_relaxed);
+  buffer.head.store(head + 1, std::memory_order_release);
+}
+
+auto Profiler::set_thread_name(const std::string &name) -> void {
+  auto &buffer    = this->get_buffer();
+  const auto lock = std::lock_guard{this->mutex};
+  buffer.name     = name;
+}
+
+auto Profiler::save(const path &file_path) -> void {
+  auto file = std::ofstream{file_path};
+  afk_assert(file.is_open(), "Unable to open trace "s + file_path.string());
+
+  file << std::fixed << std::setprecision(3);
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+  const auto lock = std::lock_guard{this->mutex};
+  auto is_first   = true;
+
+  const auto separate = [&file, &is_first] {
+    if (!is_first) {
+      file << ",\n";
+    }
+    is_first = false;
+  };
+
+  for (const auto &buffer : this->buffers) {
+    const auto name = buffer->name.empty() ? "Thread "s + std::to_string(buffer->id)
+                                           : buffer->name;
+
+    separate();
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->id
+         << ",\"args\":{\"name\":";
+    write_json_string(file, name);
+    file << "}}";
+
+    // The owning thread may still be recording, so anything it overwrites
+    // while we read is dropped below.
+    const auto head  = buffer->head.load(std::memory_order_acquire);
+    const auto first = head > ZONE_CAPACITY ? head - ZONE_CAPACITY : 0;
+
+    struct Zone {
+      const char *name    = nullptr;
+      std::uint64_t start = {};
+      std::uint64_t end   = {};
+    };
+
+    auto zones = std::vector<Zone>{};
+    zones.reserve(static_cast<std::size_t>(head - first));
+
+    for (auto i = first; i < head; ++i) {
+      const auto &entry = buffer->entries[i & (ZONE_CAPACITY - 1)];
+      zones.push_back({entry.name.load(std::memory_order_relaxed),
+                       entry.start.load(std::memory_order_relaxed),
+                       entry.end.load(std::memory_order_relaxed)});
+    }
+
+    // Slots up to and including the one being written now are suspect.
+    const auto new_head    = buffer->head.load(std::memory_order_acquire);
+    const auto overwritten = new_head + 1 > ZONE_CAPACITY ? new_head + 1 - ZONE_CAPACITY : 0;
+    const auto skip        = std::min(static_cast<std::uint64_t>(zones.size()),
+                               overwritten > first ? overwritten - first : 0);
+
+    for (auto i = static_cast<std::size_t>(skip); i < zones.size(); ++i) {
+      const auto &zone = zones[i];
+
+      separate();
+      file << "{\"name\":";
+      write_json_string(file, zone.name);
+      file << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->id
+           << ",\"ts\":" << static_cast<double>(zone.start) / 1000.0
+           << ",\"dur\":" << static_cast<double>(zone.end - zone.start) / 1000.0 << "}";
+    }
+  }
+
+  file << "]}\n";
+}
+
+auto Profiler::save() -> path {
+  const auto time = std::time(nullptr);
+  auto name       = std::ostringstream{};
+  name << std::put_time(std::localtime(&time), "%Y-%m-%d_%H-%M-%S") << ".json";
+
+  const auto dir = Afk::get_absolute_path(".trace");
+  std::filesystem::create_directories(dir);
+
+  const auto file_path = dir / name.str();
+  this->save(file_path);
+  Afk::Io::log << "Saved trace " << file_path.string() << '\n';
+
+  return file_path;
+}
+
+auto Profiler::get_buffer() -> ThreadBuffer & {
+  if (current_buffer == nullptr) {
+    const auto lock = std::lock_guard{this->mutex};
+    auto buffer     = std::make_unique<ThreadBuffer>();
+    buffer->id      = this->buffers.size();
+    current_buffer  = buffer.get();
+    this->buffers.push_back(std::move(buffer));
+  }
+
+  return *static_cast<ThreadBuffer *>(current_buffer);
+}
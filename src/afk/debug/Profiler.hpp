@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define AFK_PROFILE_CONCAT_IMPL(a, b) a##b
+#define AFK_PROFILE_CONCAT(a, b)      AFK_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef AFK_PROFILE
+  #define afk_profile_zone(name)                                               \
+    const auto AFK_PROFILE_CONCAT(afk_profile_zone_, __LINE__) =               \
+        Afk::Profiler::Zone{name}
+  #define afk_profile_thread(name) Afk::Profiler::get().set_thread_name(name)
+#else
+  #define afk_profile_zone(name)   ((void)0)
+  #define afk_profile_thread(name) ((void)0)
+#endif
+
+namespace Afk {
+  /**
+   * Records timed zones into per-thread ring buffers and saves them as a
+   * Chrome trace, viewable in chrome://tracing or Perfetto. Zones are added
+   * with afk_profile_zone and compile to nothing unless AFK_PROFILE is set.
+   */
+  class Profiler {
+  public:
+    /**
+     * Zones kept per thread, older zones are overwritten
+     */
+    static constexpr std::size_t ZONE_CAPACITY = 1 << 16;
+#ifdef AFK_PROFILE
+    static constexpr bool is_enabled = true;
+#else
+    static constexpr bool is_enabled = false;
+#endif
+
+    /**
+     * Times the enclosing scope, the name must outlive the profiler
+     */
+    class Zone {
+    public:
+      explicit Zone(const char *_name);
+      ~Zone();
+      Zone(Zone &&)      = delete;
+      Zone(const Zone &) = delete;
+      auto operator=(const Zone &) -> Zone & = delete;
+      auto operator=(Zone &&) -> Zone & = delete;
+
+    private:
+      const char *name    = nullptr;
+      std::uint64_t start = {};
+    };
+
+    Profiler()                 = default;
+    ~Profiler()                = default;
+    Profiler(Profiler &&)      = delete;
+    Profiler(const Profiler &) = delete;
+    auto operator=(const Profiler &) -> Profiler & = delete;
+    auto operator=(Profiler &&) -> Profiler & = delete;
+
+    static auto get() -> Profiler &;
+    /**
+     * Get the time since startup in nanoseconds
+     */
+    static auto now() -> std::uint64_t;
+    /**
+     * Record a zone on the calling thread
+     */
+    auto record(const char *name, std::uint64_t start, std::uint64_t end) -> void;
+    /**
+     * Name the calling thread in saved traces
+     */
+    auto set_thread_name(const std::string &name) -> void;
+    /**
+     * Save every recorded zone as Chrome trace event JSON
+     */
+    auto save(const std::filesystem::path &file_path) -> void;
+    /**
+     * Save every recorded zone to .trace/<timestamp>.json
+     * \return the path written to
+     */
+    auto save() -> std::filesystem::path;
+
+  private:
+    struct Entry {
+      std::atomic<const char *> name   = {nullptr};
+      std::atomic<std::uint64_t> start = {};
+      std::atomic<std::uint64_t> end   = {};
+    };
+
+    struct ThreadBuffer {
+      std::array<Entry, ZONE_CAPACITY> entries = {};
+      std::atomic<std::uint64_t> head          = {};
+      std::size_t id                           = {};
+      std::string name                         = {};
+    };
+
+    // Buffers are kept after their thread exits so their zones can be saved.
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers = {};
+    std::mutex mutex                                   = {};
+
+    auto get_buffer() -> ThreadBuffer &;
+  };
+}
+
+inline Afk::Profiler::Zone::Zone(const char *_name)
+  : name(_name), start(Profiler::now()) {}
+
+inline Afk::Profiler::Zone::~Zone() {
+  Profiler::get().record(this->name, this->start, Profiler::now());
+}
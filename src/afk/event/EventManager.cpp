@@ -2,17 +2,21 @@
 
 #include "afk/Afk.hpp"
 #include "afk/debug/Assert.hpp"
+#include "afk/debug/Profiler.hpp"
 #include "afk/event/Event.hpp"
 #include "afk/io/Log.hpp"
 
 // Must be included after GLAD.
 #include <algorithm>
+#include <utility>
 
 #include <GLFW/glfw3.h>
 
 using Afk::EventManager;
 using Action = Afk::Event::Action;
 
+static_assert(GLFW_KEY_LAST < EventManager::KEY_COUNT, "GLFW key codes don't fit");
+
 std::size_t EventManager::Callback::index = 0;
 EventManager::Callback::Callback(std::function<void(Afk::Event)> fn)
   : func(fn), id(index++) {}
@@ -25,7 +29,12 @@ auto EventManager::Callback::operator()(const Afk::Event &arg) const -> void {
 
 auto EventManager::initialize(Renderer::Window window) -> void {
   afk_assert(!this->is_initialized, "Event manager already initialized");
-  this->setup_callbacks(window);
+  this->window = window;
+
+  if (this->window != nullptr) {
+    this->setup_callbacks(this->window);
+  }
+
   this->is_initialized = true;
 }
 auto EventManager::pump_render() -> void {
@@ -35,23 +44,70 @@ auto EventManager::pump_render() -> void {
   }
 }
 
+auto EventManager::poll_events() -> void {
+  if (this->window != nullptr) {
+    glfwPollEvents();
+  }
+}
+
 auto EventManager::pump_events() -> void {
-  glfwPollEvents();
-  this->events.push({Event::Update{Afk::Engine::get().get_delta_time()}, Event::Type::Update});
+  afk_profile_zone("EventManager::pump_events");
+  this->events.push_back(
+      {Event::Update{Afk::Engine::get().get_delta_time()}, Event::Type::Update});
+
+  // Anything queued while handling a batch is handled in the next one.
+  while (!this->events.empty()) {
+    std::swap(this->events, this->pumped_events);
+
+    for (const auto &current_event : this->pumped_events) {
+      for (const auto &event_callback : this->callbacks[current_event.type]) {
+        event_callback(current_event);
+      }
+    }
 
-  while (this->events.size() > 0) {
-    const auto &current_event = this->events.front();
+    this->pumped_events.clear();
+  }
+}
 
-    for (const auto &event_callback : this->callbacks[current_event.type]) {
-      event_callback(current_event);
+auto EventManager::queue_event(Event event) -> void {
+  this->events.push_back(event);
+}
+
+auto EventManager::queue_input(const Event &event) -> void {
+  if (event.type == Event::Type::KeyDown || event.type == Event::Type::KeyUp) {
+    const auto key       = std::get<Event::Key>(event.data).key;
+    const auto new_state = event.type == Event::Type::KeyDown;
+
+    if (key >= 0 && static_cast<std::size_t>(key) < this->keys_down.size()) {
+      this->keys_down[static_cast<std::size_t>(key)] = new_state;
     }
 
-    this->events.pop();
+    // FIXME: Move to keyboard manager.
+    switch (key) {
+      case GLFW_KEY_W: this->key_state[Action::Forward] = new_state; break;
+      case GLFW_KEY_A: this->key_state[Action::Left] = new_state; break;
+      case GLFW_KEY_S: this->key_state[Action::Backward] = new_state; break;
+      case GLFW_KEY_D: this->key_state[Action::Right] = new_state; break;
+    }
   }
+
+  this->events.push_back(event);
+  this->frame_input.push_back(event);
 }
 
-auto EventManager::queue_event(Event event) -> void {
-  this->events.push(event);
+auto EventManager::take_frame_input() -> std::vector<Event> {
+  return std::exchange(this->frame_input, {});
+}
+
+auto EventManager::get_is_key_down(int key) const -> bool {
+  return key >= 0 && static_cast<std::size_t>(key) < this->keys_down.size() &&
+         this->keys_down[static_cast<std::size_t>(key)];
+}
+
+auto EventManager::window_input(const Event &event) -> void {
+  if (!this->ignore_window_input) {
+    this->queue_input(event);
+  }
 }
 
 auto EventManager::register_event(Event::Type type, Callback callback) -> void {
@@ -88,41 +144,17 @@ auto EventManager::key_callback([[maybe_unused]] GLFWwindow *window, int key,
     case GLFW_REPEAT: type = Event::Type::KeyRepeat; break;
   }
 
-  afk.event_manager.events.push({Event::Key{key, scancode, control, alt, shift}, type});
-
-  // FIXME: Move to keyboard manager.
-  if (action != GLFW_REPEAT) {
-    auto new_state = false;
-    switch (action) {
-      case GLFW_PRESS: new_state = true; break;
-      case GLFW_RELEASE: new_state = false; break;
-    }
-
-    switch (key) {
-      case GLFW_KEY_W:
-        afk.event_manager.key_state[Action::Forward] = new_state;
-        break;
-      case GLFW_KEY_A:
-        afk.event_manager.key_state[Action::Left] = new_state;
-        break;
-      case GLFW_KEY_S:
-        afk.event_manager.key_state[Action::Backward] = new_state;
-        break;
-      case GLFW_KEY_D:
-        afk.event_manager.key_state[Action::Right] = new_state;
-        break;
-    }
-  }
+  afk.event_manager.window_input({Event::Key{key, scancode, control, alt, shift}, type});
 }
 
 auto EventManager::char_callback([[maybe_unused]] GLFWwindow *window, uint32_t codepoint)
     -> void {
-  Afk::Engine::get().event_manager.events.push({Event::Text{codepoint}, Event::Type::TextEnter});
+  Afk::Engine::get().event_manager.window_input({Event::Text{codepoint}, Event::Type::TextEnter});
 }
 
 auto EventManager::mouse_pos_callback([[maybe_unused]] GLFWwindow *window,
                                       double x, double y) -> void {
-  Afk::Engine::get().event_manager.events.push({Event::MouseMove{x, y}, Event::Type::MouseMove});
+  Afk::Engine::get().event_manager.window_input({Event::MouseMove{x, y}, Event::Type::MouseMove});
 }
 
 auto EventManager::mouse_press_callback([[maybe_unused]] GLFWwindow *window, int button,
@@ -134,12 +166,12 @@ auto EventManager::mouse_press_callback([[maybe_unused]] GLFWwindow *window, int
   const auto shift   = (mods & GLFW_MOD_SHIFT) == GLFW_MOD_SHIFT;
   const auto type = action == GLFW_PRESS ? Event::Type::MouseDown : Event::Type::MouseUp;
 
-  afk.event_manager.events.push({Event::MouseButton{button, control, alt, shift}, type});
+  afk.event_manager.window_input({Event::MouseButton{button, control, alt, shift}, type});
 }
 
 auto EventManager::mouse_scroll_callback([[maybe_unused]] GLFWwindow *window,
                                          double dx, double dy) -> void {
-  Afk::Engine::get().event_manager.events.push(
+  Afk::Engine::get().event_manager.window_input(
       {Event::MouseScroll{dx, dy}, Event::Type::MouseScroll});
 }
 
@@ -1,8 +1,8 @@
 #pragma once
 
+#include <bitset>
 #include <cstdint>
 #include <functional>
-#include <queue>
 #include <unordered_map>
 #include <vector>
 
@@ -14,6 +14,11 @@ struct GLFWwindow;
 namespace Afk {
   class EventManager {
   public:
+    /**
+     * Every key code is below this
+     */
+    static constexpr std::size_t KEY_COUNT = 512;
+
     /**
      * wraps an std::function to make them comparable
      */
@@ -36,13 +41,17 @@ namespace Afk {
     auto operator=(const EventManager &) -> EventManager & = delete;
     auto operator=(EventManager &&) -> EventManager & = delete;
     /**
-     * Init event manager
+     * Init event manager, a null window runs without any window system input
      */
     auto initialize(Renderer::Window window) -> void;
     /**
      * pump render events
      */
     auto pump_render() -> void;
+    /**
+     * poll the window system for input, queuing the resulting events
+     */
+    auto poll_events() -> void;
     /**
      * pump global events (update, keypress, etc)
      */
@@ -51,6 +60,18 @@ namespace Afk {
      * queue event
      */
     auto queue_event(Event event) -> void;
+    /**
+     * queue an input event, tracking which keys are held
+     */
+    auto queue_input(const Event &event) -> void;
+    /**
+     * get every input event queued since the last call
+     */
+    auto take_frame_input() -> std::vector<Event>;
+    /**
+     * check if a key is held, going by the input events queued so far
+     */
+    auto get_is_key_down(int key) const -> bool;
     /**
      * register an event
      */
@@ -72,6 +93,11 @@ namespace Afk {
         {Event::Action::Right, false},
     };
 
+    /**
+     * drop input from the window system, used while replaying a recording
+     */
+    bool ignore_window_input = false;
+
   private:
     static auto key_callback(GLFWwindow *window, int key, int scancode,
                              int action, int mods) -> void;
@@ -82,8 +108,17 @@ namespace Afk {
     static auto mouse_scroll_callback(GLFWwindow *window, double dx, double dy) -> void;
     static auto error_callback(int error, const char *msg) -> void;
 
-    bool is_initialized      = false;
-    std::queue<Event> events = {};
+    auto window_input(const Event &event) -> void;
+
+    bool is_initialized     = false;
+    Renderer::Window window = nullptr;
+    // Two queues swapped while pumping, so handlers can queue more events and
+    // neither has to give back its memory between frames.
+    std::vector<Event> events        = {};
+    std::vector<Event> pumped_events = {};
+
+    std::vector<Event> frame_input   = {};
+    std::bitset<KEY_COUNT> keys_down = {};
 
     std::unordered_map<Event::Type, std::vector<Callback>> callbacks = {
         {Event::Type::MouseDown, {}},   {Event::Type::MouseUp, {}},
@@ -0,0 +1,223 @@
+#include "afk/event/Replay.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "afk/debug/Assert.hpp"
+#include "afk/io/Log.hpp"
+
+using namespace std::string_literals;
+using Afk::Event;
+using Afk::Replay;
+using std::filesystem::path;
+
+constexpr std::uint8_t MODIFIER_CONTROL = 1 << 0;
+constexpr std::uint8_t MODIFIER_ALT     = 1 << 1;
+constexpr std::uint8_t MODIFIER_SHIFT   = 1 << 2;
+
+template<typename T>
+static auto write(std::fstream &file, const T &value) -> void {
+  static_assert(std::is_trivially_copyable_v<T>);
+  file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template<typename T>
+static auto read(std::fstream &file) -> T {
+  static_assert(std::is_trivially_copyable_v<T>);
+  auto value = T{};
+  file.read(reinterpret_cast<char *>(&value), sizeof(T));
+  return value;
+}
+
+static auto pack_modifiers(bool control, bool alt, bool shift) -> std::uint8_t {
+  return static_cast<std::uint8_t>((control ? MODIFIER_CONTROL : 0) |
+                                   (alt ? MODIFIER_ALT : 0) | (shift ? MODIFIER_SHIFT : 0));
+}
+
+static auto write_event(std::fstream &file, const Event &event) -> void {
+  write(file, static_cast<std::uint8_t>(event.type));
+
+  switch (event.type) {
+    case Event::Type::MouseMove: {
+      const auto &data = std::get<Event::MouseMove>(event.data);
+      write(file, data.x);
+      write(file, data.y);
+      break;
+    }
+    case Event::Type::MouseScroll: {
+      const auto &data = std::get<Event::MouseScroll>(event.data);
+      write(file, data.x);
+      write(file, data.y);
+      break;
+    }
+    case Event::Type::MouseDown:
+    case Event::Type::MouseUp: {
+      const auto &data = std::get<Event::MouseButton>(event.data);
+      write(file, static_cast<std::int32_t>(data.button));
+      write(file, pack_modifiers(data.control, data.alt, data.shift));
+      break;
+    }
+    case Event::Type::KeyDown:
+    case Event::Type::KeyUp:
+    case Event::Type::KeyRepeat: {
+      const auto &data = std::get<Event::Key>(event.data);
+      write(file, static_cast<std::int32_t>(data.key));
+      write(file, static_cast<std::int32_t>(data.scancode));
+      write(file, pack_modifiers(data.control, data.alt, data.shift));
+      break;
+    }
+    case Event::Type::TextEnter: {
+      write(file, std::get<Event::Text>(event.data).codepoint);
+      break;
+    }
+    default: afk_unreachable();
+  }
+}
+
+static auto read_event(std::fstream &file) -> Event {
+  auto event = Event{};
+  event.type = static_cast<Event::Type>(read<std::uint8_t>(file));
+
+  switch (event.type) {
+    case Event::Type::MouseMove: {
+      const auto x = read<double>(file);
+      const auto y = read<double>(file);
+      event.data   = Event::MouseMove{x, y};
+      break;
+    }
+    case Event::Type::MouseScroll: {
+      const auto x = read<double>(file);
+      const auto y = read<double>(file);
+      event.data   = Event::MouseScroll{x, y};
+      break;
+    }
+    case Event::Type::MouseDown:
+    case Event::Type::MouseUp: {
+      const auto button    = read<std::int32_t>(file);
+      const auto modifiers = read<std::uint8_t>(file);
+      event.data           = Event::MouseButton{button, (modifiers & MODIFIER_CONTROL) != 0,
+                                      (modifiers & MODIFIER_ALT) != 0, (modifiers & MODIFIER_SHIFT) != 0};
+      break;
+    }
+    case Event::Type::KeyDown:
+    case Event::Type::KeyUp:
+    case Event::Type::KeyRepeat: {
+      const auto key       = read<std::int32_t>(file);
+      const auto scancode  = read<std::int32_t>(file);
+      const auto modifiers = read<std::uint8_t>(file);
+      event.data = Event::Key{key, scancode, (modifiers & MODIFIER_CONTROL) != 0,
+                              (modifiers & MODIFIER_ALT) != 0, (modifiers & MODIFIER_SHIFT) != 0};
+      break;
+    }
+    case Event::Type::TextEnter: {
+      event.data = Event::Text{read<std::uint32_t>(file)};
+      break;
+    }
+    default: afk_assert(false, "Corrupt replay event"); break;
+  }
+
+  return event;
+}
+
+auto Replay::record(const path &file_path, std::uint64_t seed) -> void {
+  afk_assert(this->mode == Mode::None, "Replay already open");
+
+  this->file.open(file_path, std::ios::out | std::ios::binary | std::ios::trunc);
+  afk_assert(this->file.is_open(), "Unable to open "s + file_path.string() + " for recording"s);
+
+  this->file.write(MAGIC, sizeof(MAGIC));
+  write(this->file, VERSION);
+  write(this->file, seed);
+
+  this->mode = Mode::Record;
+  Afk::Io::log << "Recording to " << file_path.string() << '\n';
+}
+
+auto Replay::play(const path &file_path) -> std::uint64_t {
+  afk_assert(this->mode == Mode::None, "Replay already open");
+
+  this->file.open(file_path, std::ios::in | std::ios::binary);
+  afk_assert(this->file.is_open(), "Unable to open replay "s + file_path.string());
+
+  char magic[sizeof(MAGIC)] = {};
+  this->file.read(magic, sizeof(magic));
+  afk_assert(std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0,
+             file_path.string() + " is not a replay"s);
+
+  const auto version = read<std::uint32_t>(this->file);
+  afk_assert(version == VERSION, "Unsupported replay version "s + std::to_string(version));
+
+  const auto seed = read<std::uint64_t>(this->file);
+  afk_assert(this->file.good(), "Truncated replay "s + file_path.string());
+
+  this->mode = Mode::Play;
+  Afk::Io::log << "Replaying " << file_path.string() << '\n';
+
+  return seed;
+}
+
+auto Replay::write_frame(const Frame &frame) -> void {
+  afk_assert_debug(this->mode == Mode::Record, "Replay isn't recording");
+
+  write(this->file, frame.frame_time);
+  write(this->file, frame.seed);
+  write(this->file, static_cast<std::uint32_t>(frame.events.size()));
+
+  for (const auto &event : frame.events) {
+    write_event(this->file, event);
+  }
+}
+
+auto Replay::read_frame(Frame &frame) -> bool {
+  afk_assert_debug(this->mode == Mode::Play, "Replay isn't playing");
+
+  frame.frame_time = read<float>(this->file);
+  frame.seed       = read<std::uint64_t>(this->file);
+  const auto count = read<std::uint32_t>(this->file);
+
+  frame.events.clear();
+
+  for (auto i = std::uint32_t{0}; i < count && this->file.good(); ++i) {
+    frame.events.push_back(read_event(this->file));
+  }
+
+  // A partly written final frame, from a recording that was killed, just
+  // ends the replay.
+  return this->file.good();
+}
+
+auto Replay::add_frame_time(float frame_time) -> void {
+  this->frame_times.push_back(frame_time);
+}
+
+auto Replay::log_frame_times() const -> void {
+  if (this->frame_times.empty()) {
+    return;
+  }
+
+  auto sorted = this->frame_times;
+  std::sort(sorted.begin(), sorted.end());
+
+  // Nearest rank, in milliseconds.
+  const auto percentile = [&sorted](float p) {
+    const auto rank = static_cast<std::size_t>(std::ceil(p * static_cast<float>(sorted.size())));
+    return sorted[std::max(rank, std::size_t{1}) - 1] * 1000.0f;
+  };
+
+  auto total = 0.0f;
+  for (const auto frame_time : sorted) {
+    total += frame_time;
+  }
+
+  Afk::Io::log << "Replayed " << sorted.size() << " frames, mean "
+               << total / static_cast<float>(sorted.size()) * 1000.0f << " ms, p50 "
+               << percentile(0.5f) << " ms, p95 " << percentile(0.95f) << " ms, p99 "
+               << percentile(0.99f) << " ms, max " << sorted.back() * 1000.0f << " ms\n";
+}
+
+auto Replay::get_mode() const -> Mode {
+  return this->mode;
+}
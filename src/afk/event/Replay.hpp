@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "afk/event/Event.hpp"
+
+namespace Afk {
+  /**
+   * Records or plays back everything that makes a run nondeterministic: the
+   * input events, frame time and random seed of every frame.
+   *
+   * The file is a header (magic, version, seed) followed by one record per
+   * frame (frame time, frame seed, event count, events). Each event is a type
+   * byte plus only the fields that type uses.
+   */
+  class Replay {
+  public:
+    static constexpr char MAGIC[4]         = {'A', 'F', 'K', 'R'};
+    static constexpr std::uint32_t VERSION = 1;
+
+    enum class Mode { None, Record, Play };
+
+    /**
+     * Everything needed to repeat a frame
+     */
+    struct Frame {
+      float frame_time          = {};
+      std::uint64_t seed        = {};
+      std::vector<Event> events = {};
+    };
+
+    /**
+     * Start recording to a file
+     * \param seed the seed the run starts from
+     */
+    auto record(const std::filesystem::path &file_path, std::uint64_t seed) -> void;
+    /**
+     * Start playing a recording
+     * \return the seed the recorded run started from
+     */
+    auto play(const std::filesystem::path &file_path) -> std::uint64_t;
+    /**
+     * Append a frame to the recording
+     */
+    auto write_frame(const Frame &frame) -> void;
+    /**
+     * Read the next frame of the recording
+     * \return false once the recording has ended
+     */
+    auto read_frame(Frame &frame) -> bool;
+    /**
+     * Note how long a replayed frame actually took
+     */
+    auto add_frame_time(float frame_time) -> void;
+    /**
+     * Log the distribution of replayed frame times
+     */
+    auto log_frame_times() const -> void;
+    auto get_mode() const -> Mode;
+
+  private:
+    Mode mode                      = Mode::None;
+    std::fstream file              = {};
+    std::vector<float> frame_times = {};
+  };
+}
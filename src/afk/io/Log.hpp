@@ -3,10 +3,13 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <sstream>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
 
 #include "afk/Afk.hpp"
 #include "afk/io/Path.hpp"
+#include "afk/memory/FrameArena.hpp"
 #include "afk/ui/Log.hpp"
 
 namespace Afk {
@@ -17,9 +20,36 @@ namespace Afk {
     struct Log {
       std::filesystem::path log_path = {};
       std::ofstream log_file         = {};
+      /**
+       * Held while writing, so workers can log too
+       */
+      std::mutex mutex = {};
 
       Log();
     };
+    /**
+     * Stream buffer appending to a string
+     */
+    class StringBuffer : public std::streambuf {
+    public:
+      explicit StringBuffer(Memory::FrameString *_string) : string(_string) {}
+
+    protected:
+      auto overflow(int_type c) -> int_type override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+          this->string->push_back(traits_type::to_char_type(c));
+        }
+
+        return traits_type::not_eof(c);
+      }
+      auto xsputn(const char *data, std::streamsize count) -> std::streamsize override {
+        this->string->append(data, static_cast<std::size_t>(count));
+        return count;
+      }
+
+    private:
+      Memory::FrameString *string = nullptr;
+    };
     /**
      * Log things
      * \param value thing to log
@@ -27,13 +57,17 @@ namespace Afk {
      */
     template<typename T>
     auto operator<<(Log &log, T const &value) -> Log & {
-      using std::ostringstream;
-
       auto &afk = Engine::get();
-      auto ss   = ostringstream{};
 
-      ss << value;
-      afk.ui.log.append("%s", ss.str().c_str());
+      // Format into frame memory rather than a new string stream every call.
+      auto text   = Memory::FrameString{Memory::FrameAllocator<char>{&afk.frame_arena}};
+      auto buffer = StringBuffer{&text};
+      auto stream = std::ostream{&buffer};
+
+      stream << value;
+
+      const auto lock = std::lock_guard{log.mutex};
+      afk.ui.log.append("%s", text.c_str());
       log.log_file << value;
       std::cout << value;
 
@@ -4,6 +4,7 @@
 #include <filesystem>
 #include <fstream>
 #include <iterator>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -16,14 +17,25 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-
+#include <ozz/animation/offline/animation_builder.h>
+#include <ozz/animation/offline/raw_animation.h>
+#include <ozz/animation/offline/raw_skeleton.h>
+#include <ozz/animation/offline/skeleton_builder.h>
+#include <ozz/base/maths/simd_math.h>
+#include <ozz/base/maths/transform.h>
+
+#include "afk/Afk.hpp"
 #include "afk/debug/Assert.hpp"
 #include "afk/io/Log.hpp"
 #include "afk/io/Path.hpp"
+#include "afk/memory/MemoryTracker.hpp"
 #include "afk/physics/Transform.hpp"
 #include "afk/renderer/Animation.hpp"
 #include "afk/renderer/Mesh.hpp"
+#include "afk/renderer/MeshOptimizer.hpp"
+#include "afk/renderer/MeshSimplifier.hpp"
 #include "afk/renderer/Model.hpp"
+#include "afk/renderer/Rig.hpp"
 #include "afk/renderer/Texture.hpp"
 
 using namespace std::string_literals;
@@ -32,13 +44,16 @@ using glm::quat;
 using glm::vec2;
 using glm::vec3;
 using std::pair;
+using std::shared_ptr;
 using std::string;
 using std::unordered_map;
 using std::vector;
 using std::filesystem::path;
 
 using Afk::Animation;
+using Afk::MeshOptimization;
 using Afk::ModelLoader;
+using Afk::Rig;
 using Afk::Texture;
 using Afk::Transform;
 namespace Io = Afk::Io;
@@ -48,6 +63,14 @@ constexpr unsigned ASSIMP_OPTIONS =
     aiProcess_JoinIdenticalVertices | aiProcess_CalcTangentSpace |
     aiProcess_GlobalScale | aiProcess_LimitBoneWeights;
 
+using ozz::animation::offline::AnimationBuilder;
+using ozz::animation::offline::RawAnimation;
+using ozz::animation::offline::RawSkeleton;
+using ozz::animation::offline::SkeletonBuilder;
+
+// Assimp leaves the tick rate at zero when the file doesn't say.
+constexpr auto DEFAULT_TICKS_PER_SECOND = 25.0;
+
 constexpr auto assimp_texture_types =
     frozen::make_unordered_map<Texture::Type, aiTextureType>({
         {Texture::Type::Diffuse, aiTextureType_DIFFUSE},
@@ -71,8 +94,72 @@ static auto to_glm(aiQuaterniont<float> q) -> quat {
   return quat{q.w, q.x, q.y, q.z};
 }
 
+static auto to_ozz(aiVector3t<float> v) -> ozz::math::Float3 {
+  return ozz::math::Float3{v.x, v.y, v.z};
+}
+
+static auto to_ozz(aiQuaterniont<float> q) -> ozz::math::Quaternion {
+  return ozz::math::Quaternion{q.x, q.y, q.z, q.w};
+}
+
+static auto to_ozz(const mat4 &m) -> ozz::math::Float4x4 {
+  auto matrix = ozz::math::Float4x4{};
+
+  for (auto column = 0; column < 4; ++column) {
+    matrix.cols[column] = ozz::math::simd_float4::LoadPtrU(&m[column][0]);
+  }
+
+  return matrix;
+}
+
+/**
+ * Add a node and every node below it to a skeleton, keeping each node's
+ * transform as the rest pose of joints no animation moves
+ */
+static auto add_joint(const aiNode *node, RawSkeleton::Joint &joint,
+                      unordered_map<string, ozz::math::Transform> &rest_poses) -> void {
+  auto scale       = aiVector3t<float>{};
+  auto rotation    = aiQuaterniont<float>{};
+  auto translation = aiVector3t<float>{};
+  node->mTransformation.Decompose(scale, rotation, translation);
+
+  joint.name                  = node->mName.C_Str();
+  joint.transform.translation = to_ozz(translation);
+  joint.transform.rotation    = to_ozz(rotation);
+  joint.transform.scale       = to_ozz(scale);
+  rest_poses.emplace(node->mName.C_Str(), joint.transform);
+
+  joint.children.resize(node->mNumChildren);
+
+  for (auto i = size_t{0}; i < node->mNumChildren; ++i) {
+    add_joint(node->mChildren[i], joint.children[i], rest_poses);
+  }
+}
+
+/**
+ * Convert assimp keys in ticks to ozz keys in seconds, dropping any that
+ * aren't after the last, which ozz rejects
+ */
+template<typename Key, typename AssimpKey>
+static auto add_keys(const AssimpKey *keys, size_t count, double ticks_per_second,
+                     float duration, ozz::vector<Key> &track) -> void {
+  track.reserve(count);
+
+  for (auto i = size_t{0}; i < count; ++i) {
+    const auto time =
+        std::min(static_cast<float>(keys[i].mTime / ticks_per_second), duration);
+
+    if (!track.empty() && time <= track.back().time) {
+      continue;
+    }
+
+    track.push_back({time, to_ozz(keys[i].mValue)});
+  }
+}
+
 auto ModelLoader::load(const path &file_path) -> Model {
-  const auto abs_path = Afk::get_absolute_path(file_path);
+  const auto memory_tag = Afk::Memory::TagScope{Afk::Memory::Tag::Models};
+  const auto abs_path   = Afk::get_absolute_path(file_path);
   auto importer       = Assimp::Importer{};
 
   this->model.file_path = file_path;
@@ -86,9 +173,41 @@ auto ModelLoader::load(const path &file_path) -> Model {
   afk_assert(scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || scene->mRootNode,
              "Model load error: "s + importer.GetErrorString());
 
-  this->model.meshes.reserve(scene->mNumMeshes);
+  this->mesh_nodes.reserve(scene->mNumMeshes);
   this->process_node(scene, scene->mRootNode, to_glm(scene->mRootNode->mTransformation));
+
+  // Meshes only read the scene, so convert them all in parallel.
+  this->model.meshes.resize(this->mesh_nodes.size());
+  this->optimizations.assign(this->mesh_nodes.size(), MeshOptimization{});
+  Afk::Engine::get().job_system.parallel_for(0, this->mesh_nodes.size(), [this, scene](size_t i) {
+    const auto memory_tag         = Afk::Memory::TagScope{Afk::Memory::Tag::Models};
+    const auto &[mesh, transform] = this->mesh_nodes[i];
+    this->model.meshes[i] = this->process_mesh(scene, mesh, transform, this->optimizations[i]);
+  });
+  this->mesh_nodes.clear();
+
+  if (this->optimize_meshes && !this->optimizations.empty()) {
+    auto before = Afk::VertexCacheStats{};
+    auto after  = Afk::VertexCacheStats{};
+
+    for (const auto &optimization : this->optimizations) {
+      before.transformed += optimization.before.transformed;
+      before.triangles += optimization.before.triangles;
+      before.vertices += optimization.before.vertices;
+      after.transformed += optimization.after.transformed;
+      after.triangles += optimization.after.triangles;
+      after.vertices += optimization.after.vertices;
+    }
+
+    Io::log << "Optimised model '" << file_path.string() << "': ACMR " << before.get_acmr()
+            << " -> " << after.get_acmr() << ", ATVR " << before.get_atvr() << " -> "
+            << after.get_atvr() << ".\n";
+  }
+
+  this->optimizations.clear();
+
   this->model.animations = this->get_animations(scene);
+  this->model.rig        = this->get_rig(scene);
 
   return std::move(this->model);
 }
@@ -99,8 +218,7 @@ auto ModelLoader::process_node(const aiScene *scene, const aiNode *node,
   for (auto i = size_t{0}; i < node->mNumMeshes; ++i) {
     const auto *mesh = scene->mMeshes[node->mMeshes[i]];
 
-    this->model.meshes.push_back(
-        this->process_mesh(scene, mesh, transform * to_glm(node->mTransformation)));
+    this->mesh_nodes.emplace_back(mesh, transform * to_glm(node->mTransformation));
   }
 
   // Process all child nodes.
@@ -109,8 +227,8 @@ auto ModelLoader::process_node(const aiScene *scene, const aiNode *node,
   }
 }
 
-auto ModelLoader::process_mesh(const aiScene *scene, const aiMesh *mesh, mat4 transform)
-    -> Mesh {
+auto ModelLoader::process_mesh(const aiScene *scene, const aiMesh *mesh, mat4 transform,
+                               MeshOptimization &optimization) -> Mesh {
   auto new_mesh = Mesh{};
 
   new_mesh.vertices = this->get_vertices(mesh);
@@ -122,6 +240,13 @@ auto ModelLoader::process_mesh(const aiScene *scene, const aiMesh *mesh, mat4 tr
   new_mesh.bone_map      = std::move(bone_map);
 
   new_mesh.transform = transform;
+  new_mesh.update_bounds();
+  Afk::generate_lods(new_mesh);
+
+  // Levels of detail share the vertices, so are reordered with them.
+  if (this->optimize_meshes) {
+    optimization = Afk::optimize_mesh(new_mesh);
+  }
 
   return new_mesh;
 }
@@ -239,6 +364,118 @@ auto ModelLoader::get_animations(const aiScene *scene) -> Model::Animations {
   return animations;
 }
 
+auto ModelLoader::get_rig(const aiScene *scene) const -> shared_ptr<const Rig> {
+  const auto &meshes   = this->model.meshes;
+  const auto has_bones = std::any_of(meshes.begin(), meshes.end(),
+                                     [](const Mesh &mesh) { return !mesh.bones.empty(); });
+
+  if (!has_bones || scene->mNumAnimations == 0) {
+    return nullptr;
+  }
+
+  // Every node is a joint, bones and animations only name some of them.
+  auto raw_skeleton = RawSkeleton{};
+  auto rest_poses   = unordered_map<string, ozz::math::Transform>{};
+  raw_skeleton.roots.resize(1);
+  add_joint(scene->mRootNode, raw_skeleton.roots[0], rest_poses);
+
+  auto rig      = std::make_shared<Rig>();
+  rig->skeleton = SkeletonBuilder{}(raw_skeleton);
+
+  if (rig->skeleton == nullptr) {
+    Io::log << "Model '" << this->model.file_path.string()
+            << "' has too many nodes to animate.\n";
+    return nullptr;
+  }
+
+  // The builder picks the joint order, so find joints by name.
+  const auto num_joints  = static_cast<size_t>(rig->skeleton->num_joints());
+  const auto joint_names = rig->skeleton->joint_names();
+  auto joints            = unordered_map<string, int>{};
+
+  for (auto i = size_t{0}; i < num_joints; ++i) {
+    joints.emplace(joint_names[i], static_cast<int>(i));
+  }
+
+  for (auto i = size_t{0}; i < scene->mNumAnimations; ++i) {
+    const auto &assimp_animation = *scene->mAnimations[i];
+    const auto ticks_per_second  = assimp_animation.mTicksPerSecond > 0.0
+                                       ? assimp_animation.mTicksPerSecond
+                                       : DEFAULT_TICKS_PER_SECOND;
+
+    auto raw_animation     = RawAnimation{};
+    raw_animation.name     = assimp_animation.mName.C_Str();
+    raw_animation.duration = static_cast<float>(assimp_animation.mDuration / ticks_per_second);
+    raw_animation.tracks.resize(num_joints);
+
+    for (auto j = size_t{0}; j < assimp_animation.mNumChannels; ++j) {
+      const auto &channel = *assimp_animation.mChannels[j];
+      const auto joint    = joints.find(channel.mNodeName.C_Str());
+
+      if (joint == joints.end()) {
+        continue;
+      }
+
+      auto &track = raw_animation.tracks[static_cast<size_t>(joint->second)];
+      add_keys(channel.mPositionKeys, channel.mNumPositionKeys, ticks_per_second,
+               raw_animation.duration, track.translations);
+      add_keys(channel.mRotationKeys, channel.mNumRotationKeys, ticks_per_second,
+               raw_animation.duration, track.rotations);
+      add_keys(channel.mScalingKeys, channel.mNumScalingKeys, ticks_per_second,
+               raw_animation.duration, track.scales);
+    }
+
+    // Anything the animation doesn't key holds its rest pose.
+    for (auto j = size_t{0}; j < num_joints; ++j) {
+      const auto &rest_pose = rest_poses.at(joint_names[j]);
+      auto &track           = raw_animation.tracks[j];
+
+      if (track.translations.empty()) {
+        track.translations.push_back({0.0f, rest_pose.translation});
+      }
+
+      if (track.rotations.empty()) {
+        track.rotations.push_back({0.0f, rest_pose.rotation});
+      }
+
+      if (track.scales.empty()) {
+        track.scales.push_back({0.0f, rest_pose.scale});
+      }
+    }
+
+    auto clip      = Rig::Clip{};
+    clip.name      = assimp_animation.mName.C_Str();
+    clip.animation = AnimationBuilder{}(raw_animation);
+
+    if (clip.animation == nullptr) {
+      Io::log << "Failed to convert animation " << clip.name << ".\n";
+      continue;
+    }
+
+    rig->clips.push_back(std::move(clip));
+  }
+
+  // Skinning matrices are laid out mesh by mesh, bone by bone.
+  for (auto i = size_t{0}; i < meshes.size(); ++i) {
+    const auto &mesh = meshes[i];
+    rig->mesh_inverses.push_back(to_ozz(glm::inverse(mesh.transform.get_matrix())));
+
+    for (const auto &bone : mesh.bones) {
+      const auto joint = joints.find(bone.name);
+
+      afk_assert_debug(joint != joints.end(), "Bone "s + bone.name + " has no node"s);
+
+      rig->bones.push_back({joint != joints.end() ? joint->second : 0,
+                            static_cast<std::uint32_t>(i), to_ozz(bone.offset)});
+    }
+  }
+
+  Io::log << "Rigged model '" << this->model.file_path.string() << "' with " << num_joints
+          << " joints and " << rig->clips.size() << " animations.\n";
+
+  return rig;
+}
+
 auto ModelLoader::get_material_textures(const aiMaterial *material, Texture::Type type)
     -> Mesh::Textures {
   auto textures = Mesh::Textures{};
@@ -1,32 +1,53 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
+#include "afk/renderer/MeshOptimizer.hpp"
 #include "afk/renderer/Model.hpp"
+#include "afk/renderer/Rig.hpp"
 #include "afk/renderer/Texture.hpp"
 
 namespace Afk {
   class ModelLoader {
   public:
     Model model = {};
+    /**
+     * Whether to reorder meshes for the vertex cache, overdraw and vertex
+     * fetching, which benchmarks turn off to time it themselves
+     */
+    bool optimize_meshes = true;
     /**
      * Load a model
      */
     auto load(const std::filesystem::path &file_path) -> Model;
 
   private:
+    // Meshes found while walking the node tree, with their node transforms.
+    std::vector<std::pair<const aiMesh *, glm::mat4>> mesh_nodes = {};
+    // What optimising each mesh did to its vertex cache use.
+    std::vector<MeshOptimization> optimizations = {};
+
     auto process_node(const aiScene *scene, const aiNode *node, glm::mat4 transform) -> void;
-    auto process_mesh(const aiScene *scene, const aiMesh *mesh, glm::mat4 transform) -> Mesh;
+    auto process_mesh(const aiScene *scene, const aiMesh *mesh, glm::mat4 transform,
+                      MeshOptimization &optimization) -> Mesh;
     auto get_vertices(const aiMesh *mesh) -> Mesh::Vertices;
     auto get_indices(const aiMesh *mesh) -> Mesh::Indices;
     auto get_textures(const aiMaterial *material) -> Mesh::Textures;
     auto get_bones(const aiMesh *mesh, Mesh::Vertices &vertices)
         -> std::pair<Mesh::Bones, Mesh::BoneMap>;
     auto get_animations(const aiScene *scene) -> Model::Animations;
+    /**
+     * Convert the node tree to a skeleton and the animations to clips, once
+     * the meshes and their bones are loaded
+     */
+    auto get_rig(const aiScene *scene) const -> std::shared_ptr<const Rig>;
     auto get_material_textures(const aiMaterial *material, Texture::Type type)
         -> Mesh::Textures;
     auto get_texture_path(const std::filesystem::path &file_path) const
@@ -1,8 +1,63 @@
 #include "ModelSource.hpp"
 
-Afk::ModelSource::ModelSource(GameObject e, const std::filesystem::path &name_,
-                              const std::filesystem::path &shader_path) {
-  this->owning_entity = e;
-  this->name          = name_;
+#include "afk/Afk.hpp"
+
+using Afk::ModelSource;
+
+ModelSource::ModelSource(GameObject e, const std::filesystem::path &name_,
+                         const std::filesystem::path &shader_path, bool _is_occluder) {
+  auto &renderer = Afk::Engine::get().renderer;
+
+  this->owning_entity       = e;
+  this->name                = name_;
   this->shader_program_path = shader_path;
+  this->is_occluder         = _is_occluder;
+  this->model_id            = renderer.resolve_model(this->name);
+  this->shader_program_id   = renderer.resolve_shader_program(this->shader_program_path);
+
+  if (this->is_occluder) {
+    renderer.mark_occluder(this->name);
+  }
+
+  // Scripts may create models on the simulation worker, away from the GL
+  // thread, so the model is imported and uploaded from there.
+  renderer.request_model(this->name);
+
+  Afk::Engine::get().render_tree.add(e);
+}
+
+auto ModelSource::get_name() const -> const std::filesystem::path & {
+  return this->name;
+}
+
+auto ModelSource::set_name(const std::filesystem::path &name_) -> void {
+  auto &renderer = Afk::Engine::get().renderer;
+
+  this->name     = name_;
+  this->model_id = renderer.resolve_model(this->name);
+
+  if (this->is_occluder) {
+    renderer.mark_occluder(this->name);
+  }
+
+  renderer.request_model(this->name);
+
+  // The new model has different bounds.
+  Afk::Engine::get().render_tree.mark_moved(this->owning_entity);
+}
+
+auto ModelSource::get_shader_program_path() const -> const std::filesystem::path & {
+  return this->shader_program_path;
+}
+
+auto ModelSource::get_model_id() const -> Renderer::ModelId {
+  return this->model_id;
+}
+
+auto ModelSource::get_shader_program_id() const -> Renderer::ShaderProgramId {
+  return this->shader_program_id;
+}
+
+auto ModelSource::get_is_occluder() const -> bool {
+  return this->is_occluder;
 }
@@ -4,22 +4,42 @@
 #include <string>
 
 #include "afk/component/BaseComponent.hpp"
+#include "afk/renderer/Renderer.hpp"
 
 namespace Afk {
   class ModelSource : public BaseComponent {
   public:
     /**
-     * Model component
+     * Model component, resolving its paths to renderer IDs once so drawing
+     * doesn't look paths up every frame
+     * \param _is_occluder whether the model is large and solid enough to hide
+     * what is behind it from drawing, like a building
      */
     ModelSource(GameObject e, const std::filesystem::path &name_,
-                const std::filesystem::path &shader_path);
+                const std::filesystem::path &shader_path, bool _is_occluder = false);
+
+    auto get_name() const -> const std::filesystem::path &;
+    /**
+     * Change the model drawn
+     */
+    auto set_name(const std::filesystem::path &name_) -> void;
+    auto get_shader_program_path() const -> const std::filesystem::path &;
+    auto get_model_id() const -> Renderer::ModelId;
+    auto get_shader_program_id() const -> Renderer::ShaderProgramId;
+    auto get_is_occluder() const -> bool;
+
+  private:
     /**
      * Model path
      */
-    std::filesystem::path name;
+    std::filesystem::path name = {};
     /**
      * Shader path
      */
-    std::filesystem::path shader_program_path;
+    std::filesystem::path shader_program_path = {};
+
+    Renderer::ModelId model_id                  = {};
+    Renderer::ShaderProgramId shader_program_id = {};
+    bool is_occluder                            = false;
   };
 }
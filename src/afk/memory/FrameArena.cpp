@@ -0,0 +1,110 @@
+#include "afk/memory/FrameArena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+#include "afk/debug/Assert.hpp"
+
+using Afk::Memory::FrameArena;
+
+static auto align_up(std::uintptr_t address, std::size_t alignment) -> std::uintptr_t {
+  return (address + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+}
+
+FrameArena::FrameArena(std::size_t capacity) {
+  afk_assert(capacity > 0, "Frame arena needs some capacity");
+
+  for (auto &buffer : this->buffers) {
+    buffer.data     = std::make_unique<std::byte[]>(capacity);
+    buffer.capacity = capacity;
+  }
+}
+
+FrameArena::~FrameArena() {
+  for (auto &buffer : this->buffers) {
+    this->release_overflow(buffer);
+  }
+}
+
+auto FrameArena::allocate(std::size_t size, std::size_t alignment) -> void * {
+  afk_assert_debug(alignment > 0 && (alignment & (alignment - 1)) == 0,
+                   "Alignment must be a power of two");
+
+  auto &buffer    = this->buffers[this->current.load(std::memory_order_acquire)];
+  const auto base = reinterpret_cast<std::uintptr_t>(buffer.data.get());
+  auto used       = buffer.used.load(std::memory_order_relaxed);
+  auto start      = std::size_t{};
+
+  // Claim the next aligned range, other threads may be bumping at the same time.
+  do {
+    start = static_cast<std::size_t>(align_up(base + used, alignment) - base);
+
+    if (start + size > buffer.capacity) {
+      // Out of room, fall back to the heap until the buffer grows at the end
+      // of the frame.
+      auto *data      = ::operator new(size, std::align_val_t{alignment});
+      const auto lock = std::lock_guard{this->overflow_mutex};
+      buffer.overflow.push_back({data, alignment});
+      buffer.overflow_bytes += size;
+
+      return data;
+    }
+  } while (!buffer.used.compare_exchange_weak(used, start + size, std::memory_order_relaxed));
+
+  return buffer.data.get() + start;
+}
+
+auto FrameArena::reset() -> void {
+  const auto index  = this->current.load(std::memory_order_relaxed);
+  const auto &ended = this->buffers[index];
+  auto &next        = this->buffers[1 - index];
+
+  {
+    const auto lock           = std::lock_guard{this->overflow_mutex};
+    this->last_bytes_used     = ended.used + ended.overflow_bytes;
+    this->last_overflow_bytes = ended.overflow_bytes;
+  }
+
+  // Grow the buffer being recycled so neither of the last two frames would
+  // have overflowed it.
+  const auto needed = std::max(this->last_bytes_used, next.used + next.overflow_bytes);
+
+  if (needed > next.capacity) {
+    auto capacity = next.capacity;
+
+    while (capacity < needed) {
+      capacity *= 2;
+    }
+
+    next.data     = std::make_unique<std::byte[]>(capacity);
+    next.capacity = capacity;
+  }
+
+  this->release_overflow(next);
+  next.used = 0;
+  this->current.store(1 - index, std::memory_order_release);
+}
+
+auto FrameArena::get_bytes_used() const -> std::size_t {
+  return this->last_bytes_used;
+}
+
+auto FrameArena::get_overflow_bytes() const -> std::size_t {
+  return this->last_overflow_bytes;
+}
+
+auto FrameArena::get_capacity() const -> std::size_t {
+  return std::min(this->buffers[0].capacity, this->buffers[1].capacity);
+}
+
+auto FrameArena::release_overflow(Buffer &buffer) -> void {
+  const auto lock = std::lock_guard{this->overflow_mutex};
+
+  for (const auto &overflow : buffer.overflow) {
+    ::operator delete(overflow.data, std::align_val_t{overflow.alignment});
+  }
+
+  buffer.overflow.clear();
+  buffer.overflow_bytes = 0;
+}
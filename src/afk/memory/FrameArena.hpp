@@ -0,0 +1,155 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Afk {
+  namespace Memory {
+    /**
+     * Linear allocator for data that only lives for a frame or two. Allocating
+     * is a pointer bump, freeing is a no-op, and everything is released at
+     * once when the frame ends.
+     *
+     * The arena is double buffered, so memory allocated during a frame stays
+     * valid until the end of the following frame. That lets the renderer draw
+     * a frame packet built during the previous frame.
+     */
+    class FrameArena {
+    public:
+      /**
+       * Bytes each buffer starts with, they grow to fit the busiest frame
+       */
+      static constexpr std::size_t DEFAULT_CAPACITY = std::size_t{1} << 20;
+
+      explicit FrameArena(std::size_t capacity = DEFAULT_CAPACITY);
+      ~FrameArena();
+      FrameArena(FrameArena &&)      = delete;
+      FrameArena(const FrameArena &) = delete;
+      auto operator=(const FrameArena &) -> FrameArena & = delete;
+      auto operator=(FrameArena &&) -> FrameArena & = delete;
+
+      /**
+       * Allocate memory that stays valid until the end of the next frame. Safe
+       * to call from any thread.
+       */
+      auto allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t))
+          -> void *;
+      /**
+       * Copy a string into the arena
+       */
+      template<typename Char>
+      auto copy(std::basic_string_view<Char> string) -> std::basic_string_view<Char> {
+        if (string.empty()) {
+          return {};
+        }
+
+        const auto size = sizeof(Char) * (string.size() + 1);
+        auto *data      = static_cast<Char *>(this->allocate(size, alignof(Char)));
+        std::char_traits<Char>::copy(data, string.data(), string.size());
+        data[string.size()] = Char{};
+
+        return {data, string.size()};
+      }
+      /**
+       * End the frame, recycling the memory allocated the frame before. Must
+       * not run while anything allocates from that frame.
+       */
+      auto reset() -> void;
+      /**
+       * Get the bytes allocated during the last complete frame
+       */
+      auto get_bytes_used() const -> std::size_t;
+      /**
+       * Get the bytes the last complete frame allocated past the buffer, which
+       * fell back to the heap
+       */
+      auto get_overflow_bytes() const -> std::size_t;
+      /**
+       * Get the size of each buffer
+       */
+      auto get_capacity() const -> std::size_t;
+
+    private:
+      struct Overflow {
+        void *data            = nullptr;
+        std::size_t alignment = {};
+      };
+
+      struct Buffer {
+        std::unique_ptr<std::byte[]> data = {};
+        std::size_t capacity              = {};
+        std::atomic<std::size_t> used     = {};
+        std::size_t overflow_bytes        = {};
+        std::vector<Overflow> overflow    = {};
+      };
+
+      std::array<Buffer, 2> buffers    = {};
+      std::atomic<std::size_t> current = {};
+      std::size_t last_bytes_used      = {};
+      std::size_t last_overflow_bytes  = {};
+      std::mutex overflow_mutex        = {};
+
+      auto release_overflow(Buffer &buffer) -> void;
+    };
+
+    /**
+     * Standard allocator handing out memory from a frame arena, for
+     * containers that are rebuilt every frame. Without an arena, such as in a
+     * default constructed container, it falls back to the heap.
+     */
+    template<typename T>
+    class FrameAllocator {
+    public:
+      using value_type                             = T;
+      using propagate_on_container_copy_assignment = std::true_type;
+      using propagate_on_container_move_assignment = std::true_type;
+      using propagate_on_container_swap            = std::true_type;
+
+      FrameAllocator() = default;
+      explicit FrameAllocator(FrameArena *_arena) : arena(_arena) {}
+      template<typename U>
+      FrameAllocator(const FrameAllocator<U> &other) : arena(other.get_arena()) {}
+
+      auto allocate(std::size_t count) -> T * {
+        if (this->arena == nullptr) {
+          return std::allocator<T>{}.allocate(count);
+        }
+
+        return static_cast<T *>(this->arena->allocate(sizeof(T) * count, alignof(T)));
+      }
+      auto deallocate(T *data, std::size_t count) -> void {
+        if (this->arena == nullptr) {
+          std::allocator<T>{}.deallocate(data, count);
+        }
+      }
+
+      auto get_arena() const -> FrameArena * {
+        return this->arena;
+      }
+
+      template<typename U>
+      auto operator==(const FrameAllocator<U> &rhs) const -> bool {
+        return this->arena == rhs.get_arena();
+      }
+      template<typename U>
+      auto operator!=(const FrameAllocator<U> &rhs) const -> bool {
+        return this->arena != rhs.get_arena();
+      }
+
+    private:
+      FrameArena *arena = nullptr;
+    };
+
+    template<typename T>
+    using FrameVector = std::vector<T, FrameAllocator<T>>;
+    using FrameString = std::basic_string<char, std::char_traits<char>, FrameAllocator<char>>;
+  }
+}
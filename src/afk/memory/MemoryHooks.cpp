@@ -0,0 +1,110 @@
+#include "afk/memory/MemoryHooks.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <DetourAlloc.h>
+#include <RecastAlloc.h>
+#include <imgui/imgui.h>
+
+#include "afk/memory/MemoryTracker.hpp"
+#include "afk/script/LuaInclude.hpp"
+
+using Afk::Memory::PhysicsAllocator;
+using Afk::Memory::Tag;
+
+auto PhysicsAllocator::allocate(std::size_t size) -> void * {
+  auto *data = std::malloc(size);
+
+  if (data != nullptr) {
+    track_allocation(Tag::Physics, size);
+  }
+
+  return data;
+}
+
+auto PhysicsAllocator::release(void *pointer, std::size_t size) -> void {
+  track_free(Tag::Physics, size);
+  std::free(pointer);
+}
+
+auto Afk::Memory::lua_allocate([[maybe_unused]] void *user_data, void *data,
+                               std::size_t old_size, std::size_t new_size) -> void * {
+  // Without a block, the old size is the type of object being allocated.
+  if (data == nullptr) {
+    old_size = 0;
+  }
+
+  if (new_size == 0) {
+    if (data != nullptr) {
+      track_free(Tag::Lua, old_size);
+      std::free(data);
+    }
+
+    return nullptr;
+  }
+
+  auto *resized = std::realloc(data, new_size);
+
+  if (resized != nullptr) {
+    if (data != nullptr) {
+      track_free(Tag::Lua, old_size);
+    }
+
+    track_allocation(Tag::Lua, new_size);
+  }
+
+  return resized;
+}
+
+static auto lua_panic(lua_State *lua) -> int {
+  // Same as the auxiliary library's handler.
+  std::fprintf(stderr, "PANIC: unprotected error in call to Lua API (%s)\n",
+               lua_tostring(lua, -1));
+
+  return 0;
+}
+
+auto Afk::Memory::new_lua_state() -> lua_State * {
+  auto *lua = lua_newstate(lua_allocate, nullptr);
+
+  if (lua != nullptr) {
+    lua_atpanic(lua, lua_panic);
+  }
+
+  return lua;
+}
+
+static auto recast_allocate(std::size_t size, [[maybe_unused]] rcAllocHint hint) -> void * {
+  return Afk::Memory::allocate(Tag::Navigation, size);
+}
+
+static auto detour_allocate(std::size_t size, [[maybe_unused]] dtAllocHint hint) -> void * {
+  return Afk::Memory::allocate(Tag::Navigation, size);
+}
+
+static auto imgui_allocate(std::size_t size, [[maybe_unused]] void *user_data) -> void * {
+  return Afk::Memory::allocate(Tag::Ui, size);
+}
+
+static auto free_memory(void *data) -> void {
+  Afk::Memory::free(data);
+}
+
+static auto imgui_free(void *data, [[maybe_unused]] void *user_data) -> void {
+  Afk::Memory::free(data);
+}
+
+/**
+ * Installs the library hooks before main(), so nothing allocated with a
+ * library's default allocator is ever freed with these
+ */
+struct HookInstaller {
+  HookInstaller() {
+    rcAllocSetCustom(recast_allocate, free_memory);
+    dtAllocSetCustom(detour_allocate, free_memory);
+    ImGui::SetAllocatorFunctions(imgui_allocate, imgui_free);
+  }
+};
+
+static const auto hook_installer = HookInstaller{};
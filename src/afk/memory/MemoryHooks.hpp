@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+#include <reactphysics3d/reactphysics3d.h>
+
+struct lua_State;
+
+namespace Afk {
+  namespace Memory {
+    /**
+     * rp3d allocator tracking everything under the physics tag
+     */
+    class PhysicsAllocator : public rp3d::MemoryAllocator {
+    public:
+      auto allocate(std::size_t size) -> void * override;
+      auto release(void *pointer, std::size_t size) -> void override;
+    };
+    /**
+     * Lua allocator tracking everything under the Lua tag
+     */
+    auto lua_allocate(void *user_data, void *data, std::size_t old_size, std::size_t new_size)
+        -> void *;
+    /**
+     * Create a Lua state like luaL_newstate(), with its memory tracked
+     */
+    auto new_lua_state() -> lua_State *;
+  }
+}
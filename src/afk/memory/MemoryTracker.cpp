@@ -0,0 +1,166 @@
+#include "afk/memory/MemoryTracker.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "afk/debug/Assert.hpp"
+#include "afk/io/Log.hpp"
+
+using Afk::Memory::Stats;
+using Afk::Memory::Tag;
+using Afk::Memory::TagScope;
+
+static constexpr auto TAG_COUNT = static_cast<std::size_t>(Tag::Count);
+
+static constexpr auto tag_names = std::array<const char *, TAG_COUNT>{
+    "General", "Models", "Physics", "Navigation", "Lua", "UI"};
+
+/**
+ * Kept in front of every allocation so it can be freed without its size
+ */
+struct alignas(std::max_align_t) AllocationHeader {
+  std::size_t size = {};
+  Tag tag          = Tag::General;
+};
+
+struct TagCounters {
+  std::atomic<std::size_t> current_bytes = {};
+  std::atomic<std::size_t> peak_bytes    = {};
+  std::atomic<std::size_t> allocations   = {};
+  std::atomic<std::size_t> frees         = {};
+};
+
+// Zero initialized before anything runs, global new may be called first.
+static auto counters                 = std::array<TagCounters, TAG_COUNT>{};
+static auto baseline                 = std::array<Stats, TAG_COUNT>{};
+static thread_local auto current_tag = Tag::General;
+
+static auto get_counters(Tag tag) -> TagCounters & {
+  return counters[static_cast<std::size_t>(tag)];
+}
+
+TagScope::TagScope(Tag tag) : previous(current_tag) {
+  current_tag = tag;
+}
+
+TagScope::~TagScope() {
+  current_tag = this->previous;
+}
+
+auto Afk::Memory::allocate(Tag tag, std::size_t size) -> void * {
+  auto *header = static_cast<AllocationHeader *>(std::malloc(sizeof(AllocationHeader) + size));
+
+  if (header == nullptr) {
+    return nullptr;
+  }
+
+  header->size = size;
+  header->tag  = tag;
+  track_allocation(tag, size);
+
+  return header + 1;
+}
+
+auto Afk::Memory::free(void *data) -> void {
+  if (data == nullptr) {
+    return;
+  }
+
+  auto *header = static_cast<AllocationHeader *>(data) - 1;
+  track_free(header->tag, header->size);
+  std::free(header);
+}
+
+auto Afk::Memory::track_allocation(Tag tag, std::size_t size) -> void {
+  auto &tag_counters = get_counters(tag);
+  const auto current = tag_counters.current_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+  auto peak          = tag_counters.peak_bytes.load(std::memory_order_relaxed);
+
+  while (current > peak &&
+         !tag_counters.peak_bytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+  }
+
+  tag_counters.allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto Afk::Memory::track_free(Tag tag, std::size_t size) -> void {
+  auto &tag_counters = get_counters(tag);
+  tag_counters.current_bytes.fetch_sub(size, std::memory_order_relaxed);
+  tag_counters.frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto Afk::Memory::get_current_tag() -> Tag {
+  return current_tag;
+}
+
+auto Afk::Memory::get_stats(Tag tag) -> Stats {
+  const auto &tag_counters = get_counters(tag);
+
+  return {tag_counters.current_bytes.load(std::memory_order_relaxed),
+          tag_counters.peak_bytes.load(std::memory_order_relaxed),
+          tag_counters.allocations.load(std::memory_order_relaxed),
+          tag_counters.frees.load(std::memory_order_relaxed)};
+}
+
+auto Afk::Memory::get_tag_name(Tag tag) -> const char * {
+  afk_assert(tag < Tag::Count, "Invalid memory tag");
+
+  return tag_names[static_cast<std::size_t>(tag)];
+}
+
+auto Afk::Memory::set_baseline() -> void {
+  for (auto i = std::size_t{0}; i < TAG_COUNT; ++i) {
+    baseline[i] = get_stats(static_cast<Tag>(i));
+  }
+}
+
+auto Afk::Memory::log_leaks() -> void {
+  auto has_leaks = false;
+
+  for (auto i = std::size_t{0}; i < TAG_COUNT; ++i) {
+    const auto tag           = static_cast<Tag>(i);
+    const auto stats         = get_stats(tag);
+    const auto live          = stats.allocations - stats.frees;
+    const auto baseline_live = baseline[i].allocations - baseline[i].frees;
+
+    if (stats.current_bytes <= baseline[i].current_bytes) {
+      continue;
+    }
+
+    if (!has_leaks) {
+      Afk::Io::log << "Memory still held at shutdown beyond what was held before the scene "
+                      "loaded:\n";
+      has_leaks = true;
+    }
+
+    Afk::Io::log << "  " << get_tag_name(tag) << ": "
+                 << stats.current_bytes - baseline[i].current_bytes << " bytes in "
+                 << (live > baseline_live ? live - baseline_live : 0) << " allocations\n";
+  }
+
+  if (!has_leaks) {
+    Afk::Io::log << "No memory leaked\n";
+  }
+}
+
+#ifdef AFK_MEMORY_TRACKING
+auto operator new(std::size_t size) -> void * {
+  auto *data = Afk::Memory::allocate(Afk::Memory::get_current_tag(), size);
+
+  if (data == nullptr) {
+    throw std::bad_alloc{};
+  }
+
+  return data;
+}
+
+auto operator delete(void *data) noexcept -> void {
+  Afk::Memory::free(data);
+}
+
+auto operator delete(void *data, [[maybe_unused]] std::size_t size) noexcept -> void {
+  Afk::Memory::free(data);
+}
+#endif
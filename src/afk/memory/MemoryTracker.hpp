@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Afk {
+  namespace Memory {
+    /**
+     * Subsystems memory is accounted to
+     */
+    enum class Tag : std::size_t { General, Models, Physics, Navigation, Lua, Ui, Count };
+    /**
+     * Memory use of a subsystem
+     */
+    struct Stats {
+      std::size_t current_bytes = {};
+      std::size_t peak_bytes    = {};
+      std::size_t allocations   = {};
+      std::size_t frees         = {};
+    };
+    /**
+     * Attributes global new/delete on this thread to a tag while in scope. Only
+     * has an effect when built with memory tracking.
+     */
+    class TagScope {
+    public:
+      explicit TagScope(Tag tag);
+      ~TagScope();
+      TagScope(TagScope &&)      = delete;
+      TagScope(const TagScope &) = delete;
+      auto operator=(const TagScope &) -> TagScope & = delete;
+      auto operator=(TagScope &&) -> TagScope & = delete;
+
+    private:
+      Tag previous = Tag::General;
+    };
+
+#ifdef AFK_MEMORY_TRACKING
+    /**
+     * Whether global new/delete are tracked, libraries with allocator hooks
+     * are always tracked
+     */
+    static constexpr bool is_tracking_global = true;
+#else
+    static constexpr bool is_tracking_global = false;
+#endif
+
+    /**
+     * Allocate and track memory, remembering its size and tag so it can be
+     * freed without either
+     */
+    auto allocate(Tag tag, std::size_t size) -> void *;
+    /**
+     * Free memory from allocate()
+     */
+    auto free(void *data) -> void;
+    /**
+     * Record an allocation made elsewhere
+     */
+    auto track_allocation(Tag tag, std::size_t size) -> void;
+    /**
+     * Record a free made elsewhere
+     */
+    auto track_free(Tag tag, std::size_t size) -> void;
+    /**
+     * Get the tag global new/delete on this thread are attributed to
+     */
+    auto get_current_tag() -> Tag;
+    auto get_stats(Tag tag) -> Stats;
+    auto get_tag_name(Tag tag) -> const char *;
+    /**
+     * Remember what each subsystem holds now, anything it holds beyond this
+     * at shutdown is reported as leaked
+     */
+    auto set_baseline() -> void;
+    /**
+     * Log what each subsystem holds beyond the baseline
+     */
+    auto log_leaks() -> void;
+  }
+}
@@ -1,7 +1,11 @@
 #include "afk/physics/PhysicsBodySystem.hpp"
 
+#include <cstddef>
+#include <cstdint>
+
 #include "afk/Afk.hpp"
 #include "afk/component/TagComponent.hpp"
+#include "afk/debug/Profiler.hpp"
 
 using Afk::PhysicsBodySystem;
 
@@ -22,21 +26,51 @@ auto PhysicsBodySystem::set_gravity(glm::vec3 gravity) {
 }
 
 auto PhysicsBodySystem::update(entt::registry *registry, float dt) -> void {
-  this->world->update(dt);
+  afk_profile_zone("PhysicsBodySystem::update");
+  {
+    afk_profile_zone("rp3d::PhysicsWorld::update");
+    this->world->update(dt);
+  }
 
   // Mirror changes in physics engine to Transform component
   // TODO: Scale shapes of rigid bodies on the fly, updates in v0.8.0 might help with this
   // @see https://github.com/DanielChappuis/reactphysics3d/issues/103
-  registry->view<Afk::Transform, Afk::PhysicsBody>().each(
-      [](Afk::Transform &transform, Afk::PhysicsBody &collision) {
-        const auto &rp3d_position = collision.body->getTransform().getPosition();
-        const auto &rp3d_orientation = collision.body->getTransform().getOrientation();
-
-        transform.translation =
-            glm::vec3{rp3d_position.x, rp3d_position.y, rp3d_position.z};
-        transform.rotation = glm::quat{rp3d_orientation.w, rp3d_orientation.x,
-                                       rp3d_orientation.y, rp3d_orientation.z};
-      });
+  // Every body writes only its own transform, so split them across workers.
+  auto &engine         = Afk::Engine::get();
+  auto bodies          = registry->view<Afk::PhysicsBody>();
+  auto transforms      = registry->view<Afk::Transform>();
+  const auto *entities = bodies.data();
+  auto moved           = Memory::FrameVector<std::uint8_t>(
+      bodies.size(), std::uint8_t{0}, Memory::FrameAllocator<std::uint8_t>{&engine.frame_arena});
+
+  engine.job_system.parallel_for(0, bodies.size(), [&](std::size_t i) {
+    const auto entity = entities[i];
+
+    if (!transforms.contains(entity)) {
+      return;
+    }
+
+    auto &transform              = transforms.get(entity);
+    const auto &collision        = bodies.get(entity);
+    const auto &rp3d_position    = collision.body->getTransform().getPosition();
+    const auto &rp3d_orientation = collision.body->getTransform().getOrientation();
+
+    const auto translation = glm::vec3{rp3d_position.x, rp3d_position.y, rp3d_position.z};
+    const auto rotation    = glm::quat{rp3d_orientation.w, rp3d_orientation.x,
+                                    rp3d_orientation.y, rp3d_orientation.z};
+
+    moved[i] = translation != transform.translation || rotation != transform.rotation;
+
+    transform.translation = translation;
+    transform.rotation    = rotation;
+  });
+
+  // Only bodies that moved need their place in the render tree updated.
+  for (auto i = std::size_t{0}; i < moved.size(); ++i) {
+    if (moved[i] != 0) {
+      engine.render_tree.mark_moved(entities[i]);
+    }
+  }
 }
 
 void PhysicsBodySystem::CollisionEventListener::onContact(
@@ -5,6 +5,7 @@
 #include <entt/entt.hpp>
 #include <reactphysics3d/reactphysics3d.h>
 
+#include "afk/memory/MemoryHooks.hpp"
 #include "afk/physics/PhysicsBody.hpp"
 #include "glm/vec3.hpp"
 
@@ -30,7 +31,8 @@ namespace Afk {
       virtual void onContact(const rp3d::CollisionCallback::CallbackData &callback_data) override;
     };
 
-    rp3d::PhysicsCommon physics_common = {};
+    Memory::PhysicsAllocator allocator = {};
+    rp3d::PhysicsCommon physics_common = rp3d::PhysicsCommon{&allocator};
     rp3d::PhysicsWorld *world          = physics_common.createPhysicsWorld();
     CollisionEventListener listener    = {};
 
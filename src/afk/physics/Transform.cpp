@@ -1,8 +1,10 @@
 #include "afk/physics/Transform.hpp"
 
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
 
+using Afk::PreviousTransform;
 using Afk::Transform;
 using glm::mat4;
 
@@ -37,3 +39,25 @@ Transform::Transform(GameObject e, mat4 transform) {
   this->scale       = _scale;
   this->rotation    = _rotation;
 }
+
+auto Transform::get_matrix() const -> mat4 {
+  auto matrix = mat4{1.0f};
+
+  matrix = glm::translate(matrix, this->translation);
+  matrix *= glm::mat4_cast(this->rotation);
+  matrix = glm::scale(matrix, this->scale);
+
+  return matrix;
+}
+
+PreviousTransform::PreviousTransform(GameObject e, const Transform &_transform)
+  : BaseComponent(e), transform(_transform) {}
+
+auto Afk::interpolate(const Transform &from, const Transform &to, float alpha) -> Transform {
+  auto result        = to;
+  result.translation = glm::mix(from.translation, to.translation, alpha);
+  result.scale       = glm::mix(from.scale, to.scale, alpha);
+  result.rotation    = glm::slerp(from.rotation, to.rotation, alpha);
+
+  return result;
+}
@@ -19,6 +19,23 @@ namespace Afk {
     Transform(glm::mat4 transform);
     Transform(GameObject e, glm::mat4 transform);
 
-    auto get_matrix() -> glm::mat4;
+    auto get_matrix() const -> glm::mat4;
   };
+  /**
+   * Transform at the start of the last simulation step, used to interpolate
+   * between simulation states when rendering
+   */
+  struct PreviousTransform : public BaseComponent {
+    Transform transform = {};
+
+    PreviousTransform() = default;
+    PreviousTransform(GameObject e, const Transform &_transform);
+  };
+  /**
+   * Interpolate between two transforms
+   * \param from transform at alpha 0
+   * \param to transform at alpha 1
+   * \param alpha interpolation factor in [0, 1]
+   */
+  auto interpolate(const Transform &from, const Transform &to, float alpha) -> Transform;
 }
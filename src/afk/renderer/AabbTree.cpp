@@ -0,0 +1,372 @@
+#include "afk/renderer/AabbTree.hpp"
+
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "afk/debug/Assert.hpp"
+
+using glm::vec3;
+
+using Afk::Aabb;
+using Afk::AabbTree;
+using Afk::GameObject;
+using ProxyId = AabbTree::ProxyId;
+
+AabbTree::AabbTree(float _margin) : margin(_margin) {
+  afk_assert(_margin >= 0.0f, "Negative AABB tree margin");
+}
+
+auto AabbTree::insert(const Aabb &aabb, GameObject object) -> ProxyId {
+  const auto proxy = this->allocate_node();
+  auto &node       = this->get_node(proxy);
+
+  node.aabb   = this->fatten(aabb);
+  node.object = object;
+  node.height = 0;
+
+  this->insert_leaf(proxy);
+  ++this->size;
+
+  return proxy;
+}
+
+auto AabbTree::remove(ProxyId proxy) -> void {
+  afk_assert(this->get_node(proxy).is_leaf(), "Removing non-leaf AABB tree node");
+
+  this->remove_leaf(proxy);
+  this->free_node(proxy);
+  --this->size;
+}
+
+auto AabbTree::move(ProxyId proxy, const Aabb &aabb) -> bool {
+  auto &node = this->get_node(proxy);
+
+  afk_assert_debug(node.is_leaf(), "Moving non-leaf AABB tree node");
+
+  if (node.aabb.contains(aabb)) {
+    return false;
+  }
+
+  this->remove_leaf(proxy);
+  this->get_node(proxy).aabb = this->fatten(aabb);
+  this->insert_leaf(proxy);
+
+  return true;
+}
+
+auto AabbTree::build(const std::vector<Leaf> &leaves) -> std::vector<ProxyId> {
+  this->clear();
+
+  auto proxies = std::vector<ProxyId>(leaves.size(), NULL_PROXY);
+
+  if (leaves.empty()) {
+    return proxies;
+  }
+
+  // Remember where each leaf came from, building reorders them.
+  auto ordered = std::vector<std::pair<Leaf, std::size_t>>{};
+  ordered.reserve(leaves.size());
+
+  for (auto i = std::size_t{0}; i < leaves.size(); ++i) {
+    ordered.emplace_back(leaves[i], i);
+  }
+
+  this->nodes.reserve(leaves.size() * 2 - 1);
+  this->root = this->build_range(ordered, 0, ordered.size(), proxies);
+  this->size = leaves.size();
+
+  return proxies;
+}
+
+auto AabbTree::clear() -> void {
+  this->nodes.clear();
+  this->root      = NULL_PROXY;
+  this->free_list = NULL_PROXY;
+  this->size      = 0;
+}
+
+auto AabbTree::get_object(ProxyId proxy) const -> GameObject {
+  return this->get_node(proxy).object;
+}
+
+auto AabbTree::get_fat_aabb(ProxyId proxy) const -> const Aabb & {
+  return this->get_node(proxy).aabb;
+}
+
+auto AabbTree::get_size() const -> std::size_t {
+  return this->size;
+}
+
+auto AabbTree::get_height() const -> int {
+  return this->root == NULL_PROXY ? 0 : this->get_node(this->root).height;
+}
+
+auto AabbTree::get_node(ProxyId proxy) -> Node & {
+  afk_assert_debug(proxy >= 0 && static_cast<std::size_t>(proxy) < this->nodes.size(),
+                   "Invalid AABB tree proxy");
+  return this->nodes[static_cast<std::size_t>(proxy)];
+}
+
+auto AabbTree::get_node(ProxyId proxy) const -> const Node & {
+  afk_assert_debug(proxy >= 0 && static_cast<std::size_t>(proxy) < this->nodes.size(),
+                   "Invalid AABB tree proxy");
+  return this->nodes[static_cast<std::size_t>(proxy)];
+}
+
+auto AabbTree::allocate_node() -> ProxyId {
+  if (this->free_list == NULL_PROXY) {
+    this->nodes.emplace_back();
+    return static_cast<ProxyId>(this->nodes.size() - 1);
+  }
+
+  const auto proxy = this->free_list;
+  auto &node       = this->get_node(proxy);
+  this->free_list  = node.parent;
+  node             = Node{};
+
+  return proxy;
+}
+
+auto AabbTree::free_node(ProxyId proxy) -> void {
+  auto &node      = this->get_node(proxy);
+  node            = Node{};
+  node.parent     = this->free_list;
+  this->free_list = proxy;
+}
+
+auto AabbTree::fatten(const Aabb &aabb) const -> Aabb {
+  const auto margin = vec3{this->margin};
+
+  return {aabb.min - margin, aabb.max + margin};
+}
+
+auto AabbTree::insert_leaf(ProxyId leaf) -> void {
+  if (this->root == NULL_PROXY) {
+    this->root                  = leaf;
+    this->get_node(leaf).parent = NULL_PROXY;
+    return;
+  }
+
+  // Walk down to the sibling that grows the tree's surface area the least,
+  // which is what a ray or frustum pays for when it visits a node.
+  const auto leaf_aabb = this->get_node(leaf).aabb;
+  auto proxy           = this->root;
+
+  while (!this->get_node(proxy).is_leaf()) {
+    const auto &node         = this->get_node(proxy);
+    const auto area          = node.aabb.get_surface_area();
+    const auto combined_area = Afk::merge_aabbs(node.aabb, leaf_aabb).get_surface_area();
+
+    // Cost of pairing the leaf with this node, and of pushing it further down.
+    const auto cost        = 2.0f * combined_area;
+    const auto inheritance = 2.0f * (combined_area - area);
+
+    const auto get_descend_cost = [&](ProxyId child) {
+      const auto &child_aabb = this->get_node(child).aabb;
+      const auto merged_area = Afk::merge_aabbs(leaf_aabb, child_aabb).get_surface_area();
+
+      return this->get_node(child).is_leaf()
+                 ? merged_area + inheritance
+                 : merged_area - child_aabb.get_surface_area() + inheritance;
+    };
+
+    const auto left_cost  = get_descend_cost(node.left);
+    const auto right_cost = get_descend_cost(node.right);
+
+    if (cost < left_cost && cost < right_cost) {
+      break;
+    }
+
+    proxy = left_cost < right_cost ? node.left : node.right;
+  }
+
+  // Replace the sibling with a new parent of it and the leaf.
+  const auto sibling    = proxy;
+  const auto old_parent = this->get_node(sibling).parent;
+  const auto new_parent = this->allocate_node();
+  auto &parent_node     = this->get_node(new_parent);
+
+  parent_node.parent = old_parent;
+  parent_node.aabb   = Afk::merge_aabbs(leaf_aabb, this->get_node(sibling).aabb);
+  parent_node.height = this->get_node(sibling).height + 1;
+  parent_node.left   = sibling;
+  parent_node.right  = leaf;
+
+  if (old_parent == NULL_PROXY) {
+    this->root = new_parent;
+  } else if (this->get_node(old_parent).left == sibling) {
+    this->get_node(old_parent).left = new_parent;
+  } else {
+    this->get_node(old_parent).right = new_parent;
+  }
+
+  this->get_node(sibling).parent = new_parent;
+  this->get_node(leaf).parent    = new_parent;
+
+  this->refit(new_parent);
+}
+
+auto AabbTree::remove_leaf(ProxyId leaf) -> void {
+  if (leaf == this->root) {
+    this->root = NULL_PROXY;
+    return;
+  }
+
+  // Replace the leaf's parent with its sibling.
+  const auto parent       = this->get_node(leaf).parent;
+  const auto &parent_node = this->get_node(parent);
+  const auto grandparent  = parent_node.parent;
+  const auto sibling      = parent_node.left == leaf ? parent_node.right : parent_node.left;
+
+  this->get_node(sibling).parent = grandparent;
+  this->free_node(parent);
+
+  if (grandparent == NULL_PROXY) {
+    this->root = sibling;
+    return;
+  }
+
+  auto &grandparent_node = this->get_node(grandparent);
+
+  if (grandparent_node.left == parent) {
+    grandparent_node.left = sibling;
+  } else {
+    grandparent_node.right = sibling;
+  }
+
+  this->refit(grandparent);
+}
+
+auto AabbTree::refit(ProxyId proxy) -> void {
+  while (proxy != NULL_PROXY) {
+    proxy = this->balance(proxy);
+
+    auto &node        = this->get_node(proxy);
+    const auto &left  = this->get_node(node.left);
+    const auto &right = this->get_node(node.right);
+
+    node.height = 1 + std::max(left.height, right.height);
+    node.aabb   = Afk::merge_aabbs(left.aabb, right.aabb);
+    proxy       = node.parent;
+  }
+}
+
+auto AabbTree::balance(ProxyId a) -> ProxyId {
+  auto &node_a = this->get_node(a);
+
+  if (node_a.is_leaf() || node_a.height < 2) {
+    return a;
+  }
+
+  const auto b    = node_a.left;
+  const auto c    = node_a.right;
+  auto &node_b    = this->get_node(b);
+  auto &node_c    = this->get_node(c);
+  const auto skew = node_c.height - node_b.height;
+
+  if (skew >= -1 && skew <= 1) {
+    return a;
+  }
+
+  // Rotate the taller child up into a's place, a takes the taller of its
+  // grandchildren's places.
+  const auto up         = skew > 1 ? c : b;
+  auto &node_up         = skew > 1 ? node_c : node_b;
+  const auto &node_kept = skew > 1 ? node_b : node_c;
+  const auto f          = node_up.left;
+  const auto g          = node_up.right;
+  auto &node_f          = this->get_node(f);
+  auto &node_g          = this->get_node(g);
+
+  node_up.left   = a;
+  node_up.parent = node_a.parent;
+  node_a.parent  = up;
+
+  if (node_up.parent == NULL_PROXY) {
+    this->root = up;
+  } else if (this->get_node(node_up.parent).left == a) {
+    this->get_node(node_up.parent).left = up;
+  } else {
+    this->get_node(node_up.parent).right = up;
+  }
+
+  // The shorter grandchild moves down under a, beside the child that stayed.
+  const auto is_f_taller = node_f.height > node_g.height;
+  const auto taller      = is_f_taller ? f : g;
+  const auto shorter     = is_f_taller ? g : f;
+  auto &node_taller      = is_f_taller ? node_f : node_g;
+  auto &node_shorter     = is_f_taller ? node_g : node_f;
+
+  node_up.right       = taller;
+  node_shorter.parent = a;
+
+  if (skew > 1) {
+    node_a.right = shorter;
+  } else {
+    node_a.left = shorter;
+  }
+
+  node_a.aabb    = Afk::merge_aabbs(node_kept.aabb, node_shorter.aabb);
+  node_a.height  = 1 + std::max(node_kept.height, node_shorter.height);
+  node_up.aabb   = Afk::merge_aabbs(node_a.aabb, node_taller.aabb);
+  node_up.height = 1 + std::max(node_a.height, node_taller.height);
+
+  return up;
+}
+
+auto AabbTree::build_range(std::vector<std::pair<Leaf, std::size_t>> &leaves,
+                           std::size_t begin, std::size_t end, std::vector<ProxyId> &proxies)
+    -> ProxyId {
+  if (end - begin == 1) {
+    const auto &[leaf, index] = leaves[begin];
+    const auto proxy          = this->allocate_node();
+    auto &node                = this->get_node(proxy);
+
+    node.aabb      = this->fatten(leaf.aabb);
+    node.object    = leaf.object;
+    node.height    = 0;
+    proxies[index] = proxy;
+
+    return proxy;
+  }
+
+  // Split at the median centre along the axis the centres spread most on.
+  const auto first_center = leaves[begin].first.aabb.get_center();
+  auto centers            = Aabb{first_center, first_center};
+
+  for (auto i = begin + 1; i < end; ++i) {
+    const auto center = leaves[i].first.aabb.get_center();
+    centers.min       = glm::min(centers.min, center);
+    centers.max       = glm::max(centers.max, center);
+  }
+
+  const auto spread = centers.max - centers.min;
+  const auto axis   = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2)
+                                          : (spread.y > spread.z ? 1 : 2);
+  const auto middle = begin + (end - begin) / 2;
+
+  std::nth_element(leaves.begin() + static_cast<std::ptrdiff_t>(begin),
+                   leaves.begin() + static_cast<std::ptrdiff_t>(middle),
+                   leaves.begin() + static_cast<std::ptrdiff_t>(end),
+                   [axis](const auto &lhs, const auto &rhs) {
+                     return lhs.first.aabb.get_center()[axis] <
+                            rhs.first.aabb.get_center()[axis];
+                   });
+
+  const auto left  = this->build_range(leaves, begin, middle, proxies);
+  const auto right = this->build_range(leaves, middle, end, proxies);
+  const auto proxy = this->allocate_node();
+  auto &node       = this->get_node(proxy);
+  auto &left_node  = this->get_node(left);
+  auto &right_node = this->get_node(right);
+
+  node.left         = left;
+  node.right        = right;
+  node.aabb         = Afk::merge_aabbs(left_node.aabb, right_node.aabb);
+  node.height       = 1 + std::max(left_node.height, right_node.height);
+  left_node.parent  = proxy;
+  right_node.parent = proxy;
+
+  return proxy;
+}
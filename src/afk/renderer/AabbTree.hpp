@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "afk/component/GameObject.hpp"
+#include "afk/renderer/Bounds.hpp"
+#include "afk/renderer/Frustum.hpp"
+
+namespace Afk {
+  /**
+   * Dynamic bounding volume hierarchy of objects' boxes. Leaves store a box
+   * fattened by a margin, so small movements don't touch the tree, and the
+   * tree is rebalanced with rotations as leaves are inserted and removed.
+   */
+  class AabbTree {
+  public:
+    using ProxyId = std::int32_t;
+
+    static constexpr ProxyId NULL_PROXY   = -1;
+    static constexpr float DEFAULT_MARGIN = 0.5f;
+
+    /**
+     * An object to build the tree from
+     */
+    struct Leaf {
+      Aabb aabb         = {};
+      GameObject object = entt::null;
+    };
+
+    /**
+     * \param _margin distance leaf boxes are fattened by, zero for objects
+     * that never move
+     */
+    explicit AabbTree(float _margin = DEFAULT_MARGIN);
+
+    /**
+     * Insert an object, returning the proxy it is found by
+     */
+    auto insert(const Aabb &aabb, GameObject object) -> ProxyId;
+    auto remove(ProxyId proxy) -> void;
+    /**
+     * Update an object's box, only touching the tree if it left its fat box
+     * \return whether the tree changed
+     */
+    auto move(ProxyId proxy, const Aabb &aabb) -> bool;
+    /**
+     * Replace the tree with one built top down from leaves, which gives a
+     * better tree than inserting them one at a time
+     * \return the proxy of each leaf, in order
+     */
+    auto build(const std::vector<Leaf> &leaves) -> std::vector<ProxyId>;
+    auto clear() -> void;
+
+    auto get_object(ProxyId proxy) const -> GameObject;
+    auto get_fat_aabb(ProxyId proxy) const -> const Aabb &;
+    /**
+     * Get the number of objects in the tree
+     */
+    auto get_size() const -> std::size_t;
+    auto get_height() const -> int;
+
+    /**
+     * Call back with the proxy of each object whose fat box may be inside a
+     * frustum. Subtrees wholly inside are visited without further tests.
+     */
+    template<typename Callback>
+    auto query(const Frustum &frustum, Callback &&callback) const -> void {
+      auto stack = std::vector<std::pair<ProxyId, bool>>{};
+
+      stack.reserve(64);
+
+      if (this->root != NULL_PROXY) {
+        stack.emplace_back(this->root, false);
+      }
+
+      while (!stack.empty()) {
+        const auto [proxy, is_inside] = stack.back();
+        const auto &node              = this->nodes[static_cast<std::size_t>(proxy)];
+        auto visibility               = Visibility::Inside;
+
+        stack.pop_back();
+
+        if (!is_inside) {
+          visibility = Afk::get_visibility(frustum, node.aabb);
+
+          if (visibility == Visibility::Outside) {
+            continue;
+          }
+        }
+
+        if (node.is_leaf()) {
+          callback(proxy);
+        } else {
+          stack.emplace_back(node.left, visibility == Visibility::Inside);
+          stack.emplace_back(node.right, visibility == Visibility::Inside);
+        }
+      }
+    }
+    /**
+     * Call back with the proxy of each object whose fat box overlaps a sphere
+     */
+    template<typename Callback>
+    auto query(const BoundingSphere &sphere, Callback &&callback) const -> void {
+      auto stack = std::vector<ProxyId>{};
+
+      stack.reserve(64);
+
+      if (this->root != NULL_PROXY) {
+        stack.push_back(this->root);
+      }
+
+      while (!stack.empty()) {
+        const auto proxy = stack.back();
+        const auto &node = this->nodes[static_cast<std::size_t>(proxy)];
+
+        stack.pop_back();
+
+        if (!Afk::intersects(node.aabb, sphere)) {
+          continue;
+        }
+
+        if (node.is_leaf()) {
+          callback(proxy);
+        } else {
+          stack.push_back(node.left);
+          stack.push_back(node.right);
+        }
+      }
+    }
+
+  private:
+    struct Node {
+      Aabb aabb         = {};
+      GameObject object = entt::null;
+      // Next free node while the node is on the free list.
+      ProxyId parent = NULL_PROXY;
+      ProxyId left   = NULL_PROXY;
+      ProxyId right  = NULL_PROXY;
+      // Leaves are 0, free nodes -1.
+      int height = -1;
+
+      auto is_leaf() const -> bool {
+        return this->left == NULL_PROXY;
+      }
+    };
+
+    float margin            = DEFAULT_MARGIN;
+    std::vector<Node> nodes = {};
+    ProxyId root            = NULL_PROXY;
+    ProxyId free_list       = NULL_PROXY;
+    std::size_t size        = {};
+
+    auto get_node(ProxyId proxy) -> Node &;
+    auto get_node(ProxyId proxy) const -> const Node &;
+    auto allocate_node() -> ProxyId;
+    auto free_node(ProxyId proxy) -> void;
+    auto fatten(const Aabb &aabb) const -> Aabb;
+    auto insert_leaf(ProxyId leaf) -> void;
+    auto remove_leaf(ProxyId leaf) -> void;
+    /**
+     * Refit and rebalance from a node up to the root
+     */
+    auto refit(ProxyId proxy) -> void;
+    /**
+     * Rotate a node's taller child up if its children's heights differ by
+     * more than one, returning the node now in its place
+     */
+    auto balance(ProxyId proxy) -> ProxyId;
+    auto build_range(std::vector<std::pair<Leaf, std::size_t>> &leaves, std::size_t begin,
+                     std::size_t end, std::vector<ProxyId> &proxies) -> ProxyId;
+  };
+}
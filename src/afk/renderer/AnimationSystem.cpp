@@ -0,0 +1,229 @@
+#include "afk/renderer/AnimationSystem.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#include <glm/glm.hpp>
+#include <ozz/animation/runtime/blending_job.h>
+#include <ozz/animation/runtime/local_to_model_job.h>
+#include <ozz/animation/runtime/sampling_job.h>
+#include <ozz/base/containers/vector.h>
+#include <ozz/base/maths/simd_math.h>
+#include <ozz/base/maths/soa_transform.h>
+#include <ozz/base/span.h>
+
+#include "afk/Afk.hpp"
+#include "afk/component/AnimComponent.hpp"
+#include "afk/debug/Assert.hpp"
+#include "afk/debug/Profiler.hpp"
+#include "afk/io/ModelSource.hpp"
+#include "afk/memory/FrameArena.hpp"
+#include "afk/renderer/Rig.hpp"
+
+using Afk::AnimComponent;
+
+using Pose = ozz::span<const ozz::math::SoaTransform>;
+
+/**
+ * An entity to sample, and where its skinning matrices start in the frame
+ * packet
+ */
+struct PoseJob {
+  const AnimComponent *anim = nullptr;
+  std::uint32_t first_bone  = {};
+};
+/**
+ * Buffers a pose is built in, one set per thread so entities only keep
+ * their sampling caches
+ */
+struct Scratch {
+  ozz::vector<ozz::math::SoaTransform> locals        = {};
+  ozz::vector<ozz::math::SoaTransform> fading_locals = {};
+  ozz::vector<ozz::math::SoaTransform> blended       = {};
+  ozz::vector<ozz::math::Float4x4> models            = {};
+};
+
+template<typename T>
+static auto reserve(ozz::vector<T> &buffer, int size) -> void {
+  if (buffer.size() < static_cast<std::size_t>(size)) {
+    buffer.resize(static_cast<std::size_t>(size));
+  }
+}
+
+static auto to_glm(const ozz::math::Float4x4 &m) -> glm::mat4 {
+  auto matrix = glm::mat4{};
+
+  for (auto column = 0; column < 4; ++column) {
+    ozz::math::StorePtrU(m.cols[column], &matrix[column][0]);
+  }
+
+  return matrix;
+}
+
+/**
+ * Sample a clip at a time, looping past its end
+ */
+static auto sample(const ozz::animation::Animation &clip, ozz::animation::SamplingCache *cache,
+                   float time, ozz::vector<ozz::math::SoaTransform> &locals) -> Pose {
+  const auto duration = clip.duration();
+
+  auto job      = ozz::animation::SamplingJob{};
+  job.animation = &clip;
+  job.cache     = cache;
+  job.ratio     = duration > 0.0f ? std::fmod(time, duration) / duration : 0.0f;
+  job.output    = ozz::make_span(locals);
+
+  [[maybe_unused]] const auto is_sampled = job.Run();
+  afk_assert_debug(is_sampled, "Failed to sample animation");
+
+  const auto &sampled = locals;
+  return ozz::make_span(sampled);
+}
+
+static auto sample_pose(const AnimComponent &anim, glm::mat4 *bones) -> void {
+  thread_local auto scratch = Scratch{};
+
+  const auto &sampler  = anim.sampler;
+  const auto &rig      = *sampler.rig;
+  const auto &skeleton = *rig.skeleton;
+
+  reserve(scratch.locals, skeleton.num_soa_joints());
+  reserve(scratch.fading_locals, skeleton.num_soa_joints());
+  reserve(scratch.blended, skeleton.num_soa_joints());
+  reserve(scratch.models, skeleton.num_joints());
+
+  // Missing clips hold the rest pose rather than leaving the mesh unskinned.
+  auto pose = Pose{skeleton.joint_bind_poses()};
+
+  if (sampler.clip != nullptr) {
+    pose = sample(*sampler.clip, sampler.cache.get(), anim.time, scratch.locals);
+  }
+
+  if (anim.fade < 1.0f && sampler.fading_clip != nullptr) {
+    const auto fading = sample(*sampler.fading_clip, sampler.fading_cache.get(),
+                               anim.fading_time, scratch.fading_locals);
+
+    ozz::animation::BlendingJob::Layer layers[2] = {};
+
+    layers[0].transform = pose;
+    layers[0].weight    = anim.fade;
+    layers[1].transform = fading;
+    layers[1].weight    = 1.0f - anim.fade;
+
+    auto job      = ozz::animation::BlendingJob{};
+    job.layers    = layers;
+    job.bind_pose = skeleton.joint_bind_poses();
+    job.output    = ozz::make_span(scratch.blended);
+
+    [[maybe_unused]] const auto is_blended = job.Run();
+    afk_assert_debug(is_blended, "Failed to blend animations");
+
+    const auto &blended = scratch.blended;
+    pose                = ozz::make_span(blended);
+  }
+
+  auto job     = ozz::animation::LocalToModelJob{};
+  job.skeleton = &skeleton;
+  job.input    = pose;
+  job.output   = ozz::make_span(scratch.models);
+
+  [[maybe_unused]] const auto is_converted = job.Run();
+  afk_assert_debug(is_converted, "Failed to convert pose to model space");
+
+  for (auto i = std::size_t{0}; i < rig.bones.size(); ++i) {
+    const auto &bone = rig.bones[i];
+    const auto &mesh = rig.mesh_inverses[bone.mesh];
+
+    bones[i] = to_glm(mesh * scratch.models[static_cast<std::size_t>(bone.joint)] * bone.offset);
+  }
+}
+
+auto Afk::advance_animations(entt::registry *registry, float dt) -> void {
+  afk_profile_zone("advance_animations");
+  registry->view<AnimComponent>().each([dt]([[maybe_unused]] const auto entity, auto &anim) {
+    switch (anim.status) {
+      case AnimComponent::Status::Playing: {
+        anim.time += dt;
+        anim.fading_time += dt;
+        anim.fade = anim.fade_time > 0.0f ? std::min(anim.fade + dt / anim.fade_time, 1.0f)
+                                          : 1.0f;
+
+        // Keep the time within the clip, so it doesn't lose precision.
+        if (const auto *clip = anim.sampler.clip; clip != nullptr && clip->duration() > 0.0f) {
+          anim.time = std::fmod(anim.time, clip->duration());
+        }
+        break;
+      }
+      case AnimComponent::Status::Paused: {
+        break;
+      }
+      case AnimComponent::Status::Stopped: {
+        anim.time = 0.0f;
+        anim.fade = 1.0f;
+        break;
+      }
+    }
+  });
+}
+
+auto Afk::queue_poses(entt::registry *registry, Afk::Renderer *renderer,
+                      const GameObject *entities, std::size_t count,
+                      std::optional<std::uint32_t> *bones) -> void {
+  afk_profile_zone("queue_poses");
+  auto &afk = Afk::Engine::get();
+  auto jobs = Memory::FrameVector<PoseJob>{Memory::FrameAllocator<PoseJob>{&afk.frame_arena}};
+
+  // Find each entity's rig and clips, and make room for its skinning
+  // matrices, before any are sampled.
+  for (auto i = std::size_t{0}; i < count; ++i) {
+    auto *anim = registry->try_get<AnimComponent>(entities[i]);
+
+    if (anim == nullptr) {
+      continue;
+    }
+
+    auto &sampler    = anim->sampler;
+    const auto model = registry->get<ModelSource>(entities[i]).get_model_id();
+
+    // Rigs are ready once the model has loaded, and change with the model.
+    if (sampler.rig == nullptr || sampler.model != model) {
+      sampler.model            = model;
+      sampler.rig              = renderer->get_model_rig(model);
+      sampler.clip             = nullptr;
+      sampler.fading_clip      = nullptr;
+      sampler.clip_name        = {};
+      sampler.fading_clip_name = {};
+
+      if (sampler.rig == nullptr) {
+        continue;
+      }
+
+      const auto num_joints = sampler.rig->skeleton->num_joints();
+      sampler.cache         = std::make_unique<ozz::animation::SamplingCache>(num_joints);
+      sampler.fading_cache  = std::make_unique<ozz::animation::SamplingCache>(num_joints);
+    }
+
+    // Clips are looked up by name only when the name changes.
+    if (sampler.clip == nullptr || sampler.clip_name != anim->name) {
+      sampler.clip      = sampler.rig->find_clip(anim->name);
+      sampler.clip_name = anim->name;
+    }
+
+    if (anim->fade < 1.0f &&
+        (sampler.fading_clip == nullptr || sampler.fading_clip_name != anim->fading_name)) {
+      sampler.fading_clip      = sampler.rig->find_clip(anim->fading_name);
+      sampler.fading_clip_name = anim->fading_name;
+    }
+
+    bones[i] = renderer->queue_bones(sampler.rig->bones.size());
+    jobs.push_back({anim, *bones[i]});
+  }
+
+  // Every palette is queued, so the bones won't move while they're written.
+  auto *queued = renderer->get_queued_bones();
+
+  afk.job_system.parallel_for(0, jobs.size(), [&jobs, queued](std::size_t i) {
+    sample_pose(*jobs[i].anim, queued + jobs[i].first_bone);
+  });
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include <entt/entt.hpp>
+
+#include "afk/component/GameObject.hpp"
+#include "afk/renderer/Renderer.hpp"
+
+namespace Afk {
+  /**
+   * Advance every playing animation and the fade out of the one before it
+   */
+  auto advance_animations(entt::registry *registry, float dt) -> void;
+  /**
+   * Sample and blend the pose of every entity with an animation, in parallel,
+   * writing their skinning matrices straight into the renderer's frame packet
+   * \param bones set to where each entity's skinning matrices start, left
+   * empty for those with nothing to skin
+   */
+  auto queue_poses(entt::registry *registry, Afk::Renderer *renderer,
+                   const GameObject *entities, std::size_t count,
+                   std::optional<std::uint32_t> *bones) -> void;
+}
@@ -0,0 +1,66 @@
+#include "afk/renderer/Bounds.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using glm::mat3;
+using glm::mat4;
+using glm::vec3;
+using glm::vec4;
+
+using Afk::Aabb;
+using Afk::BoundingSphere;
+
+auto Aabb::get_center() const -> vec3 {
+  return (this->min + this->max) * 0.5f;
+}
+
+auto Aabb::get_extents() const -> vec3 {
+  return (this->max - this->min) * 0.5f;
+}
+
+auto Aabb::get_surface_area() const -> float {
+  const auto size = this->max - this->min;
+
+  return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+auto Aabb::contains(const Aabb &other) const -> bool {
+  return this->min.x <= other.min.x && this->min.y <= other.min.y &&
+         this->min.z <= other.min.z && other.max.x <= this->max.x &&
+         other.max.y <= this->max.y && other.max.z <= this->max.z;
+}
+
+auto Afk::merge_aabbs(const Aabb &a, const Aabb &b) -> Aabb {
+  return {glm::min(a.min, b.min), glm::max(a.max, b.max)};
+}
+
+auto Afk::intersects(const Aabb &aabb, const BoundingSphere &sphere) -> bool {
+  const auto closest = glm::clamp(sphere.center, aabb.min, aabb.max);
+  const auto offset  = closest - sphere.center;
+
+  return glm::dot(offset, offset) <= sphere.radius * sphere.radius;
+}
+
+auto Afk::transform_aabb(const Aabb &aabb, const mat4 &transform) -> Aabb {
+  // Each axis of the new box reaches as far as the transformed extents do
+  // along it, which is the extents through the absolute rotation and scale.
+  const auto center = vec3{transform * vec4{aabb.get_center(), 1.0f}};
+  auto basis        = mat3{transform};
+
+  for (auto i = 0; i < 3; ++i) {
+    basis[i] = glm::abs(basis[i]);
+  }
+
+  const auto extents = basis * aabb.get_extents();
+
+  return {center - extents, center + extents};
+}
+
+auto Afk::transform_sphere(const BoundingSphere &sphere, const mat4 &transform)
+    -> BoundingSphere {
+  const auto scale = std::max({glm::length(vec3{transform[0]}), glm::length(vec3{transform[1]}),
+                               glm::length(vec3{transform[2]})});
+
+  return {vec3{transform * vec4{sphere.center, 1.0f}}, sphere.radius * scale};
+}
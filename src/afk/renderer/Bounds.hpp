@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace Afk {
+  /**
+   * Axis aligned bounding box
+   */
+  struct Aabb {
+    glm::vec3 min = {};
+    glm::vec3 max = {};
+
+    auto get_center() const -> glm::vec3;
+    auto get_extents() const -> glm::vec3;
+    auto get_surface_area() const -> float;
+    auto contains(const Aabb &other) const -> bool;
+  };
+  /**
+   * Bounding sphere
+   */
+  struct BoundingSphere {
+    glm::vec3 center = {};
+    float radius     = {};
+  };
+
+  /**
+   * Get the box bounding two boxes
+   */
+  auto merge_aabbs(const Aabb &a, const Aabb &b) -> Aabb;
+  /**
+   * Whether a box and a sphere overlap
+   */
+  auto intersects(const Aabb &aabb, const BoundingSphere &sphere) -> bool;
+  /**
+   * Get the box bounding a box after it is transformed
+   */
+  auto transform_aabb(const Aabb &aabb, const glm::mat4 &transform) -> Aabb;
+  /**
+   * Get the sphere bounding a sphere after it is transformed
+   */
+  auto transform_sphere(const BoundingSphere &sphere, const glm::mat4 &transform)
+      -> BoundingSphere;
+}
@@ -0,0 +1,139 @@
+#include "afk/renderer/Frustum.hpp"
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define AFK_CULL_SSE
+#include <xmmintrin.h>
+#endif
+
+using glm::mat4;
+using glm::vec3;
+using glm::vec4;
+
+using Afk::Aabb;
+using Afk::Frustum;
+using Afk::Visibility;
+
+auto Afk::make_frustum(const mat4 &view_projection) -> Frustum {
+  // Rows of the matrix, glm is column major.
+  auto rows = std::array<vec4, 4>{};
+
+  for (auto i = 0; i < 4; ++i) {
+    rows[static_cast<std::size_t>(i)] = vec4{view_projection[0][i], view_projection[1][i],
+                                             view_projection[2][i], view_projection[3][i]};
+  }
+
+  auto frustum = Frustum{{rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1],
+                          rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2]}};
+
+  for (auto &plane : frustum.planes) {
+    plane /= glm::length(vec3{plane});
+  }
+
+  return frustum;
+}
+
+auto Afk::is_visible(const Frustum &frustum, const Aabb &aabb) -> bool {
+  const auto center  = aabb.get_center();
+  const auto extents = aabb.get_extents();
+
+  // A box is outside when its corner furthest along a plane's normal is
+  // still behind the plane.
+  for (const auto &plane : frustum.planes) {
+    const auto normal   = vec3{plane};
+    const auto distance = glm::dot(normal, center) + plane.w;
+    const auto radius   = glm::dot(glm::abs(normal), extents);
+
+    if (distance + radius < 0.0f) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+auto Afk::get_visibility(const Frustum &frustum, const Aabb &aabb) -> Visibility {
+  const auto center  = aabb.get_center();
+  const auto extents = aabb.get_extents();
+  auto visibility    = Visibility::Inside;
+
+  // Wholly inside when even the corner nearest each plane is in front of it.
+  for (const auto &plane : frustum.planes) {
+    const auto normal   = vec3{plane};
+    const auto distance = glm::dot(normal, center) + plane.w;
+    const auto radius   = glm::dot(glm::abs(normal), extents);
+
+    if (distance + radius < 0.0f) {
+      return Visibility::Outside;
+    }
+
+    if (distance - radius < 0.0f) {
+      visibility = Visibility::Partial;
+    }
+  }
+
+  return visibility;
+}
+
+auto Afk::cull_aabbs(const Frustum &frustum, const Aabb *aabbs, std::size_t count,
+                     std::uint8_t *visible) -> std::size_t {
+  auto num_visible = std::size_t{0};
+  auto i           = std::size_t{0};
+
+#ifdef AFK_CULL_SSE
+  const auto half = _mm_set1_ps(0.5f);
+  const auto zero = _mm_setzero_ps();
+
+  // Four boxes a lane each, the same test as is_visible().
+  for (; i + 4 <= count; i += 4) {
+    const auto *box  = aabbs + i;
+    const auto min_x = _mm_setr_ps(box[0].min.x, box[1].min.x, box[2].min.x, box[3].min.x);
+    const auto min_y = _mm_setr_ps(box[0].min.y, box[1].min.y, box[2].min.y, box[3].min.y);
+    const auto min_z = _mm_setr_ps(box[0].min.z, box[1].min.z, box[2].min.z, box[3].min.z);
+    const auto max_x = _mm_setr_ps(box[0].max.x, box[1].max.x, box[2].max.x, box[3].max.x);
+    const auto max_y = _mm_setr_ps(box[0].max.y, box[1].max.y, box[2].max.y, box[3].max.y);
+    const auto max_z = _mm_setr_ps(box[0].max.z, box[1].max.z, box[2].max.z, box[3].max.z);
+
+    const auto center_x  = _mm_mul_ps(_mm_add_ps(min_x, max_x), half);
+    const auto center_y  = _mm_mul_ps(_mm_add_ps(min_y, max_y), half);
+    const auto center_z  = _mm_mul_ps(_mm_add_ps(min_z, max_z), half);
+    const auto extents_x = _mm_mul_ps(_mm_sub_ps(max_x, min_x), half);
+    const auto extents_y = _mm_mul_ps(_mm_sub_ps(max_y, min_y), half);
+    const auto extents_z = _mm_mul_ps(_mm_sub_ps(max_z, min_z), half);
+
+    auto outside = _mm_setzero_ps();
+
+    for (const auto &plane : frustum.planes) {
+      const auto distance = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(center_x, _mm_set1_ps(plane.x)),
+                     _mm_mul_ps(center_y, _mm_set1_ps(plane.y))),
+          _mm_add_ps(_mm_mul_ps(center_z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+      const auto radius = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(extents_x, _mm_set1_ps(std::abs(plane.x))),
+                     _mm_mul_ps(extents_y, _mm_set1_ps(std::abs(plane.y)))),
+          _mm_mul_ps(extents_z, _mm_set1_ps(std::abs(plane.z))));
+
+      outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+    }
+
+    const auto mask = _mm_movemask_ps(outside);
+
+    for (auto lane = 0; lane < 4; ++lane) {
+      const auto is_inside = ((mask >> lane) & 1) == 0;
+
+      visible[i + static_cast<std::size_t>(lane)] = is_inside ? 1 : 0;
+      num_visible += is_inside ? 1 : 0;
+    }
+  }
+#endif
+
+  for (; i < count; ++i) {
+    const auto is_inside = Afk::is_visible(frustum, aabbs[i]);
+
+    visible[i] = is_inside ? 1 : 0;
+    num_visible += is_inside ? 1 : 0;
+  }
+
+  return num_visible;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "afk/renderer/Bounds.hpp"
+
+namespace Afk {
+  /**
+   * View frustum, as planes with normals pointing into it
+   */
+  struct Frustum {
+    /**
+     * Left, right, bottom, top, near and far planes, each a normal and a
+     * distance
+     */
+    std::array<glm::vec4, 6> planes = {};
+  };
+
+  /**
+   * How much of a volume is inside a frustum
+   */
+  enum class Visibility { Outside, Partial, Inside };
+
+  /**
+   * Extract the frustum planes from a camera's projection * view matrix
+   */
+  auto make_frustum(const glm::mat4 &view_projection) -> Frustum;
+  /**
+   * Whether a box is at least partly inside a frustum
+   */
+  auto is_visible(const Frustum &frustum, const Aabb &aabb) -> bool;
+  /**
+   * Whether a box is outside, partly inside or wholly inside a frustum
+   */
+  auto get_visibility(const Frustum &frustum, const Aabb &aabb) -> Visibility;
+  /**
+   * Test boxes against a frustum, four at a time where SIMD is available
+   * \param visible set to 1 for each box at least partly inside, 0 otherwise
+   * \return the number of visible boxes
+   */
+  auto cull_aabbs(const Frustum &frustum, const Aabb *aabbs, std::size_t count,
+                  std::uint8_t *visible) -> std::size_t;
+}
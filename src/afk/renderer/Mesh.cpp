@@ -1,7 +1,12 @@
 #include "afk/renderer/Mesh.hpp"
 
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
 #include "afk/debug/Assert.hpp"
 
+using Afk::Mesh;
 using Afk::Vertex;
 
 auto Vertex::push_back_bone(Index bone_index, float bone_weight) -> void {
@@ -18,3 +23,30 @@ auto Vertex::push_back_bone(Index bone_index, float bone_weight) -> void {
 
   afk_assert(found_empty_element, "Vertex bones full");
 }
+
+auto Mesh::update_bounds() -> void {
+  if (this->vertices.empty()) {
+    this->aabb            = {};
+    this->bounding_sphere = {};
+    return;
+  }
+
+  auto aabb = Aabb{this->vertices[0].position, this->vertices[0].position};
+
+  for (const auto &vertex : this->vertices) {
+    aabb.min = glm::min(aabb.min, vertex.position);
+    aabb.max = glm::max(aabb.max, vertex.position);
+  }
+
+  // Centred on the box, which is never far off the tightest sphere for
+  // the meshes we load.
+  const auto center = aabb.get_center();
+  auto radius       = 0.0f;
+
+  for (const auto &vertex : this->vertices) {
+    radius = std::max(radius, glm::length(vertex.position - center));
+  }
+
+  this->aabb            = aabb;
+  this->bounding_sphere = {center, radius};
+}
@@ -10,6 +10,7 @@
 
 #include "afk/physics/Transform.hpp"
 #include "afk/renderer/Bone.hpp"
+#include "afk/renderer/Bounds.hpp"
 #include "afk/renderer/Index.hpp"
 #include "afk/renderer/Texture.hpp"
 
@@ -37,10 +38,16 @@ namespace Afk {
   struct Mesh {
     using Vertices = std::vector<Vertex>;
     using Indices  = std::vector<Index>;
+    using Lods     = std::vector<Indices>;
     using Textures = std::vector<Texture>;
     using Bones    = std::vector<Bone>;
     using BoneMap  = std::unordered_map<std::string, Index>;
 
+    /**
+     * Most levels of detail a mesh has, counting the full mesh
+     */
+    constexpr static size_t MAX_LODS = 4;
+
     /**
      * Meshes vertices
      */
@@ -49,6 +56,11 @@ namespace Afk {
      * Mesh indices
      */
     Indices indices = {};
+    /**
+     * Coarser levels of detail, fewest triangles last, indexing the same
+     * vertices as the full mesh
+     */
+    Lods lods = {};
     /**
      * Textures used
      */
@@ -65,5 +77,15 @@ namespace Afk {
      * Mapping between bone and index.
      */
     BoneMap bone_map    = {};
+    /**
+     * Bounds of the vertices, before the mesh transform
+     */
+    Aabb aabb                      = {};
+    BoundingSphere bounding_sphere = {};
+
+    /**
+     * Recompute the bounds from the vertices
+     */
+    auto update_bounds() -> void;
   };
 }
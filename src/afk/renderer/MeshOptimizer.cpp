@@ -0,0 +1,449 @@
+#include "afk/renderer/MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "afk/debug/Assert.hpp"
+
+using glm::vec3;
+using std::size_t;
+
+using Afk::Index;
+using Afk::Mesh;
+using Afk::MeshOptimization;
+using Afk::VertexCacheStats;
+
+/**
+ * Entries in the LRU cache Forsyth's scores model, larger than the FIFO
+ * simulated so orders suit a range of GPUs
+ */
+constexpr size_t FORSYTH_CACHE_SIZE = 32;
+constexpr float FORSYTH_DECAY_POWER = 1.5f;
+/**
+ * Score of the vertices of the last triangle, lower than the next in the
+ * cache so strips don't just turn back on themselves
+ */
+constexpr float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float FORSYTH_VALENCE_SCALE       = 2.0f;
+constexpr float FORSYTH_VALENCE_POWER       = 0.5f;
+/**
+ * Most live triangles scored from the table, more score the same
+ */
+constexpr size_t FORSYTH_MAX_VALENCE = 32;
+/**
+ * Most a cluster may cost the vertex cache over the order it came in, for
+ * optimize_mesh()
+ */
+constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+/**
+ * Get Forsyth's score of each cache position, -1 meaning out of the cache
+ */
+static auto get_cache_scores() -> std::array<float, FORSYTH_CACHE_SIZE + 1> {
+  auto scores = std::array<float, FORSYTH_CACHE_SIZE + 1>{};
+
+  for (auto position = size_t{0}; position < FORSYTH_CACHE_SIZE; ++position) {
+    if (position < 3) {
+      scores[position + 1] = FORSYTH_LAST_TRIANGLE_SCORE;
+    } else {
+      const auto scale = 1.0f / static_cast<float>(FORSYTH_CACHE_SIZE - 3);
+      scores[position + 1] =
+          std::pow(1.0f - static_cast<float>(position - 3) * scale, FORSYTH_DECAY_POWER);
+    }
+  }
+
+  return scores;
+}
+
+/**
+ * Get Forsyth's boost for vertices with few triangles left, so lone
+ * triangles aren't left behind to be drawn with a cold cache
+ */
+static auto get_valence_scores() -> std::array<float, FORSYTH_MAX_VALENCE + 1> {
+  auto scores = std::array<float, FORSYTH_MAX_VALENCE + 1>{};
+
+  for (auto valence = size_t{1}; valence <= FORSYTH_MAX_VALENCE; ++valence) {
+    scores[valence] = FORSYTH_VALENCE_SCALE *
+                      std::pow(static_cast<float>(valence), -FORSYTH_VALENCE_POWER);
+  }
+
+  return scores;
+}
+
+/**
+ * Draw a vertex through a simulated FIFO cache stamped with the time each
+ * vertex entered it, returning whether it missed. Moving time on by more
+ * than the cache size empties it.
+ */
+static auto update_cache(Index vertex, size_t cache_size, std::vector<size_t> &stamps,
+                         size_t &time) -> bool {
+  if (time - stamps[vertex] > cache_size) {
+    stamps[vertex] = time++;
+    return true;
+  }
+
+  return false;
+}
+
+auto VertexCacheStats::get_acmr() const -> float {
+  return this->triangles > 0
+             ? static_cast<float>(this->transformed) / static_cast<float>(this->triangles)
+             : 0.0f;
+}
+
+auto VertexCacheStats::get_atvr() const -> float {
+  return this->vertices > 0
+             ? static_cast<float>(this->transformed) / static_cast<float>(this->vertices)
+             : 0.0f;
+}
+
+auto Afk::analyze_vertex_cache(const Mesh::Indices &indices, size_t vertex_count,
+                               size_t cache_size) -> VertexCacheStats {
+  auto stats      = VertexCacheStats{};
+  auto stamps     = std::vector<size_t>(vertex_count, 0);
+  auto is_used    = std::vector<std::uint8_t>(vertex_count, 0);
+  auto time       = cache_size + 1;
+  stats.triangles = indices.size() / 3;
+
+  for (const auto index : indices) {
+    afk_assert_debug(index < vertex_count, "Index out of range");
+
+    if (update_cache(index, cache_size, stamps, time)) {
+      ++stats.transformed;
+    }
+
+    if (is_used[index] == 0) {
+      is_used[index] = 1;
+      ++stats.vertices;
+    }
+  }
+
+  return stats;
+}
+
+auto Afk::optimize_vertex_cache(const Mesh::Indices &indices, size_t vertex_count)
+    -> Mesh::Indices {
+  const auto triangle_count = indices.size() / 3;
+
+  if (triangle_count == 0) {
+    return indices;
+  }
+
+  static const auto cache_scores   = get_cache_scores();
+  static const auto valence_scores = get_valence_scores();
+
+  // Each vertex's live triangles, the emitted ones swapped past the end.
+  auto live    = std::vector<size_t>(vertex_count, 0);
+  auto offsets = std::vector<size_t>(vertex_count + 1, 0);
+
+  for (const auto index : indices) {
+    ++live[index];
+  }
+
+  std::partial_sum(live.begin(), live.end(), offsets.begin() + 1);
+
+  auto triangles = std::vector<size_t>(indices.size());
+  auto filled    = std::vector<size_t>(vertex_count, 0);
+
+  for (auto i = size_t{0}; i < indices.size(); ++i) {
+    const auto vertex = indices[i];
+    triangles[offsets[vertex] + filled[vertex]++] = i / 3;
+  }
+
+  const auto get_score = [](int position, size_t valence) {
+    if (valence == 0) {
+      return -1.0f;
+    }
+
+    return cache_scores[static_cast<size_t>(position + 1)] +
+           valence_scores[std::min(valence, FORSYTH_MAX_VALENCE)];
+  };
+
+  auto vertex_scores   = std::vector<float>(vertex_count);
+  auto triangle_scores = std::vector<float>(triangle_count, 0.0f);
+  auto is_emitted      = std::vector<std::uint8_t>(triangle_count, 0);
+
+  for (auto vertex = size_t{0}; vertex < vertex_count; ++vertex) {
+    vertex_scores[vertex] = get_score(-1, live[vertex]);
+  }
+
+  for (auto i = size_t{0}; i < indices.size(); ++i) {
+    triangle_scores[i / 3] += vertex_scores[indices[i]];
+  }
+
+  auto best = static_cast<size_t>(
+      std::max_element(triangle_scores.begin(), triangle_scores.end()) - triangle_scores.begin());
+  auto cursor    = size_t{0};
+  auto cache     = std::vector<Index>{};
+  auto new_cache = std::vector<Index>{};
+  auto result    = Mesh::Indices{};
+
+  cache.reserve(FORSYTH_CACHE_SIZE + 3);
+  new_cache.reserve(FORSYTH_CACHE_SIZE + 3);
+  result.reserve(indices.size());
+
+  for (auto emitted = size_t{0}; emitted < triangle_count; ++emitted) {
+    // Nothing in the cache has triangles left, so start somewhere new.
+    if (best == triangle_count) {
+      while (is_emitted[cursor] != 0) {
+        ++cursor;
+      }
+
+      best = cursor;
+    }
+
+    const auto *triangle = &indices[best * 3];
+    is_emitted[best]     = 1;
+    new_cache.clear();
+
+    for (auto corner = size_t{0}; corner < 3; ++corner) {
+      const auto vertex = triangle[corner];
+      auto *first       = &triangles[offsets[vertex]];
+      auto *last        = first + live[vertex];
+
+      result.push_back(vertex);
+      std::iter_swap(std::find(first, last, best), last - 1);
+      --live[vertex];
+
+      // Degenerate triangles use a vertex twice, but it's cached once.
+      if (std::find(new_cache.begin(), new_cache.end(), vertex) == new_cache.end()) {
+        new_cache.push_back(vertex);
+      }
+    }
+
+    for (const auto vertex : cache) {
+      if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2]) {
+        new_cache.push_back(vertex);
+      }
+    }
+
+    // Rescore everything that moved in the cache or fell out of it.
+    for (auto i = size_t{0}; i < new_cache.size(); ++i) {
+      const auto vertex   = new_cache[i];
+      const auto position = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+      const auto score    = get_score(position, live[vertex]);
+      const auto delta    = score - vertex_scores[vertex];
+
+      vertex_scores[vertex] = score;
+
+      for (auto j = offsets[vertex]; j < offsets[vertex] + live[vertex]; ++j) {
+        triangle_scores[triangles[j]] += delta;
+      }
+    }
+
+    new_cache.resize(std::min(new_cache.size(), FORSYTH_CACHE_SIZE));
+    std::swap(cache, new_cache);
+
+    // Only triangles using cached vertices changed, so the best is one of them.
+    best            = triangle_count;
+    auto best_score = std::numeric_limits<float>::lowest();
+
+    for (const auto vertex : cache) {
+      for (auto j = offsets[vertex]; j < offsets[vertex] + live[vertex]; ++j) {
+        if (triangle_scores[triangles[j]] > best_score) {
+          best       = triangles[j];
+          best_score = triangle_scores[triangles[j]];
+        }
+      }
+    }
+  }
+
+  return result;
+}
+
+auto Afk::optimize_overdraw(const Mesh::Vertices &vertices, const Mesh::Indices &indices,
+                            float threshold) -> Mesh::Indices {
+  const auto triangle_count = indices.size() / 3;
+  const auto cache_size     = VertexCacheStats::CACHE_SIZE;
+
+  if (triangle_count < 2) {
+    return indices;
+  }
+
+  // Hard boundaries are where every vertex of a triangle misses, which the
+  // vertex cache optimiser only does when it has to start over.
+  auto clusters = std::vector<size_t>{};
+  auto stamps   = std::vector<size_t>(vertices.size(), 0);
+  auto time     = cache_size + 1;
+
+  for (auto triangle = size_t{0}; triangle < triangle_count; ++triangle) {
+    auto misses = 0;
+
+    for (auto corner = size_t{0}; corner < 3; ++corner) {
+      misses += update_cache(indices[triangle * 3 + corner], cache_size, stamps, time) ? 1 : 0;
+    }
+
+    if (misses == 3) {
+      clusters.push_back(triangle);
+    }
+  }
+
+  clusters.push_back(triangle_count);
+
+  // Soft boundaries split clusters further wherever starting with a cold
+  // cache would cost little more than the cluster already does.
+  auto soft_clusters = std::vector<size_t>{};
+
+  for (auto i = size_t{0}; i + 1 < clusters.size(); ++i) {
+    const auto start = clusters[i];
+    const auto end   = clusters[i + 1];
+
+    auto cluster_cost = size_t{0};
+    time += cache_size + 1;
+
+    for (auto j = start * 3; j < end * 3; ++j) {
+      cluster_cost += update_cache(indices[j], cache_size, stamps, time) ? 1 : 0;
+    }
+
+    const auto limit =
+        threshold * static_cast<float>(cluster_cost) / static_cast<float>(end - start);
+
+    auto misses = size_t{0};
+    auto first  = start;
+    time += cache_size + 1;
+    soft_clusters.push_back(start);
+
+    for (auto triangle = start; triangle < end; ++triangle) {
+      for (auto corner = size_t{0}; corner < 3; ++corner) {
+        misses += update_cache(indices[triangle * 3 + corner], cache_size, stamps, time) ? 1 : 0;
+      }
+
+      const auto count = triangle - first + 1;
+
+      if (triangle + 1 < end &&
+          static_cast<float>(misses) / static_cast<float>(count) <= limit) {
+        soft_clusters.push_back(triangle + 1);
+        time += cache_size + 1;
+        misses = 0;
+        first  = triangle + 1;
+      }
+    }
+  }
+
+  soft_clusters.push_back(triangle_count);
+
+  // Sort clusters by how far they face out from the mesh's centre.
+  auto mesh_center = vec3{0.0f};
+  auto mesh_area   = 0.0f;
+  auto centers     = std::vector<vec3>(soft_clusters.size() - 1, vec3{0.0f});
+  auto normals     = std::vector<vec3>(soft_clusters.size() - 1, vec3{0.0f});
+  auto areas       = std::vector<float>(soft_clusters.size() - 1, 0.0f);
+
+  for (auto i = size_t{0}; i + 1 < soft_clusters.size(); ++i) {
+    for (auto triangle = soft_clusters[i]; triangle < soft_clusters[i + 1]; ++triangle) {
+      const auto &a     = vertices[indices[triangle * 3]].position;
+      const auto &b     = vertices[indices[triangle * 3 + 1]].position;
+      const auto &c     = vertices[indices[triangle * 3 + 2]].position;
+      const auto normal = glm::cross(b - a, c - a);
+      const auto area   = glm::length(normal);
+
+      centers[i] += (a + b + c) * (area / 3.0f);
+      normals[i] += normal;
+      areas[i] += area;
+    }
+
+    mesh_center += centers[i];
+    mesh_area += areas[i];
+  }
+
+  mesh_center = mesh_area > 0.0f ? mesh_center / mesh_area : mesh_center;
+
+  auto facing = std::vector<float>(centers.size(), 0.0f);
+
+  for (auto i = size_t{0}; i < centers.size(); ++i) {
+    const auto normal_length = glm::length(normals[i]);
+
+    if (areas[i] > 0.0f && normal_length > 0.0f) {
+      facing[i] = glm::dot(centers[i] / areas[i] - mesh_center, normals[i] / normal_length);
+    }
+  }
+
+  auto order = std::vector<size_t>(centers.size());
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::stable_sort(order.begin(), order.end(),
+                   [&facing](size_t a, size_t b) { return facing[a] > facing[b]; });
+
+  auto result = Mesh::Indices{};
+  result.reserve(indices.size());
+
+  for (const auto cluster : order) {
+    result.insert(result.end(), indices.begin() + soft_clusters[cluster] * 3,
+                  indices.begin() + soft_clusters[cluster + 1] * 3);
+  }
+
+  return result;
+}
+
+auto Afk::optimize_vertex_fetch(Mesh &mesh) -> void {
+  constexpr auto UNUSED = std::numeric_limits<Index>::max();
+
+  auto remap = std::vector<Index>(mesh.vertices.size(), UNUSED);
+  auto next  = Index{0};
+
+  const auto visit = [&remap, &next](const Mesh::Indices &indices) {
+    for (const auto index : indices) {
+      if (remap[index] == UNUSED) {
+        remap[index] = next++;
+      }
+    }
+  };
+
+  visit(mesh.indices);
+
+  for (const auto &lod : mesh.lods) {
+    visit(lod);
+  }
+
+  // Vertices nothing draws are kept, after the rest.
+  for (auto &index : remap) {
+    if (index == UNUSED) {
+      index = next++;
+    }
+  }
+
+  auto vertices = Mesh::Vertices(mesh.vertices.size());
+
+  for (auto i = size_t{0}; i < mesh.vertices.size(); ++i) {
+    vertices[remap[i]] = mesh.vertices[i];
+  }
+
+  mesh.vertices = std::move(vertices);
+
+  for (auto &index : mesh.indices) {
+    index = remap[index];
+  }
+
+  for (auto &lod : mesh.lods) {
+    for (auto &index : lod) {
+      index = remap[index];
+    }
+  }
+}
+
+auto Afk::optimize_mesh(Mesh &mesh) -> MeshOptimization {
+  const auto vertex_count = mesh.vertices.size();
+  auto optimization       = MeshOptimization{};
+
+  optimization.before = Afk::analyze_vertex_cache(mesh.indices, vertex_count);
+
+  mesh.indices = Afk::optimize_vertex_cache(mesh.indices, vertex_count);
+  mesh.indices = Afk::optimize_overdraw(mesh.vertices, mesh.indices, OVERDRAW_THRESHOLD);
+
+  // Distant levels of detail are small on screen, so overdraw barely matters.
+  for (auto &lod : mesh.lods) {
+    lod = Afk::optimize_vertex_cache(lod, vertex_count);
+  }
+
+  Afk::optimize_vertex_fetch(mesh);
+
+  optimization.after = Afk::analyze_vertex_cache(mesh.indices, vertex_count);
+
+  return optimization;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+
+#include "afk/renderer/Mesh.hpp"
+
+namespace Afk {
+  /**
+   * What drawing indices costs the post-transform vertex cache, simulated
+   * as a FIFO the size of a typical GPU's
+   */
+  struct VertexCacheStats {
+    /**
+     * Entries in the simulated cache
+     */
+    static constexpr std::size_t CACHE_SIZE = 16;
+
+    /**
+     * Vertices the GPU transforms, once per cache miss
+     */
+    std::size_t transformed = {};
+    std::size_t triangles   = {};
+    /**
+     * Distinct vertices the indices use
+     */
+    std::size_t vertices = {};
+
+    /**
+     * Get the average cache miss ratio, vertices transformed per triangle,
+     * from 3 at worst down to about 0.5 for a regular grid
+     */
+    auto get_acmr() const -> float;
+    /**
+     * Get the average transform to vertex ratio, vertices transformed per
+     * vertex used, 1 at best
+     */
+    auto get_atvr() const -> float;
+  };
+  /**
+   * Vertex cache use of a mesh's full level of detail, before and after
+   * optimize_mesh()
+   */
+  struct MeshOptimization {
+    VertexCacheStats before = {};
+    VertexCacheStats after  = {};
+  };
+
+  /**
+   * Simulate drawing indices through the vertex cache
+   */
+  auto analyze_vertex_cache(const Mesh::Indices &indices, std::size_t vertex_count,
+                            std::size_t cache_size = VertexCacheStats::CACHE_SIZE)
+      -> VertexCacheStats;
+  /**
+   * Reorder triangles so vertices are reused while still in the cache, with
+   * Forsyth's linear speed algorithm
+   */
+  auto optimize_vertex_cache(const Mesh::Indices &indices, std::size_t vertex_count)
+      -> Mesh::Indices;
+  /**
+   * Reorder clusters of triangles so those facing out from the mesh come
+   * first and hide what's behind them, in the style of Tipsify. Clusters
+   * are cut where the cache would miss anyway, or where that costs at most
+   * threshold times the cluster's cache miss ratio, so expects indices
+   * already optimised for the vertex cache.
+   */
+  auto optimize_overdraw(const Mesh::Vertices &vertices, const Mesh::Indices &indices,
+                         float threshold) -> Mesh::Indices;
+  /**
+   * Reorder a mesh's vertices into the order its indices first use them,
+   * remapping every level of detail, so vertices are fetched in order
+   */
+  auto optimize_vertex_fetch(Mesh &mesh) -> void;
+  /**
+   * Optimise a mesh's triangles for the vertex cache then overdraw, its
+   * levels of detail for the vertex cache, and its vertices for fetching
+   */
+  auto optimize_mesh(Mesh &mesh) -> MeshOptimization;
+}
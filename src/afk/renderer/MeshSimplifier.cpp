@@ -0,0 +1,389 @@
+#include "afk/renderer/MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+using glm::vec3;
+using std::size_t;
+
+using Afk::Index;
+using Afk::Mesh;
+using Afk::Vertex;
+
+/**
+ * Fraction of the full mesh's triangles each level of detail aims for
+ */
+constexpr auto LOD_RATIOS = std::array<float, Mesh::MAX_LODS - 1>{0.5f, 0.25f, 0.125f};
+/**
+ * Furthest each level of detail may move the surface, as a fraction of the
+ * mesh's bounding radius
+ */
+constexpr auto LOD_ERRORS = std::array<float, Mesh::MAX_LODS - 1>{0.01f, 0.03f, 0.08f};
+/**
+ * Meshes this small aren't worth simplifying
+ */
+constexpr size_t MIN_LOD_TRIANGLES = 32;
+/**
+ * Most of the triangles of the last level a new level can keep and still be
+ * worth drawing instead
+ */
+constexpr float MAX_LOD_KEPT = 0.8f;
+/**
+ * Cosine of the furthest a collapse may turn a triangle
+ */
+constexpr float MIN_NORMAL_COS = 0.5f;
+
+/**
+ * Sum of squared distances to a set of planes
+ */
+struct Quadric {
+  double a00 = {};
+  double a01 = {};
+  double a02 = {};
+  double a11 = {};
+  double a12 = {};
+  double a22 = {};
+  double b0  = {};
+  double b1  = {};
+  double b2  = {};
+  double c   = {};
+
+  auto add_plane(const vec3 &normal, float distance) -> void {
+    const auto x = double{normal.x};
+    const auto y = double{normal.y};
+    const auto z = double{normal.z};
+    const auto d = double{distance};
+
+    this->a00 += x * x;
+    this->a01 += x * y;
+    this->a02 += x * z;
+    this->a11 += y * y;
+    this->a12 += y * z;
+    this->a22 += z * z;
+    this->b0 += x * d;
+    this->b1 += y * d;
+    this->b2 += z * d;
+    this->c += d * d;
+  }
+
+  auto add(const Quadric &other) -> void {
+    this->a00 += other.a00;
+    this->a01 += other.a01;
+    this->a02 += other.a02;
+    this->a11 += other.a11;
+    this->a12 += other.a12;
+    this->a22 += other.a22;
+    this->b0 += other.b0;
+    this->b1 += other.b1;
+    this->b2 += other.b2;
+    this->c += other.c;
+  }
+
+  auto evaluate(const vec3 &point) const -> double {
+    const auto x = double{point.x};
+    const auto y = double{point.y};
+    const auto z = double{point.z};
+
+    return this->a00 * x * x + this->a11 * y * y + this->a22 * z * z +
+           2.0 * (this->a01 * x * y + this->a02 * x * z + this->a12 * y * z) +
+           2.0 * (this->b0 * x + this->b1 * y + this->b2 * z) + this->c;
+  }
+};
+
+/**
+ * Moving one vertex onto another
+ */
+struct Collapse {
+  Index from  = {};
+  Index to    = {};
+  double cost = {};
+};
+
+/**
+ * Get the bone with the most weight on a vertex, or -1 if it isn't skinned
+ */
+static auto get_main_bone(const Vertex &vertex) -> std::int64_t {
+  auto main = size_t{0};
+
+  for (auto i = size_t{1}; i < Vertex::MAX_VERTEX_BONES; ++i) {
+    if (vertex.bone_weights[i] > vertex.bone_weights[main]) {
+      main = i;
+    }
+  }
+
+  return vertex.bone_weights[main] > 0.0f ? std::int64_t{vertex.bone_indices[main]} : -1;
+}
+
+/**
+ * Find the vertices that can't move without tearing or shrinking the mesh
+ */
+static auto get_locked_vertices(const Mesh::Vertices &vertices, const Mesh::Indices &indices)
+    -> std::vector<std::uint8_t> {
+  auto locked = std::vector<std::uint8_t>(vertices.size(), std::uint8_t{0});
+  auto order  = std::vector<Index>(vertices.size());
+
+  // Vertices sharing a position are split on a normal or UV seam.
+  std::iota(order.begin(), order.end(), Index{0});
+  std::sort(order.begin(), order.end(), [&vertices](Index lhs, Index rhs) {
+    const auto &a = vertices[lhs].position;
+    const auto &b = vertices[rhs].position;
+
+    return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+  });
+
+  for (auto i = size_t{1}; i < order.size(); ++i) {
+    if (vertices[order[i]].position == vertices[order[i - 1]].position) {
+      locked[order[i]]     = 1;
+      locked[order[i - 1]] = 1;
+    }
+  }
+
+  // Edges only one triangle has are on the border.
+  auto edges = std::vector<std::pair<Index, Index>>{};
+  edges.reserve(indices.size());
+
+  for (auto i = size_t{0}; i + 2 < indices.size(); i += 3) {
+    for (auto j = size_t{0}; j < 3; ++j) {
+      const auto a = indices[i + j];
+      const auto b = indices[i + (j + 1) % 3];
+
+      edges.emplace_back(std::min(a, b), std::max(a, b));
+    }
+  }
+
+  std::sort(edges.begin(), edges.end());
+
+  for (auto i = size_t{0}; i < edges.size();) {
+    auto end = i + 1;
+
+    while (end < edges.size() && edges[end] == edges[i]) {
+      ++end;
+    }
+
+    if (end - i == 1) {
+      locked[edges[i].first]  = 1;
+      locked[edges[i].second] = 1;
+    }
+
+    i = end;
+  }
+
+  return locked;
+}
+
+/**
+ * Whether moving a vertex onto another turns any of its remaining triangles
+ * over, or far enough towards it to fold the surface
+ */
+static auto flips_triangles(const Mesh::Vertices &vertices, const Mesh::Indices &indices,
+                            const Index *triangles, size_t num_triangles, Index from, Index to)
+    -> bool {
+  for (auto i = size_t{0}; i < num_triangles; ++i) {
+    const auto *triangle = &indices[triangles[i] * size_t{3}];
+
+    // Triangles on the collapsed edge disappear.
+    if (triangle[0] == to || triangle[1] == to || triangle[2] == to) {
+      continue;
+    }
+
+    auto moved = std::array<vec3, 3>{};
+
+    for (auto j = size_t{0}; j < 3; ++j) {
+      moved[j] = vertices[triangle[j] == from ? to : triangle[j]].position;
+    }
+
+    const auto &a     = vertices[triangle[0]].position;
+    const auto before = glm::cross(vertices[triangle[1]].position - a,
+                                   vertices[triangle[2]].position - a);
+    const auto after  = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+
+    if (glm::dot(before, after) < MIN_NORMAL_COS * glm::length(before) * glm::length(after)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+auto Afk::simplify_mesh(const Mesh::Vertices &vertices, const Mesh::Indices &indices,
+                        size_t target_index_count, float max_error) -> Mesh::Indices {
+  const auto num_vertices = vertices.size();
+  const auto locked       = get_locked_vertices(vertices, indices);
+  const auto max_cost     = double{max_error} * double{max_error};
+
+  auto result   = indices;
+  auto quadrics = std::vector<Quadric>(num_vertices);
+
+  // Each vertex starts with the planes of the triangles around it.
+  for (auto i = size_t{0}; i + 2 < indices.size(); i += 3) {
+    const auto &a     = vertices[indices[i]].position;
+    const auto normal = glm::cross(vertices[indices[i + 1]].position - a,
+                                   vertices[indices[i + 2]].position - a);
+    const auto length = glm::length(normal);
+
+    if (length <= 0.0f) {
+      continue;
+    }
+
+    const auto unit = normal / length;
+
+    for (auto j = size_t{0}; j < 3; ++j) {
+      quadrics[indices[i + j]].add_plane(unit, -glm::dot(unit, a));
+    }
+  }
+
+  auto first_triangle = std::vector<Index>(num_vertices + 1);
+  auto triangles      = std::vector<Index>{};
+  auto edges          = std::vector<std::pair<Index, Index>>{};
+  auto collapses      = std::vector<Collapse>{};
+  auto remap          = std::vector<Index>(num_vertices);
+  auto touched        = std::vector<std::uint8_t>(num_vertices);
+
+  // Each pass collapses the cheapest edges whose neighbourhoods don't
+  // overlap, then rebuilds the triangles.
+  while (result.size() > target_index_count) {
+    std::fill(first_triangle.begin(), first_triangle.end(), Index{0});
+
+    for (const auto index : result) {
+      ++first_triangle[index + 1];
+    }
+
+    std::partial_sum(first_triangle.begin(), first_triangle.end(), first_triangle.begin());
+    triangles.resize(result.size());
+
+    auto cursor = std::vector<Index>(first_triangle.begin(), first_triangle.end() - 1);
+
+    for (auto i = size_t{0}; i < result.size(); ++i) {
+      triangles[cursor[result[i]]++] = static_cast<Index>(i / 3);
+    }
+
+    edges.clear();
+
+    for (auto i = size_t{0}; i < result.size(); i += 3) {
+      for (auto j = size_t{0}; j < 3; ++j) {
+        const auto a = result[i + j];
+        const auto b = result[i + (j + 1) % 3];
+
+        edges.emplace_back(std::min(a, b), std::max(a, b));
+      }
+    }
+
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    collapses.clear();
+
+    for (const auto &[a, b] : edges) {
+      if (get_main_bone(vertices[a]) != get_main_bone(vertices[b])) {
+        continue;
+      }
+
+      auto best = Collapse{a, b, max_cost};
+      auto any  = false;
+
+      for (const auto &[from, to] : {std::pair{a, b}, std::pair{b, a}}) {
+        if (locked[from] != 0) {
+          continue;
+        }
+
+        const auto &position = vertices[to].position;
+        const auto cost = quadrics[from].evaluate(position) + quadrics[to].evaluate(position);
+
+        if (cost <= best.cost) {
+          best = {from, to, cost};
+          any  = true;
+        }
+      }
+
+      if (any) {
+        collapses.push_back(best);
+      }
+    }
+
+    std::sort(collapses.begin(), collapses.end(),
+              [](const Collapse &lhs, const Collapse &rhs) { return lhs.cost < rhs.cost; });
+    std::fill(touched.begin(), touched.end(), std::uint8_t{0});
+    std::iota(remap.begin(), remap.end(), Index{0});
+
+    // Collapsing an edge takes about two triangles.
+    const auto budget = (result.size() - target_index_count) / 6 + 1;
+    auto collapsed    = size_t{0};
+
+    for (const auto &[from, to, cost] : collapses) {
+      if (collapsed == budget) {
+        break;
+      }
+
+      const auto *around    = &triangles[first_triangle[from]];
+      const auto num_around = size_t{first_triangle[from + 1] - first_triangle[from]};
+
+      if (touched[from] != 0 || touched[to] != 0 ||
+          flips_triangles(vertices, result, around, num_around, from, to)) {
+        continue;
+      }
+
+      remap[from] = to;
+      quadrics[to].add(quadrics[from]);
+
+      for (auto i = size_t{0}; i < num_around; ++i) {
+        for (auto j = size_t{0}; j < 3; ++j) {
+          touched[result[around[i] * size_t{3} + j]] = 1;
+        }
+      }
+
+      ++collapsed;
+    }
+
+    if (collapsed == 0) {
+      break;
+    }
+
+    auto kept = size_t{0};
+
+    for (auto i = size_t{0}; i < result.size(); i += 3) {
+      const auto a = remap[result[i]];
+      const auto b = remap[result[i + 1]];
+      const auto c = remap[result[i + 2]];
+
+      if (a != b && b != c && a != c) {
+        result[kept++] = a;
+        result[kept++] = b;
+        result[kept++] = c;
+      }
+    }
+
+    result.resize(kept);
+  }
+
+  return result;
+}
+
+auto Afk::generate_lods(Mesh &mesh) -> void {
+  mesh.lods.clear();
+
+  const auto num_triangles = mesh.indices.size() / 3;
+
+  for (auto i = size_t{0}; i < LOD_RATIOS.size(); ++i) {
+    const auto target = static_cast<size_t>(static_cast<float>(num_triangles) * LOD_RATIOS[i]);
+
+    if (target < MIN_LOD_TRIANGLES) {
+      break;
+    }
+
+    // Each level simplifies the last, which is quicker than the full mesh.
+    const auto &last = mesh.lods.empty() ? mesh.indices : mesh.lods.back();
+    auto lod         = Afk::simplify_mesh(mesh.vertices, last, target * 3,
+                                  LOD_ERRORS[i] * mesh.bounding_sphere.radius);
+
+    if (static_cast<float>(lod.size()) > static_cast<float>(last.size()) * MAX_LOD_KEPT) {
+      break;
+    }
+
+    mesh.lods.push_back(std::move(lod));
+  }
+}
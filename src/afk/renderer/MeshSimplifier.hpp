@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+#include "afk/renderer/Mesh.hpp"
+
+namespace Afk {
+  /**
+   * Simplify triangles by quadric error edge collapse, moving vertices onto
+   * their neighbours rather than creating new ones, so the result indexes the
+   * same vertices with their normals, UVs and bone weights intact.
+   *
+   * Vertices on borders and attribute seams never move, and vertices only
+   * collapse onto neighbours mostly skinned to the same bone.
+   * \param target_index_count indices to stop at, if the error allows
+   * \param max_error furthest the surface may move, in mesh units
+   */
+  auto simplify_mesh(const Mesh::Vertices &vertices, const Mesh::Indices &indices,
+                     std::size_t target_index_count, float max_error) -> Mesh::Indices;
+  /**
+   * Fill a mesh's levels of detail, each about half the triangles of the
+   * last, stopping once simplifying stops paying off
+   */
+  auto generate_lods(Mesh &mesh) -> void;
+}
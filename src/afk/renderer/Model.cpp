@@ -3,6 +3,7 @@
 #include <filesystem>
 
 #include "afk/io/ModelLoader.hpp"
+#include "afk/memory/MemoryTracker.hpp"
 
 using Afk::Model;
 using Afk::ModelLoader;
@@ -13,6 +14,7 @@ Model::Model(const path &_file_path) {
   auto tmp = ModelLoader{}.load(_file_path);
 
   this->meshes    = std::move(tmp.meshes);
+  this->rig       = std::move(tmp.rig);
   this->file_path = std::move(tmp.file_path);
   this->file_dir  = std::move(tmp.file_dir);
 }
@@ -25,12 +27,16 @@ Model::Model(Afk::GameObject e, const path &_file_path) {
   auto tmp = ModelLoader{}.load(_file_path);
 
   this->meshes    = std::move(tmp.meshes);
+  this->rig       = std::move(tmp.rig);
   this->file_path = std::move(tmp.file_path);
   this->file_dir  = std::move(tmp.file_dir);
 }
 Afk::Model::Model(Afk::GameObject e, const Model &source) {
+  const auto memory_tag = Afk::Memory::TagScope{Afk::Memory::Tag::Models};
+
   this->owning_entity = e;
   this->meshes        = source.meshes;
+  this->rig           = source.rig;
   this->file_path     = source.file_path;
   this->file_dir      = source.file_dir;
 }
@@ -1,11 +1,13 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
 #include <vector>
 
 #include "afk/component/BaseComponent.hpp"
 #include "afk/renderer/Animation.hpp"
 #include "afk/renderer/Mesh.hpp"
+#include "afk/renderer/Rig.hpp"
 #include "afk/renderer/Texture.hpp"
 
 namespace Afk {
@@ -18,6 +20,11 @@ namespace Afk {
 
     Meshes meshes         = {};
     Animations animations = {};
+    /**
+     * Skeleton and animations for sampling poses, null unless the model has
+     * bones and animations
+     */
+    std::shared_ptr<const Rig> rig = {};
 
     std::filesystem::path file_path = {};
     std::filesystem::path file_dir  = {};
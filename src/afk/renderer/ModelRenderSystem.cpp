@@ -1,16 +1,43 @@
 #include "afk/renderer/ModelRenderSystem.hpp"
 
+#include <cstdint>
+#include <optional>
+
+#include "afk/Afk.hpp"
+#include "afk/debug/Profiler.hpp"
 #include "afk/io/ModelSource.hpp"
+#include "afk/memory/FrameArena.hpp"
 #include "afk/physics/Transform.hpp"
+#include "afk/renderer/AnimationSystem.hpp"
 #include "afk/renderer/Model.hpp"
 
-auto Afk::queue_models(entt::registry *registry, Afk::Renderer *renderer) -> void {
-  auto render_view = registry->view<Afk::Transform, Afk::ModelSource>();
+auto Afk::queue_models(entt::registry *registry, Afk::Renderer *renderer,
+                       Afk::RenderTree *render_tree, const Afk::Frustum &frustum, float alpha)
+    -> void {
+  afk_profile_zone("queue_models");
+  auto *arena  = &Afk::Engine::get().frame_arena;
+  auto visible = Memory::FrameVector<GameObject>{Memory::FrameAllocator<GameObject>{arena}};
+
+  // Only visit the entities in the parts of the render tree in view.
+  render_tree->update(*registry, *renderer);
+  render_tree->get_visible(*registry, frustum, visible);
+
+  // Only poses that will be drawn are sampled.
+  auto bones = Memory::FrameVector<std::optional<std::uint32_t>>(
+      visible.size(), std::nullopt, Memory::FrameAllocator<std::optional<std::uint32_t>>{arena});
+  Afk::queue_poses(registry, renderer, visible.data(), visible.size(), bones.data());
+
+  for (auto i = std::size_t{0}; i < visible.size(); ++i) {
+    const auto entity                  = visible[i];
+    const auto &model_source_component = registry->get<Afk::ModelSource>(entity);
+    auto model_transform               = registry->get<Afk::Transform>(entity);
+
+    if (const auto *previous = registry->try_get<Afk::PreviousTransform>(entity)) {
+      model_transform = Afk::interpolate(previous->transform, model_transform, alpha);
+    }
 
-  for (const auto &entity : render_view) {
-    const auto &model_source_component = render_view.get<Afk::ModelSource>(entity);
-    const auto &model_transform = render_view.get<Afk::Transform>(entity);
-    renderer->queue_draw({model_source_component.name, model_source_component.shader_program_path,
-                          model_transform, entity});
+    renderer->queue_draw({model_source_component.get_model_id(),
+                          model_source_component.get_shader_program_id(),
+                          model_transform, entity, bones[i]});
   }
 }
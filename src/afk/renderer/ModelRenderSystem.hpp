@@ -2,11 +2,18 @@
 
 #include <entt/entt.hpp>
 
+#include "afk/renderer/Frustum.hpp"
+#include "afk/renderer/RenderTree.hpp"
 #include "afk/renderer/Renderer.hpp"
 
 namespace Afk {
   /**
-   * Queue models from ECS to the renderer for rendering
+   * Queue models from ECS that may be in view to the renderer for rendering
+   * \param frustum camera frustum, models outside it are skipped
+   * \param alpha interpolation factor between the previous and current
+   * simulation state
    */
-  auto queue_models(entt::registry *registry, Afk::Renderer *renderer) -> void;
+  auto queue_models(entt::registry *registry, Afk::Renderer *renderer,
+                    Afk::RenderTree *render_tree, const Afk::Frustum &frustum,
+                    float alpha = 1.0f) -> void;
 };
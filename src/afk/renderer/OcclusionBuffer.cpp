@@ -0,0 +1,234 @@
+#include "afk/renderer/OcclusionBuffer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define AFK_OCCLUSION_SSE
+#include <xmmintrin.h>
+#endif
+
+#include "afk/debug/Assert.hpp"
+
+using glm::mat4;
+using glm::vec3;
+using glm::vec4;
+
+using Afk::Aabb;
+using Afk::OccluderMesh;
+using Afk::OcclusionBuffer;
+
+/**
+ * An edge function a * x + b * y + c, positive on the inside of the edge
+ * from p to q when the triangle winds counter clockwise
+ */
+struct Edge {
+  float a = {};
+  float b = {};
+  float c = {};
+
+  Edge(const vec3 &p, const vec3 &q)
+    : a(p.y - q.y), b(q.x - p.x), c(p.x * q.y - p.y * q.x) {}
+};
+
+/**
+ * Whether a clip space position is behind the near plane
+ */
+static auto is_behind_near(const vec4 &clip) -> bool {
+  return clip.z < -clip.w;
+}
+
+OcclusionBuffer::OcclusionBuffer(int _width, int _height)
+  : width((_width + 3) & ~3), height(_height) {
+  afk_assert(_width > 0 && _height > 0, "Occlusion buffer must have pixels");
+
+  this->depth.resize(static_cast<std::size_t>(this->width * this->height), 1.0f);
+}
+
+auto OcclusionBuffer::clear() -> void {
+  std::fill(this->depth.begin(), this->depth.end(), 1.0f);
+}
+
+auto OcclusionBuffer::rasterize(const mat4 &transform, const OccluderMesh &mesh) -> void {
+  const auto size = vec3{static_cast<float>(this->width), static_cast<float>(this->height), 1.0f};
+
+  for (auto i = std::size_t{0}; i + 2 < mesh.indices.size(); i += 3) {
+    auto clip = std::array<vec4, 3>{};
+
+    for (auto j = std::size_t{0}; j < 3; ++j) {
+      clip[j] = transform * vec4{mesh.positions[mesh.indices[i + j]], 1.0f};
+    }
+
+    // Clipping would only add occlusion, so don't bother.
+    if (is_behind_near(clip[0]) || is_behind_near(clip[1]) || is_behind_near(clip[2])) {
+      continue;
+    }
+
+    auto screen = std::array<vec3, 3>{};
+
+    for (auto j = std::size_t{0}; j < 3; ++j) {
+      screen[j] = (vec3{clip[j]} / clip[j].w * 0.5f + vec3{0.5f}) * size;
+    }
+
+    this->rasterize_triangle(screen[0], screen[1], screen[2]);
+  }
+}
+
+auto OcclusionBuffer::is_visible(const mat4 &view_projection, const Aabb &aabb) const -> bool {
+  auto min      = vec3{std::numeric_limits<float>::max()};
+  auto max      = vec3{std::numeric_limits<float>::lowest()};
+  const auto fb = vec3{static_cast<float>(this->width), static_cast<float>(this->height), 1.0f};
+
+  // Screen rectangle and nearest depth of the box's corners.
+  for (auto i = 0; i < 8; ++i) {
+    const auto corner = vec3{(i & 1) != 0 ? aabb.max.x : aabb.min.x,
+                             (i & 2) != 0 ? aabb.max.y : aabb.min.y,
+                             (i & 4) != 0 ? aabb.max.z : aabb.min.z};
+    const auto clip   = view_projection * vec4{corner, 1.0f};
+
+    // Reaches past the camera, so could cover anything.
+    if (is_behind_near(clip)) {
+      return true;
+    }
+
+    const auto screen = (vec3{clip} / clip.w * 0.5f + vec3{0.5f}) * fb;
+    min               = glm::min(min, screen);
+    max               = glm::max(max, screen);
+  }
+
+  const auto min_x = std::max(0, static_cast<int>(std::floor(min.x)));
+  const auto max_x = std::min(this->width - 1, static_cast<int>(std::floor(max.x)));
+  const auto min_y = std::max(0, static_cast<int>(std::floor(min.y)));
+  const auto max_y = std::min(this->height - 1, static_cast<int>(std::floor(max.y)));
+
+  // Off screen is for the frustum test to decide.
+  if (min_x > max_x || min_y > max_y) {
+    return true;
+  }
+
+  for (auto y = min_y; y <= max_y; ++y) {
+    const auto *row = this->depth.data() + y * this->width;
+    auto x          = min_x & ~3;
+
+#ifdef AFK_OCCLUSION_SSE
+    const auto box_depth = _mm_set1_ps(min.z);
+    const auto first     = _mm_set1_ps(static_cast<float>(min_x));
+    const auto last      = _mm_set1_ps(static_cast<float>(max_x));
+
+    // Visible if the box is nearer than anything drawn at any of its pixels.
+    for (; x <= max_x; x += 4) {
+      const auto xs     = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)),
+                                 _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+      const auto inside = _mm_and_ps(_mm_cmpge_ps(xs, first), _mm_cmple_ps(xs, last));
+      const auto nearer = _mm_cmple_ps(box_depth, _mm_loadu_ps(row + x));
+
+      if (_mm_movemask_ps(_mm_and_ps(inside, nearer)) != 0) {
+        return true;
+      }
+    }
+#else
+    for (x = min_x; x <= max_x; ++x) {
+      if (min.z <= row[x]) {
+        return true;
+      }
+    }
+#endif
+  }
+
+  return false;
+}
+
+auto OcclusionBuffer::get_width() const -> int {
+  return this->width;
+}
+
+auto OcclusionBuffer::get_height() const -> int {
+  return this->height;
+}
+
+auto OcclusionBuffer::get_depth() const -> const std::vector<float> & {
+  return this->depth;
+}
+
+auto OcclusionBuffer::rasterize_triangle(const vec3 &a, const vec3 &b, const vec3 &c) -> void {
+  auto p0 = a;
+  auto p1 = b;
+  auto p2 = c;
+
+  auto area = (p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x);
+
+  if (std::abs(area) < 1e-6f) {
+    return;
+  }
+
+  // Occluders are drawn from both sides, wind them all the same way.
+  if (area < 0.0f) {
+    std::swap(p1, p2);
+    area = -area;
+  }
+
+  const auto min_x = std::max(0, static_cast<int>(std::floor(std::min({p0.x, p1.x, p2.x}))));
+  const auto max_x =
+      std::min(this->width - 1, static_cast<int>(std::ceil(std::max({p0.x, p1.x, p2.x}))));
+  const auto min_y = std::max(0, static_cast<int>(std::floor(std::min({p0.y, p1.y, p2.y}))));
+  const auto max_y =
+      std::min(this->height - 1, static_cast<int>(std::ceil(std::max({p0.y, p1.y, p2.y}))));
+
+  if (min_x > max_x || min_y > max_y) {
+    return;
+  }
+
+  // Each edge's function is the weight of the vertex opposite it, so depth
+  // is a plane through the same terms.
+  const auto e0      = Edge{p1, p2};
+  const auto e1      = Edge{p2, p0};
+  const auto e2      = Edge{p0, p1};
+  const auto inverse = 1.0f / area;
+  const auto depth_a = (e0.a * p0.z + e1.a * p1.z + e2.a * p2.z) * inverse;
+  const auto depth_b = (e0.b * p0.z + e1.b * p1.z + e2.b * p2.z) * inverse;
+  const auto depth_c = (e0.c * p0.z + e1.c * p1.z + e2.c * p2.z) * inverse;
+
+  for (auto y = min_y; y <= max_y; ++y) {
+    auto *row     = this->depth.data() + y * this->width;
+    const auto cy = static_cast<float>(y) + 0.5f;
+    auto x        = min_x & ~3;
+
+#ifdef AFK_OCCLUSION_SSE
+    // Four pixel centres at a time, the buffer is a multiple of four wide.
+    const auto offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const auto zero    = _mm_setzero_ps();
+    const auto row_e0  = _mm_set1_ps(e0.b * cy + e0.c);
+    const auto row_e1  = _mm_set1_ps(e1.b * cy + e1.c);
+    const auto row_e2  = _mm_set1_ps(e2.b * cy + e2.c);
+    const auto row_z   = _mm_set1_ps(depth_b * cy + depth_c);
+
+    for (; x <= max_x; x += 4) {
+      const auto cx = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+      const auto w0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e0.a), cx), row_e0);
+      const auto w1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e1.a), cx), row_e1);
+      const auto w2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e2.a), cx), row_e2);
+      const auto z  = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depth_a), cx), row_z);
+
+      const auto covered = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)),
+                                      _mm_cmpge_ps(w2, zero));
+      const auto old     = _mm_loadu_ps(row + x);
+      const auto nearest = _mm_min_ps(old, z);
+
+      _mm_storeu_ps(row + x,
+                    _mm_or_ps(_mm_and_ps(covered, nearest), _mm_andnot_ps(covered, old)));
+    }
+#else
+    for (x = min_x; x <= max_x; ++x) {
+      const auto cx = static_cast<float>(x) + 0.5f;
+
+      if (e0.a * cx + e0.b * cy + e0.c >= 0.0f && e1.a * cx + e1.b * cy + e1.c >= 0.0f &&
+          e2.a * cx + e2.b * cy + e2.c >= 0.0f) {
+        row[x] = std::min(row[x], depth_a * cx + depth_b * cy + depth_c);
+      }
+    }
+#endif
+  }
+}
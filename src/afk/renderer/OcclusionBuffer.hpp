@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "afk/renderer/Bounds.hpp"
+#include "afk/renderer/Index.hpp"
+
+namespace Afk {
+  /**
+   * Triangles of a mesh kept on the CPU to rasterise as an occluder
+   */
+  struct OccluderMesh {
+    std::vector<glm::vec3> positions = {};
+    std::vector<Index> indices       = {};
+  };
+
+  /**
+   * Low resolution depth buffer rasterised on the CPU from occluder
+   * triangles, to skip drawing anything hidden behind them. Depth is clip
+   * z / w mapped to 0 at the near plane and 1 at the far plane.
+   *
+   * Occluders only write pixels whose centres they cover and triangles
+   * crossing the near plane are skipped, so tests err towards visible.
+   */
+  class OcclusionBuffer {
+  public:
+    static constexpr int DEFAULT_WIDTH  = 256;
+    static constexpr int DEFAULT_HEIGHT = 128;
+
+    /**
+     * \param _width pixels across, rounded up to a multiple of four
+     */
+    explicit OcclusionBuffer(int _width = DEFAULT_WIDTH, int _height = DEFAULT_HEIGHT);
+
+    /**
+     * Reset every pixel to the far plane
+     */
+    auto clear() -> void;
+    /**
+     * Rasterise an occluder, keeping the nearest depth of each pixel
+     * \param transform projection * view * model matrix of the occluder
+     */
+    auto rasterize(const glm::mat4 &transform, const OccluderMesh &mesh) -> void;
+    /**
+     * Whether any part of a box could be in front of the occluders
+     * \param view_projection projection * view matrix the occluders were
+     * rasterised with
+     */
+    auto is_visible(const glm::mat4 &view_projection, const Aabb &aabb) const -> bool;
+
+    auto get_width() const -> int;
+    auto get_height() const -> int;
+    auto get_depth() const -> const std::vector<float> &;
+
+  private:
+    int width                = {};
+    int height               = {};
+    std::vector<float> depth = {};
+
+    /**
+     * Rasterise a triangle already in screen space, with z as depth
+     */
+    auto rasterize_triangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c)
+        -> void;
+  };
+}
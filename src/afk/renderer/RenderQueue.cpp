@@ -0,0 +1,65 @@
+#include "afk/renderer/RenderQueue.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+
+using Afk::RenderItem;
+
+static constexpr auto DEPTH_BITS = 20;
+
+static auto field(std::uint32_t value, int bits, int shift) -> std::uint64_t {
+  return (static_cast<std::uint64_t>(value) & ((std::uint64_t{1} << bits) - 1)) << shift;
+}
+
+auto Afk::make_sort_key(RenderPass pass, std::uint32_t shader_program, std::uint32_t material,
+                        std::uint32_t mesh, float depth) -> std::uint64_t {
+  constexpr auto max_depth = static_cast<float>((1 << DEPTH_BITS) - 1);
+  const auto quantized     = static_cast<std::uint32_t>(std::clamp(depth, 0.0f, 1.0f) * max_depth);
+
+  return field(static_cast<std::uint32_t>(pass), 4, 60) | field(shader_program, 8, 52) |
+         field(material, 16, 36) | field(mesh, 16, DEPTH_BITS) |
+         field(quantized, DEPTH_BITS, 0);
+}
+
+auto Afk::radix_sort(RenderItem *items, RenderItem *scratch, std::size_t count) -> void {
+  if (count < 2) {
+    return;
+  }
+
+  // Count every byte up front so passes over shared bytes can be skipped.
+  auto histograms = std::array<std::array<std::size_t, 256>, 8>{};
+
+  for (auto i = std::size_t{0}; i < count; ++i) {
+    for (auto byte = 0; byte < 8; ++byte) {
+      ++histograms[byte][(items[i].key >> (byte * 8)) & 0xff];
+    }
+  }
+
+  auto *from = items;
+  auto *to   = scratch;
+
+  for (auto byte = 0; byte < 8; ++byte) {
+    auto &histogram = histograms[byte];
+
+    if (histogram[(from[0].key >> (byte * 8)) & 0xff] == count) {
+      continue;
+    }
+
+    auto offset = std::size_t{0};
+    for (auto &bucket : histogram) {
+      offset += std::exchange(bucket, offset);
+    }
+
+    for (auto i = std::size_t{0}; i < count; ++i) {
+      to[histogram[(from[i].key >> (byte * 8)) & 0xff]++] = from[i];
+    }
+
+    std::swap(from, to);
+  }
+
+  if (from != items) {
+    std::copy(from, from + count, items);
+  }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Afk {
+  /**
+   * Passes meshes are drawn in, in draw order
+   */
+  enum class RenderPass : std::uint8_t { Opaque = 0 };
+  /**
+   * A mesh to draw, sorted by a key packing everything that costs a GL state
+   * change to switch, most expensive first:
+   *
+   *   63..60 pass, 59..52 shader program, 51..36 material,
+   *   35..20 mesh, 19..0 depth
+   *
+   * so drawing in key order only changes state when a field changes, and
+   * otherwise draws front to back.
+   */
+  struct RenderItem {
+    std::uint64_t key = {};
+    /**
+     * Index of the mesh in the renderer's draws for the frame
+     */
+    std::uint32_t draw = {};
+  };
+  /**
+   * Pack a sort key, truncating each field to its bits
+   * \param depth distance into the view, from 0 at the near plane to 1 at the
+   * far plane
+   */
+  auto make_sort_key(RenderPass pass, std::uint32_t shader_program, std::uint32_t material,
+                     std::uint32_t mesh, float depth) -> std::uint64_t;
+  /**
+   * Stable LSD radix sort of items by key, a byte per pass, skipping bytes
+   * every key shares
+   * \param scratch at least count items of working space
+   */
+  auto radix_sort(RenderItem *items, RenderItem *scratch, std::size_t count) -> void;
+}
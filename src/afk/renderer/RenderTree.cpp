@@ -0,0 +1,217 @@
+#include "afk/renderer/RenderTree.hpp"
+
+#include <optional>
+
+#include "afk/component/AgentComponent.hpp"
+#include "afk/component/ScriptsComponent.hpp"
+#include "afk/debug/Profiler.hpp"
+#include "afk/io/ModelSource.hpp"
+#include "afk/physics/PhysicsBody.hpp"
+#include "afk/physics/Transform.hpp"
+
+using Afk::Aabb;
+using Afk::GameObject;
+using Afk::RenderProxy;
+using Afk::RenderTree;
+
+RenderProxy::RenderProxy(GameObject e, AabbTree::ProxyId _proxy, bool _is_static)
+  : BaseComponent(e), proxy(_proxy), is_static(_is_static) {}
+
+/**
+ * Whether nothing will move an entity once it's placed
+ */
+static auto is_static(const entt::registry &registry, GameObject object) -> bool {
+  if (registry.has<Afk::AI::AgentComponent>(object) ||
+      registry.has<Afk::ScriptsComponent>(object)) {
+    return false;
+  }
+
+  const auto *body = registry.try_get<Afk::PhysicsBody>(object);
+
+  return body == nullptr || body->get_type() == Afk::RigidBodyType::STATIC;
+}
+
+static auto has_model(const entt::registry &registry, GameObject object) -> bool {
+  return registry.valid(object) && registry.has<Afk::Transform, Afk::ModelSource>(object);
+}
+
+/**
+ * Get an entity's world bounds, if its model has loaded
+ */
+static auto get_world_aabb(const entt::registry &registry, Afk::Renderer &renderer,
+                           GameObject object) -> std::optional<Aabb> {
+  const auto &model_source = registry.get<Afk::ModelSource>(object);
+  const auto aabb          = renderer.get_model_bounds(model_source.get_model_id());
+
+  if (!aabb.has_value()) {
+    return std::nullopt;
+  }
+
+  return Afk::transform_aabb(*aabb, registry.get<Afk::Transform>(object).get_matrix());
+}
+
+auto RenderTree::add(GameObject object) -> void {
+  this->added.push_back(object);
+}
+
+auto RenderTree::mark_moved(GameObject object) -> void {
+  this->moved.push_back(object);
+}
+
+auto RenderTree::update(entt::registry &registry, Renderer &renderer) -> void {
+  afk_profile_zone("RenderTree::update");
+
+  for (const auto object : this->added) {
+    if (registry.valid(object) && !registry.has<RenderProxy>(object)) {
+      this->pending.push_back(object);
+    }
+  }
+
+  this->added.clear();
+
+  // Insert pending entities whose models have loaded. The first static ones
+  // are built into a tree top down, later ones are inserted.
+  auto static_leaves  = std::vector<AabbTree::Leaf>{};
+  auto still_pending  = std::vector<GameObject>{};
+  const auto is_built = this->static_tree.get_size() > 0;
+
+  for (const auto object : this->pending) {
+    if (!registry.valid(object) || !registry.has<Afk::ModelSource>(object) ||
+        registry.has<RenderProxy>(object)) {
+      continue;
+    }
+
+    const auto aabb = registry.has<Afk::Transform>(object)
+                          ? get_world_aabb(registry, renderer, object)
+                          : std::optional<Aabb>{};
+
+    if (!aabb.has_value()) {
+      still_pending.push_back(object);
+      continue;
+    }
+
+    if (!is_static(registry, object)) {
+      registry.assign<RenderProxy>(object, object, this->dynamic_tree.insert(*aabb, object),
+                                   false);
+    } else if (is_built) {
+      registry.assign<RenderProxy>(object, object, this->static_tree.insert(*aabb, object),
+                                   true);
+    } else {
+      static_leaves.push_back({*aabb, object});
+    }
+  }
+
+  this->pending.swap(still_pending);
+
+  if (!static_leaves.empty()) {
+    const auto proxies = this->static_tree.build(static_leaves);
+
+    for (auto i = std::size_t{0}; i < proxies.size(); ++i) {
+      const auto object = static_leaves[i].object;
+      registry.assign<RenderProxy>(object, object, proxies[i], true);
+    }
+  }
+
+  // Scripts set transforms directly, so scripted entities are moved every
+  // update rather than marked.
+  for (const auto object : registry.view<Afk::ScriptsComponent, RenderProxy>()) {
+    this->moved.push_back(object);
+  }
+
+  // Moving within a leaf's fat box doesn't touch the tree.
+  for (const auto object : this->moved) {
+    if (!has_model(registry, object) || !registry.has<RenderProxy>(object)) {
+      continue;
+    }
+
+    const auto render_proxy = registry.get<RenderProxy>(object);
+    auto &tree              = this->get_tree(render_proxy.is_static);
+
+    if (const auto aabb = get_world_aabb(registry, renderer, object); aabb.has_value()) {
+      tree.move(render_proxy.proxy, *aabb);
+      continue;
+    }
+
+    // Its new model hasn't loaded, so it waits with the other entities that
+    // have no bounds yet rather than being culled by the old model's.
+    tree.remove(render_proxy.proxy);
+    registry.remove<RenderProxy>(object);
+    this->pending.push_back(object);
+  }
+
+  this->moved.clear();
+}
+
+auto RenderTree::get_visible(entt::registry &registry, const Frustum &frustum,
+                             Memory::FrameVector<GameObject> &visible) -> void {
+  afk_profile_zone("RenderTree::get_visible");
+  auto stale = std::vector<Stale>{};
+
+  for (auto *tree : {&this->static_tree, &this->dynamic_tree}) {
+    tree->query(frustum, [&](AabbTree::ProxyId proxy) {
+      const auto object = tree->get_object(proxy);
+
+      if (has_model(registry, object)) {
+        visible.push_back(object);
+      } else {
+        stale.push_back({tree, proxy});
+      }
+    });
+  }
+
+  for (const auto object : this->pending) {
+    if (has_model(registry, object)) {
+      visible.push_back(object);
+    }
+  }
+
+  this->remove_stale(registry, stale);
+}
+
+auto RenderTree::get_nearby(entt::registry &registry, const BoundingSphere &sphere,
+                            Memory::FrameVector<GameObject> &nearby) -> void {
+  auto stale = std::vector<Stale>{};
+
+  for (auto *tree : {&this->static_tree, &this->dynamic_tree}) {
+    tree->query(sphere, [&](AabbTree::ProxyId proxy) {
+      const auto object = tree->get_object(proxy);
+
+      if (has_model(registry, object)) {
+        nearby.push_back(object);
+      } else {
+        stale.push_back({tree, proxy});
+      }
+    });
+  }
+
+  for (const auto object : this->pending) {
+    if (has_model(registry, object)) {
+      nearby.push_back(object);
+    }
+  }
+
+  this->remove_stale(registry, stale);
+}
+
+auto RenderTree::get_stats() const -> Stats {
+  return {this->static_tree.get_size(), this->dynamic_tree.get_size(), this->pending.size(),
+          this->static_tree.get_height(), this->dynamic_tree.get_height()};
+}
+
+auto RenderTree::get_tree(bool is_static) -> AabbTree & {
+  return is_static ? this->static_tree : this->dynamic_tree;
+}
+
+auto RenderTree::remove_stale(entt::registry &registry, const std::vector<Stale> &stale)
+    -> void {
+  for (const auto &[tree, proxy] : stale) {
+    const auto object = tree->get_object(proxy);
+
+    // Destroyed entities took their proxy component with them.
+    if (registry.valid(object) && registry.has<RenderProxy>(object)) {
+      registry.remove<RenderProxy>(object);
+    }
+
+    tree->remove(proxy);
+  }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "afk/component/BaseComponent.hpp"
+#include "afk/component/GameObject.hpp"
+#include "afk/memory/FrameArena.hpp"
+#include "afk/renderer/AabbTree.hpp"
+#include "afk/renderer/Bounds.hpp"
+#include "afk/renderer/Frustum.hpp"
+#include "afk/renderer/Renderer.hpp"
+
+namespace Afk {
+  /**
+   * Where an entity's model is in the render tree
+   */
+  struct RenderProxy : public BaseComponent {
+    AabbTree::ProxyId proxy = AabbTree::NULL_PROXY;
+    bool is_static          = false;
+
+    RenderProxy() = default;
+    RenderProxy(GameObject e, AabbTree::ProxyId _proxy, bool _is_static);
+  };
+
+  /**
+   * Bounding volume hierarchies over every entity with a model, so finding
+   * what to draw only visits the subtrees in view.
+   *
+   * Entities that nothing simulates or scripts go in a static tree built
+   * once; the rest go in a dynamic tree updated as they move. Entities whose
+   * model hasn't loaded yet, including those switched to a new model, have no
+   * bounds, and are always returned until it has.
+   */
+  class RenderTree {
+  public:
+    struct Stats {
+      std::size_t static_objects  = {};
+      std::size_t dynamic_objects = {};
+      std::size_t pending_objects = {};
+      int static_height           = {};
+      int dynamic_height          = {};
+    };
+
+    /**
+     * Add an entity once it has a transform and a model source
+     */
+    auto add(GameObject object) -> void;
+    /**
+     * Note that an entity's transform or model changed
+     */
+    auto mark_moved(GameObject object) -> void;
+    /**
+     * Insert added entities and move those marked since the last update
+     */
+    auto update(entt::registry &registry, Renderer &renderer) -> void;
+    /**
+     * Get every entity that may be inside a frustum, dropping any that were
+     * destroyed or lost their model
+     */
+    auto get_visible(entt::registry &registry, const Frustum &frustum,
+                     Memory::FrameVector<GameObject> &visible) -> void;
+    /**
+     * Get every entity that may be within a sphere, dropping any that were
+     * destroyed or lost their model
+     */
+    auto get_nearby(entt::registry &registry, const BoundingSphere &sphere,
+                    Memory::FrameVector<GameObject> &nearby) -> void;
+    auto get_stats() const -> Stats;
+
+  private:
+    /**
+     * A leaf whose entity no longer has a model
+     */
+    struct Stale {
+      AabbTree *tree          = nullptr;
+      AabbTree::ProxyId proxy = AabbTree::NULL_PROXY;
+    };
+
+    AabbTree static_tree  = AabbTree{0.0f};
+    AabbTree dynamic_tree = AabbTree{};
+
+    std::vector<GameObject> added   = {};
+    std::vector<GameObject> moved   = {};
+    std::vector<GameObject> pending = {};
+
+    auto get_tree(bool is_static) -> AabbTree &;
+    /**
+     * Remove entities a query found that no longer have a model
+     */
+    auto remove_stale(entt::registry &registry, const std::vector<Stale> &stale) -> void;
+  };
+}
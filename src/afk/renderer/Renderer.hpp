@@ -7,6 +7,7 @@
 #include "afk/renderer/opengl/ModelHandle.hpp"
 #include "afk/renderer/opengl/ShaderHandle.hpp"
 #include "afk/renderer/opengl/ShaderProgramHandle.hpp"
+#include "afk/renderer/opengl/TerrainHandle.hpp"
 #include "afk/renderer/opengl/TextureHandle.hpp"
 
 namespace Afk {
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "afk/debug/Assert.hpp"
+
+namespace Afk {
+  /**
+   * Compact handle to a resource in a resource registry. The generation tells
+   * a handle to a released resource apart from whatever reused its slot.
+   */
+  template<typename T>
+  struct ResourceId {
+    static constexpr auto NULL_INDEX = std::numeric_limits<std::uint32_t>::max();
+
+    std::uint32_t index      = NULL_INDEX;
+    std::uint32_t generation = {};
+
+    auto is_null() const -> bool {
+      return this->index == NULL_INDEX;
+    }
+    auto operator==(const ResourceId &rhs) const -> bool {
+      return this->index == rhs.index && this->generation == rhs.generation;
+    }
+    auto operator!=(const ResourceId &rhs) const -> bool {
+      return !(*this == rhs);
+    }
+  };
+
+  /**
+   * Fixed size array of resources looked up by ResourceId, so a lookup is an
+   * array index. Slots never move, so looking a resource up while another is
+   * added is safe as long as adding and releasing are serialised.
+   */
+  template<typename T, std::size_t Capacity>
+  class ResourceRegistry {
+  public:
+    using Id = ResourceId<T>;
+
+    static_assert(Capacity < Id::NULL_INDEX, "Capacity too large for resource IDs");
+
+    /**
+     * Add a resource, reusing a released slot if there is one
+     */
+    auto add(T value) -> Id {
+      auto index = std::uint32_t{};
+
+      if (!this->free_slots.empty()) {
+        index = this->free_slots.back();
+        this->free_slots.pop_back();
+      } else {
+        index = this->size.load(std::memory_order_relaxed);
+        afk_assert(index < Capacity, "Resource registry full");
+        this->size.store(index + 1, std::memory_order_release);
+      }
+
+      auto &slot   = this->slots[index];
+      slot.value   = std::move(value);
+      slot.is_live = true;
+
+      return {index, slot.generation};
+    }
+    /**
+     * Release a resource, invalidating every ID to it. Must not race with
+     * anything looking it up.
+     */
+    auto release(Id id) -> void {
+      afk_assert(this->is_valid(id), "Releasing invalid resource ID");
+
+      auto &slot   = this->slots[id.index];
+      slot.value   = T{};
+      slot.is_live = false;
+      ++slot.generation;
+      this->free_slots.push_back(id.index);
+    }
+    auto is_valid(Id id) const -> bool {
+      if (id.index >= this->size.load(std::memory_order_acquire)) {
+        return false;
+      }
+
+      const auto &slot = this->slots[id.index];
+
+      return slot.is_live && slot.generation == id.generation;
+    }
+    auto get(Id id) -> T & {
+      afk_assert_debug(this->is_valid(id), "Invalid resource ID");
+      return this->slots[id.index].value;
+    }
+    auto get(Id id) const -> const T & {
+      afk_assert_debug(this->is_valid(id), "Invalid resource ID");
+      return this->slots[id.index].value;
+    }
+
+  private:
+    struct Slot {
+      T value                  = {};
+      std::uint32_t generation = {};
+      bool is_live             = false;
+    };
+
+    std::unique_ptr<Slot[]> slots         = std::make_unique<Slot[]>(Capacity);
+    std::vector<std::uint32_t> free_slots = {};
+    std::atomic<std::uint32_t> size       = {};
+  };
+}
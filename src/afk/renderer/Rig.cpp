@@ -0,0 +1,13 @@
+#include "afk/renderer/Rig.hpp"
+
+using Afk::Rig;
+
+auto Rig::find_clip(std::string_view name) const -> const ozz::animation::Animation * {
+  for (const auto &clip : this->clips) {
+    if (clip.name == name) {
+      return clip.animation.get();
+    }
+  }
+
+  return nullptr;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <ozz/animation/runtime/animation.h>
+#include <ozz/animation/runtime/skeleton.h>
+#include <ozz/base/maths/simd_math.h>
+#include <ozz/base/memory/unique_ptr.h>
+
+namespace Afk {
+  /**
+   * A model's skeleton and animations converted to ozz's runtime formats, and
+   * how the bones of its meshes map onto the skeleton's joints
+   */
+  struct Rig {
+    /**
+     * A named animation
+     */
+    struct Clip {
+      std::string name                                     = {};
+      ozz::unique_ptr<ozz::animation::Animation> animation = {};
+    };
+    /**
+     * A bone of a mesh, moved by a joint of the skeleton
+     */
+    struct Bone {
+      int joint                  = {};
+      std::uint32_t mesh         = {};
+      // Takes a vertex from the mesh's space into the bone's.
+      ozz::math::Float4x4 offset = ozz::math::Float4x4::identity();
+    };
+
+    using Clips  = std::vector<Clip>;
+    using Bones  = std::vector<Bone>;
+    using Meshes = std::vector<ozz::math::Float4x4>;
+
+    ozz::unique_ptr<ozz::animation::Skeleton> skeleton = {};
+    Clips clips                                        = {};
+    /**
+     * Every mesh's bones, a mesh after another in the model's mesh order, so
+     * the skinning palette is laid out the same
+     */
+    Bones bones = {};
+    /**
+     * Inverse of each mesh's transform, which the renderer applies on top of
+     * the skinned vertices that are already in the model's space
+     */
+    Meshes mesh_inverses = {};
+
+    /**
+     * Find an animation by name, null if the model doesn't have it
+     */
+    auto find_clip(std::string_view name) const -> const ozz::animation::Animation *;
+  };
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+namespace Afk {
+  /**
+   * A square of terrain, drawn with the grid every patch shares scaled to
+   * its size, its vertices morphing towards the next coarser level as they
+   * near the end of its range
+   */
+  struct TerrainPatch {
+    /**
+     * Bit of each quadrant of a patch, -x -z first and +x +z last
+     */
+    static constexpr std::uint8_t ALL_QUADRANTS = 0xf;
+
+    /**
+     * Corner of the patch, in height map samples
+     */
+    glm::vec2 offset = {};
+    /**
+     * Height map samples across the patch
+     */
+    float size = {};
+    /**
+     * Distances from the camera vertices start and finish morphing over
+     */
+    glm::vec2 morph        = {};
+    std::uint8_t lod       = {};
+    std::uint8_t quadrants = ALL_QUADRANTS;
+  };
+}
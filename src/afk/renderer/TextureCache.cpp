@@ -0,0 +1,345 @@
+#include "afk/renderer/TextureCache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <stb/stb_image.h>
+
+#include "afk/debug/Assert.hpp"
+#include "afk/debug/Profiler.hpp"
+#include "afk/io/Log.hpp"
+#include "afk/io/Path.hpp"
+#include "afk/renderer/TextureCompressor.hpp"
+
+using namespace std::string_literals;
+using std::size_t;
+using std::uint8_t;
+using std::filesystem::path;
+
+using Afk::CookedTexture;
+using Afk::Texture;
+using Afk::TextureCache;
+using Afk::TextureFormat;
+using Afk::TextureFormats;
+
+namespace Io = Afk::Io;
+
+constexpr std::uint64_t FNV_OFFSET = 14695981039346656037ull;
+constexpr std::uint64_t FNV_PRIME  = 1099511628211ull;
+/**
+ * Bytes of the source file hashed at a time
+ */
+constexpr size_t HASH_CHUNK = 64 * 1024;
+
+template<typename T>
+static auto write_value(std::ostream &file, const T &value) -> void {
+  static_assert(std::is_trivially_copyable_v<T>);
+  file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template<typename T>
+static auto read_value(std::istream &file) -> T {
+  static_assert(std::is_trivially_copyable_v<T>);
+  auto value = T{};
+  file.read(reinterpret_cast<char *>(&value), sizeof(T));
+  return value;
+}
+
+static auto get_index(TextureFormat format) -> size_t {
+  return static_cast<size_t>(format);
+}
+
+/**
+ * FNV-1a hash of a file's contents
+ */
+static auto hash_file(const path &abs_path) -> std::uint64_t {
+  auto file   = std::ifstream{abs_path, std::ios::binary};
+  auto buffer = std::vector<char>(HASH_CHUNK);
+  auto hash   = FNV_OFFSET;
+
+  afk_assert(file.is_open(), "Failed to open image: '"s + abs_path.string() + "'"s);
+
+  while (file) {
+    file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+    for (auto i = std::streamsize{0}; i < file.gcount(); ++i) {
+      hash = (hash ^ static_cast<uint8_t>(buffer[static_cast<size_t>(i)])) * FNV_PRIME;
+    }
+  }
+
+  return hash;
+}
+
+/**
+ * Get the bytes a mip takes in a format
+ */
+static auto get_mip_size(TextureFormat format, int width, int height) -> size_t {
+  switch (format) {
+    case TextureFormat::Rgba8:
+      return static_cast<size_t>(width) * static_cast<size_t>(height) * size_t{4};
+    case TextureFormat::Bc1: return Afk::get_compressed_size(width, height, Afk::BC1_BLOCK_BYTES);
+    case TextureFormat::Bc3: return Afk::get_compressed_size(width, height, Afk::BC3_BLOCK_BYTES);
+    case TextureFormat::Bc5: return Afk::get_compressed_size(width, height, Afk::BC5_BLOCK_BYTES);
+    default: afk_unreachable();
+  }
+}
+
+/**
+ * Pick the block format for a texture. Normal maps only keep X and Y, so
+ * shaders sampling them have to rebuild Z.
+ */
+static auto choose_format(Texture::Type type, bool has_alpha, const TextureFormats &formats)
+    -> TextureFormat {
+  const auto wanted = type == Texture::Type::Normal ? TextureFormat::Bc5
+                      : has_alpha                   ? TextureFormat::Bc3
+                                                    : TextureFormat::Bc1;
+
+  return formats[get_index(wanted)] ? wanted : TextureFormat::Rgba8;
+}
+
+/**
+ * Halve an RGBA8 image, averaging each 2x2 square of pixels
+ */
+static auto downsample(const uint8_t *pixels, int width, int height) -> std::vector<uint8_t> {
+  const auto next_width  = std::max(width / 2, 1);
+  const auto next_height = std::max(height / 2, 1);
+  auto next = std::vector<uint8_t>(static_cast<size_t>(next_width * next_height) * size_t{4});
+
+  const auto at = [&](int x, int y, int channel) -> unsigned {
+    const auto i = (std::min(y, height - 1) * width + std::min(x, width - 1)) * 4 + channel;
+    return pixels[static_cast<size_t>(i)];
+  };
+
+  for (auto y = 0; y < next_height; ++y) {
+    for (auto x = 0; x < next_width; ++x) {
+      for (auto channel = 0; channel < 4; ++channel) {
+        const auto sum = at(x * 2, y * 2, channel) + at(x * 2 + 1, y * 2, channel) +
+                         at(x * 2, y * 2 + 1, channel) + at(x * 2 + 1, y * 2 + 1, channel);
+
+        next[static_cast<size_t>((y * next_width + x) * 4 + channel)] =
+            static_cast<uint8_t>((sum + 2) / 4);
+      }
+    }
+  }
+
+  return next;
+}
+
+/**
+ * Append a mip to a texture in its format
+ */
+static auto add_mip(CookedTexture &texture, const uint8_t *pixels, int width, int height)
+    -> void {
+  const auto offset = texture.data.size();
+
+  switch (texture.format) {
+    case TextureFormat::Rgba8:
+      texture.data.insert(texture.data.end(), pixels,
+                          pixels + get_mip_size(TextureFormat::Rgba8, width, height));
+      break;
+    case TextureFormat::Bc1: Afk::compress_bc1(pixels, width, height, texture.data); break;
+    case TextureFormat::Bc3: Afk::compress_bc3(pixels, width, height, texture.data); break;
+    case TextureFormat::Bc5: Afk::compress_bc5(pixels, width, height, texture.data); break;
+    default: afk_unreachable();
+  }
+
+  texture.mips.push_back({width, height, offset, texture.data.size() - offset});
+}
+
+auto CookedTexture::get_width() const -> int {
+  return this->mips.empty() ? 0 : this->mips.front().width;
+}
+
+auto CookedTexture::get_height() const -> int {
+  return this->mips.empty() ? 0 : this->mips.front().height;
+}
+
+auto TextureCache::load(const path &file_path, Texture::Type type, TextureFormats formats)
+    -> CookedTexture {
+  afk_profile_zone("TextureCache::load");
+  formats.set(get_index(TextureFormat::Rgba8));
+
+  const auto source_hash = hash_file(Afk::get_absolute_path(file_path));
+  const auto cache_path  = TextureCache::get_cache_path(file_path);
+
+  if (auto cached = TextureCache::read(cache_path, source_hash, formats); cached.has_value()) {
+    return std::move(*cached);
+  }
+
+  auto texture = TextureCache::cook(file_path, type, formats);
+
+  if (TextureCache::write(cache_path, source_hash, formats, texture)) {
+    Io::log << "Cooked texture '" << file_path.string() << "'.\n";
+  } else {
+    Io::log << "Failed to cache texture '" << file_path.string() << "'.\n";
+  }
+
+  return texture;
+}
+
+auto TextureCache::cook(const path &file_path, Texture::Type type, TextureFormats formats)
+    -> CookedTexture {
+  afk_profile_zone("TextureCache::cook");
+  const auto abs_path = Afk::get_absolute_path(file_path);
+  auto width          = 0;
+  auto height         = 0;
+  auto channels       = 0;
+  auto pixels         = std::unique_ptr<uint8_t, decltype(&stbi_image_free)>{
+      stbi_load(abs_path.string().c_str(), &width, &height, &channels, STBI_rgb_alpha),
+      stbi_image_free};
+
+  afk_assert(pixels != nullptr, "Failed to load image: '"s + file_path.string() + "'"s);
+
+  const auto num_pixels = static_cast<size_t>(width) * static_cast<size_t>(height);
+  auto has_alpha        = false;
+
+  for (auto i = size_t{0}; i < num_pixels && !has_alpha; ++i) {
+    has_alpha = pixels.get()[i * 4 + 3] != 255;
+  }
+
+  auto texture   = CookedTexture{};
+  texture.format = choose_format(type, has_alpha, formats);
+
+  add_mip(texture, pixels.get(), width, height);
+
+  // Each mip is filtered from the last, down to a single pixel.
+  auto mip = std::vector<uint8_t>{};
+
+  while (width > 1 || height > 1) {
+    mip    = downsample(mip.empty() ? pixels.get() : mip.data(), width, height);
+    width  = std::max(width / 2, 1);
+    height = std::max(height / 2, 1);
+
+    add_mip(texture, mip.data(), width, height);
+  }
+
+  return texture;
+}
+
+auto TextureCache::get_cache_path(const path &file_path) -> path {
+  return Afk::get_absolute_path("res/gen/texture") /
+         file_path.relative_path().concat(".afkt");
+}
+
+auto TextureCache::read(const path &cache_path, std::uint64_t source_hash,
+                        TextureFormats formats) -> std::optional<CookedTexture> {
+  auto file = std::ifstream{cache_path, std::ios::binary};
+
+  if (!file.is_open()) {
+    return std::nullopt;
+  }
+
+  auto magic = std::array<char, sizeof(TextureCache::MAGIC)>{};
+  file.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+
+  const auto is_current =
+      std::memcmp(magic.data(), TextureCache::MAGIC, magic.size()) == 0 &&
+      read_value<std::uint32_t>(file) == TextureCache::VERSION &&
+      read_value<std::uint64_t>(file) == source_hash &&
+      read_value<std::uint64_t>(file) == formats.to_ullong();
+
+  if (!file || !is_current) {
+    return std::nullopt;
+  }
+
+  auto texture         = CookedTexture{};
+  const auto format    = read_value<std::uint32_t>(file);
+  const auto num_mips  = read_value<std::uint32_t>(file);
+  auto expected_offset = size_t{0};
+
+  if (format >= static_cast<std::uint32_t>(TextureFormat::Count) || !formats[format]) {
+    return std::nullopt;
+  }
+
+  texture.format = static_cast<TextureFormat>(format);
+
+  for (auto i = std::uint32_t{0}; i < num_mips && file; ++i) {
+    auto mip   = CookedTexture::Mip{};
+    mip.width  = read_value<std::int32_t>(file);
+    mip.height = read_value<std::int32_t>(file);
+    mip.offset = expected_offset;
+    mip.size   = static_cast<size_t>(read_value<std::uint64_t>(file));
+
+    if (mip.width < 1 || mip.height < 1 ||
+        mip.size != get_mip_size(texture.format, mip.width, mip.height)) {
+      return std::nullopt;
+    }
+
+    expected_offset += mip.size;
+    texture.mips.push_back(mip);
+  }
+
+  texture.data.resize(expected_offset);
+  file.read(reinterpret_cast<char *>(texture.data.data()),
+            static_cast<std::streamsize>(texture.data.size()));
+
+  if (!file || texture.mips.empty()) {
+    return std::nullopt;
+  }
+
+  return texture;
+}
+
+auto TextureCache::write(const path &cache_path, std::uint64_t source_hash,
+                         TextureFormats formats, const CookedTexture &texture) -> bool {
+  auto error = std::error_code{};
+  std::filesystem::create_directories(cache_path.parent_path(), error);
+
+  if (error) {
+    return false;
+  }
+
+  // Write beside the cache and move it into place, so a reader on another
+  // thread never sees half a file.
+  auto temp_path = cache_path;
+  const auto thread = std::hash<std::thread::id>{}(std::this_thread::get_id());
+  temp_path.concat("." + std::to_string(thread));
+
+  {
+    auto file = std::ofstream{temp_path, std::ios::binary | std::ios::trunc};
+
+    if (!file.is_open()) {
+      return false;
+    }
+
+    file.write(TextureCache::MAGIC, sizeof(TextureCache::MAGIC));
+    write_value(file, TextureCache::VERSION);
+    write_value(file, source_hash);
+    write_value(file, static_cast<std::uint64_t>(formats.to_ullong()));
+    write_value(file, static_cast<std::uint32_t>(texture.format));
+    write_value(file, static_cast<std::uint32_t>(texture.mips.size()));
+
+    for (const auto &mip : texture.mips) {
+      write_value(file, static_cast<std::int32_t>(mip.width));
+      write_value(file, static_cast<std::int32_t>(mip.height));
+      write_value(file, static_cast<std::uint64_t>(mip.size));
+    }
+
+    file.write(reinterpret_cast<const char *>(texture.data.data()),
+               static_cast<std::streamsize>(texture.data.size()));
+
+    if (!file) {
+      file.close();
+      std::filesystem::remove(temp_path, error);
+      return false;
+    }
+  }
+
+  std::filesystem::rename(temp_path, cache_path, error);
+
+  if (error) {
+    std::filesystem::remove(temp_path, error);
+    return false;
+  }
+
+  return true;
+}
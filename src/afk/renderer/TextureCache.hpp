@@ -0,0 +1,78 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "afk/renderer/Texture.hpp"
+
+namespace Afk {
+  /**
+   * Format of every mip of a cooked texture
+   */
+  enum class TextureFormat : std::uint32_t { Rgba8 = 0, Bc1, Bc3, Bc5, Count };
+
+  using TextureFormats = std::bitset<static_cast<std::size_t>(TextureFormat::Count)>;
+
+  /**
+   * A texture with its whole mip chain in the format it is uploaded in
+   */
+  struct CookedTexture {
+    /**
+     * A mip's place in the texture's data
+     */
+    struct Mip {
+      int width          = {};
+      int height         = {};
+      std::size_t offset = {};
+      std::size_t size   = {};
+    };
+
+    TextureFormat format           = TextureFormat::Rgba8;
+    std::vector<Mip> mips          = {};
+    std::vector<std::uint8_t> data = {};
+
+    auto get_width() const -> int;
+    auto get_height() const -> int;
+  };
+
+  /**
+   * Cooks textures into mip chains, compressed to whichever block format
+   * suits their type, and caches them under `res/gen/texture` so later runs
+   * upload them without decoding anything.
+   *
+   * A cached texture is only used while the hash of its source file and the
+   * formats it could be cooked in are the same as when it was cooked.
+   */
+  class TextureCache {
+  public:
+    static constexpr char MAGIC[4]         = {'A', 'F', 'K', 'T'};
+    static constexpr std::uint32_t VERSION = 1;
+
+    /**
+     * Get the cooked texture for a source image, cooking and caching it if
+     * the cached one is missing or stale. Safe to call from any thread.
+     * \param formats formats the texture may be cooked in, RGBA8 always is
+     */
+    static auto load(const std::filesystem::path &file_path, Texture::Type type,
+                     TextureFormats formats) -> CookedTexture;
+    /**
+     * Decode a source image and cook it, without touching the cache
+     */
+    static auto cook(const std::filesystem::path &file_path, Texture::Type type,
+                     TextureFormats formats) -> CookedTexture;
+    /**
+     * Get where a source image's cooked texture is cached
+     */
+    static auto get_cache_path(const std::filesystem::path &file_path) -> std::filesystem::path;
+
+  private:
+    static auto read(const std::filesystem::path &cache_path, std::uint64_t source_hash,
+                     TextureFormats formats) -> std::optional<CookedTexture>;
+    static auto write(const std::filesystem::path &cache_path, std::uint64_t source_hash,
+                      TextureFormats formats, const CookedTexture &texture) -> bool;
+  };
+}
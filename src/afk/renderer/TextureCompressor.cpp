@@ -0,0 +1,245 @@
+#include "afk/renderer/TextureCompressor.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+using glm::vec3;
+using std::size_t;
+using std::uint8_t;
+
+constexpr int BLOCK_SIZE   = 4;
+constexpr int BLOCK_PIXELS = BLOCK_SIZE * BLOCK_SIZE;
+/**
+ * Iterations to refine the axis colours are spread along
+ */
+constexpr int AXIS_ITERATIONS = 4;
+
+using Block = std::array<std::array<uint8_t, 4>, BLOCK_PIXELS>;
+
+/**
+ * Copy a 4x4 block of pixels, repeating the last row and column of images
+ * that don't fill it
+ */
+static auto get_block(const uint8_t *pixels, int width, int height, int block_x, int block_y)
+    -> Block {
+  auto block = Block{};
+
+  for (auto y = 0; y < BLOCK_SIZE; ++y) {
+    for (auto x = 0; x < BLOCK_SIZE; ++x) {
+      const auto pixel_x = std::min(block_x * BLOCK_SIZE + x, width - 1);
+      const auto pixel_y = std::min(block_y * BLOCK_SIZE + y, height - 1);
+      const auto *pixel  = &pixels[(static_cast<size_t>(pixel_y) * static_cast<size_t>(width) +
+                                   static_cast<size_t>(pixel_x)) *
+                                  size_t{4}];
+
+      std::copy(pixel, pixel + 4, block[static_cast<size_t>(y * BLOCK_SIZE + x)].begin());
+    }
+  }
+
+  return block;
+}
+
+static auto quantize(float value, float max) -> unsigned {
+  return static_cast<unsigned>(std::lround(glm::clamp(value, 0.0f, 255.0f) * max / 255.0f));
+}
+
+static auto to_565(const vec3 &colour) -> std::uint16_t {
+  const auto r = quantize(colour.x, 31.0f);
+  const auto g = quantize(colour.y, 63.0f);
+  const auto b = quantize(colour.z, 31.0f);
+
+  return static_cast<std::uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static auto from_565(std::uint16_t colour) -> vec3 {
+  const auto r = static_cast<float>((colour >> 11) & 0x1f);
+  const auto g = static_cast<float>((colour >> 5) & 0x3f);
+  const auto b = static_cast<float>(colour & 0x1f);
+
+  return {r * 255.0f / 31.0f, g * 255.0f / 63.0f, b * 255.0f / 31.0f};
+}
+
+static auto write_u16(std::vector<uint8_t> &blocks, std::uint16_t value) -> void {
+  blocks.push_back(static_cast<uint8_t>(value & 0xff));
+  blocks.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+/**
+ * Encode a BC1 colour block in four colour mode. The endpoints are the
+ * block's extremes along the principal axis of its colours, pulled in
+ * slightly since the palette's inner colours cover the rest.
+ */
+static auto encode_colour(const Block &block, std::vector<uint8_t> &blocks) -> void {
+  auto colours = std::array<vec3, BLOCK_PIXELS>{};
+  auto mean    = vec3{0.0f};
+
+  for (auto i = size_t{0}; i < colours.size(); ++i) {
+    colours[i] = vec3(block[i][0], block[i][1], block[i][2]);
+    mean += colours[i] / static_cast<float>(BLOCK_PIXELS);
+  }
+
+  auto covariance = glm::mat3{0.0f};
+
+  for (const auto &colour : colours) {
+    const auto d = colour - mean;
+    covariance += glm::outerProduct(d, d);
+  }
+
+  // Power iteration towards the principal axis.
+  auto axis = vec3{1.0f, 1.0f, 1.0f};
+
+  for (auto i = 0; i < AXIS_ITERATIONS; ++i) {
+    const auto next   = covariance * axis;
+    const auto length = glm::length(next);
+
+    if (length <= 0.0f) {
+      break;
+    }
+
+    axis = next / length;
+  }
+
+  auto min_t = 0.0f;
+  auto max_t = 0.0f;
+
+  for (const auto &colour : colours) {
+    const auto t = glm::dot(colour - mean, axis);
+    min_t        = std::min(min_t, t);
+    max_t        = std::max(max_t, t);
+  }
+
+  const auto inset = (max_t - min_t) / 16.0f;
+  auto c0          = to_565(mean + axis * (max_t - inset));
+  auto c1          = to_565(mean + axis * (min_t + inset));
+
+  // Four colour mode needs the first endpoint to be the larger.
+  if (c0 < c1) {
+    std::swap(c0, c1);
+  }
+
+  write_u16(blocks, c0);
+  write_u16(blocks, c1);
+
+  if (c0 == c1) {
+    blocks.insert(blocks.end(), 4, uint8_t{0});
+    return;
+  }
+
+  const auto e0      = from_565(c0);
+  const auto e1      = from_565(c1);
+  const auto palette = std::array<vec3, 4>{e0, e1, (e0 * 2.0f + e1) / 3.0f,
+                                           (e0 + e1 * 2.0f) / 3.0f};
+  auto indices       = std::uint32_t{0};
+
+  for (auto i = size_t{0}; i < colours.size(); ++i) {
+    auto best      = std::uint32_t{0};
+    auto best_cost = std::numeric_limits<float>::max();
+
+    for (auto j = std::uint32_t{0}; j < 4; ++j) {
+      const auto d    = colours[i] - palette[j];
+      const auto cost = glm::dot(d, d);
+
+      if (cost < best_cost) {
+        best      = j;
+        best_cost = cost;
+      }
+    }
+
+    indices |= best << (i * 2);
+  }
+
+  for (auto i = 0; i < 4; ++i) {
+    blocks.push_back(static_cast<uint8_t>(indices >> (i * 8)));
+  }
+}
+
+/**
+ * Encode one channel of a block as a BC4 block in eight value mode
+ */
+static auto encode_channel(const Block &block, size_t channel, std::vector<uint8_t> &blocks)
+    -> void {
+  auto a0 = uint8_t{0};
+  auto a1 = uint8_t{255};
+
+  for (const auto &pixel : block) {
+    a0 = std::max(a0, pixel[channel]);
+    a1 = std::min(a1, pixel[channel]);
+  }
+
+  blocks.push_back(a0);
+  blocks.push_back(a1);
+
+  auto indices = std::uint64_t{0};
+
+  if (a0 != a1) {
+    // Palette entries after the endpoints step evenly from the first to
+    // the second, so the nearest entry can be worked out directly.
+    const auto range = static_cast<float>(a0 - a1);
+
+    for (auto i = size_t{0}; i < block.size(); ++i) {
+      const auto t    = static_cast<float>(a0 - block[i][channel]) / range;
+      const auto step = static_cast<std::uint64_t>(std::lround(t * 7.0f));
+      // Step 0 is the first endpoint, 7 the second, 1 to 6 between them.
+      const auto index = step == 0 ? std::uint64_t{0} : step == 7 ? std::uint64_t{1} : step + 1;
+
+      indices |= index << (i * 3);
+    }
+  }
+
+  for (auto i = 0; i < 6; ++i) {
+    blocks.push_back(static_cast<uint8_t>(indices >> (i * 8)));
+  }
+}
+
+/**
+ * Encode every block of an image in raster order
+ */
+template<typename Encode>
+static auto compress(const uint8_t *pixels, int width, int height, size_t block_bytes,
+                     std::vector<uint8_t> &blocks, Encode encode) -> void {
+  const auto blocks_x = (width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  const auto blocks_y = (height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+  blocks.reserve(blocks.size() + Afk::get_compressed_size(width, height, block_bytes));
+
+  for (auto y = 0; y < blocks_y; ++y) {
+    for (auto x = 0; x < blocks_x; ++x) {
+      encode(get_block(pixels, width, height, x, y));
+    }
+  }
+}
+
+auto Afk::get_compressed_size(int width, int height, size_t block_bytes) -> size_t {
+  const auto blocks_x = static_cast<size_t>((width + BLOCK_SIZE - 1) / BLOCK_SIZE);
+  const auto blocks_y = static_cast<size_t>((height + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+  return blocks_x * blocks_y * block_bytes;
+}
+
+auto Afk::compress_bc1(const uint8_t *pixels, int width, int height,
+                       std::vector<uint8_t> &blocks) -> void {
+  compress(pixels, width, height, Afk::BC1_BLOCK_BYTES, blocks,
+           [&blocks](const Block &block) { encode_colour(block, blocks); });
+}
+
+auto Afk::compress_bc3(const uint8_t *pixels, int width, int height,
+                       std::vector<uint8_t> &blocks) -> void {
+  compress(pixels, width, height, Afk::BC3_BLOCK_BYTES, blocks, [&blocks](const Block &block) {
+    encode_channel(block, 3, blocks);
+    encode_colour(block, blocks);
+  });
+}
+
+auto Afk::compress_bc5(const uint8_t *pixels, int width, int height,
+                       std::vector<uint8_t> &blocks) -> void {
+  compress(pixels, width, height, Afk::BC5_BLOCK_BYTES, blocks, [&blocks](const Block &block) {
+    encode_channel(block, 0, blocks);
+    encode_channel(block, 1, blocks);
+  });
+}
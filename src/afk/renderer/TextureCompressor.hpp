@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Afk {
+  /**
+   * Bytes of each 4x4 block of a format
+   */
+  constexpr std::size_t BC1_BLOCK_BYTES = 8;
+  constexpr std::size_t BC3_BLOCK_BYTES = 16;
+  constexpr std::size_t BC5_BLOCK_BYTES = 16;
+
+  /**
+   * Get the bytes a compressed image takes, edge blocks counting as whole
+   */
+  auto get_compressed_size(int width, int height, std::size_t block_bytes) -> std::size_t;
+  /**
+   * Compress RGBA8 pixels to opaque BC1 blocks, appending them
+   */
+  auto compress_bc1(const std::uint8_t *pixels, int width, int height,
+                    std::vector<std::uint8_t> &blocks) -> void;
+  /**
+   * Compress RGBA8 pixels to BC3 blocks, a BC4 alpha block then a BC1 colour
+   * block each, appending them
+   */
+  auto compress_bc3(const std::uint8_t *pixels, int width, int height,
+                    std::vector<std::uint8_t> &blocks) -> void;
+  /**
+   * Compress the red and green of RGBA8 pixels to BC5 blocks, appending them
+   */
+  auto compress_bc5(const std::uint8_t *pixels, int width, int height,
+                    std::vector<std::uint8_t> &blocks) -> void;
+}
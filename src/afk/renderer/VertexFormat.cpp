@@ -0,0 +1,95 @@
+#include "afk/renderer/VertexFormat.hpp"
+
+#include <cmath>
+#include <limits>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "afk/debug/Assert.hpp"
+
+using glm::vec2;
+using glm::vec3;
+
+using Afk::Mesh;
+using Afk::SkinnedVertex;
+using Afk::StaticVertex;
+using Afk::Vertex;
+using Afk::VertexFormat;
+
+/**
+ * Sign of a value, treating zero as positive so folded points stay on the
+ * square's edge
+ */
+static auto sign_not_zero(const vec2 &value) -> vec2 {
+  return {value.x >= 0.0f ? 1.0f : -1.0f, value.y >= 0.0f ? 1.0f : -1.0f};
+}
+
+/**
+ * Pack a vertex's attributes that every format shares
+ */
+template<typename T>
+static auto pack_shared(const Vertex &vertex, T &packed) -> void {
+  packed.position = vertex.position;
+
+  Afk::encode_octahedral(vertex.normal, packed.normal);
+  Afk::encode_octahedral(vertex.tangent, packed.tangent);
+
+  // The bitangent is rebuilt from the normal and tangent, so only its side
+  // is kept, in a bit of the tangent too small to move it.
+  const auto is_flipped =
+      glm::dot(glm::cross(vertex.normal, vertex.tangent), vertex.bitangent) < 0.0f;
+  const auto tangent_y = static_cast<std::uint16_t>(packed.tangent[1]);
+
+  packed.tangent[1] = static_cast<std::int16_t>((tangent_y & ~std::uint16_t{1}) |
+                                                (is_flipped ? 1u : 0u));
+
+  packed.uvs[0] = glm::packHalf1x16(vertex.uvs.x);
+  packed.uvs[1] = glm::packHalf1x16(vertex.uvs.y);
+}
+
+auto Afk::get_vertex_format(const Mesh &mesh) -> VertexFormat {
+  return mesh.bones.empty() ? VertexFormat::Static : VertexFormat::Skinned;
+}
+
+auto Afk::encode_octahedral(const vec3 &direction, std::int16_t (&encoded)[2]) -> void {
+  const auto length = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+
+  if (length == 0.0f) {
+    encoded[0] = 0;
+    encoded[1] = 0;
+    return;
+  }
+
+  // Project onto the octahedron, then fold its lower half over the upper.
+  auto point = vec2{direction.x, direction.y} / length;
+
+  if (direction.z < 0.0f) {
+    point = (vec2{1.0f} - glm::abs(vec2{point.y, point.x})) * sign_not_zero(point);
+  }
+
+  encoded[0] = static_cast<std::int16_t>(glm::packSnorm1x16(point.x));
+  encoded[1] = static_cast<std::int16_t>(glm::packSnorm1x16(point.y));
+}
+
+auto Afk::pack_static_vertex(const Vertex &vertex) -> StaticVertex {
+  auto packed = StaticVertex{};
+  pack_shared(vertex, packed);
+
+  return packed;
+}
+
+auto Afk::pack_skinned_vertex(const Vertex &vertex) -> SkinnedVertex {
+  auto packed = SkinnedVertex{};
+  pack_shared(vertex, packed);
+
+  for (auto i = std::size_t{0}; i < Vertex::MAX_VERTEX_BONES; ++i) {
+    afk_assert_debug(vertex.bone_indices[i] <= std::numeric_limits<std::uint8_t>::max(),
+                     "Bone index too large to pack");
+
+    packed.bone_indices[i] = static_cast<std::uint8_t>(vertex.bone_indices[i]);
+    packed.bone_weights[i] = glm::packUnorm1x16(vertex.bone_weights[i]);
+  }
+
+  return packed;
+}
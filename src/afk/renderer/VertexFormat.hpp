@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "afk/renderer/Mesh.hpp"
+
+namespace Afk {
+  /**
+   * Layout a mesh's vertices are uploaded in, picked by what the mesh uses
+   */
+  enum class VertexFormat { Static = 0, Skinned, Count };
+
+  /**
+   * Vertex of a mesh without bones, 24 bytes.
+   *
+   * Normals and tangents are octahedral encoded as snorm16 pairs, with the
+   * bitangent's handedness in the lowest bit of the tangent's second value
+   * (set when the bitangent is flipped). UVs are half floats.
+   */
+  struct StaticVertex {
+    glm::vec3 position      = {};
+    std::int16_t normal[2]  = {};
+    std::int16_t tangent[2] = {};
+    std::uint16_t uvs[2]    = {};
+  };
+  /**
+   * Vertex of a mesh with bones, 36 bytes. The static vertex followed by
+   * byte bone indices and unorm16 bone weights.
+   */
+  struct SkinnedVertex {
+    glm::vec3 position                                   = {};
+    std::int16_t normal[2]                               = {};
+    std::int16_t tangent[2]                              = {};
+    std::uint16_t uvs[2]                                 = {};
+    std::uint8_t bone_indices[Vertex::MAX_VERTEX_BONES]  = {};
+    std::uint16_t bone_weights[Vertex::MAX_VERTEX_BONES] = {};
+  };
+
+  static_assert(sizeof(StaticVertex) == 24, "Static vertices must be tightly packed");
+  static_assert(sizeof(SkinnedVertex) == 36, "Skinned vertices must be tightly packed");
+
+  /**
+   * Get the smallest format holding everything a mesh's vertices use
+   */
+  auto get_vertex_format(const Mesh &mesh) -> VertexFormat;
+  /**
+   * Encode a unit vector as a point on an octahedron unfolded onto a square,
+   * quantised to snorm16
+   */
+  auto encode_octahedral(const glm::vec3 &direction, std::int16_t (&encoded)[2]) -> void;
+  auto pack_static_vertex(const Vertex &vertex) -> StaticVertex;
+  auto pack_skinned_vertex(const Vertex &vertex) -> SkinnedVertex;
+}
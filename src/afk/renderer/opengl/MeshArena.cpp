@@ -0,0 +1,162 @@
+#include "afk/renderer/opengl/MeshArena.hpp"
+
+#include <algorithm>
+
+#include "afk/debug/Assert.hpp"
+
+using std::size_t;
+
+using Afk::OpenGl::MeshArena;
+
+/**
+ * Get the capacity to grow to, doubling until it holds what's needed
+ */
+static auto get_capacity(size_t capacity, size_t initial, size_t needed) -> size_t {
+  auto grown = std::max(capacity, initial);
+
+  while (grown < needed) {
+    grown *= 2;
+  }
+
+  return grown;
+}
+
+/**
+ * Make a larger buffer holding the used start of an old one, deleting the
+ * old one. The new buffer is left bound to GL_COPY_WRITE_BUFFER.
+ */
+static auto resize_buffer(GLuint buffer, size_t used_bytes, size_t capacity_bytes) -> GLuint {
+  auto resized = GLuint{0};
+  glGenBuffers(1, &resized);
+  afk_assert(resized > 0, "Mesh arena buffer creation failed");
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, resized);
+  glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(capacity_bytes), nullptr,
+               GL_STATIC_DRAW);
+
+  if (buffer > 0) {
+    if (used_bytes > 0) {
+      glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+      glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                          static_cast<GLsizeiptr>(used_bytes));
+    }
+
+    glDeleteBuffers(1, &buffer);
+  }
+
+  return resized;
+}
+
+auto MeshArena::initialize(bool headless, size_t _vertex_size, SetAttributes _set_attributes)
+    -> void {
+  afk_assert(this->set_attributes == nullptr, "Mesh arena already initialized");
+  afk_assert(_vertex_size > 0, "Mesh arena vertices must have a size");
+  afk_assert(_set_attributes != nullptr, "Mesh arena needs its vertex attributes");
+
+  this->is_headless    = headless;
+  this->vertex_size    = _vertex_size;
+  this->set_attributes = _set_attributes;
+
+  if (this->is_headless) {
+    return;
+  }
+
+  glGenVertexArrays(1, &this->vao);
+  afk_assert(this->vao > 0, "Mesh arena VAO creation failed");
+
+  this->reserve(this->num_vertices, this->num_index_bytes);
+}
+
+auto MeshArena::allocate(size_t vertex_count, size_t index_bytes) -> Range {
+  const auto range = Range{this->num_vertices, this->num_index_bytes};
+  // Round up, so the next mesh's indices start aligned whatever their width.
+  const auto aligned_bytes =
+      (index_bytes + MeshArena::INDEX_ALIGNMENT - 1) / MeshArena::INDEX_ALIGNMENT *
+      MeshArena::INDEX_ALIGNMENT;
+
+  this->reserve(this->num_vertices + vertex_count, this->num_index_bytes + aligned_bytes);
+  this->num_vertices += vertex_count;
+  this->num_index_bytes += aligned_bytes;
+
+  return range;
+}
+
+auto MeshArena::upload_vertices(size_t base_vertex, const void *vertices,
+                                size_t vertex_count) const -> void {
+  afk_assert_debug(base_vertex + vertex_count <= this->num_vertices,
+                   "Vertices outside their range");
+
+  if (this->is_headless) {
+    return;
+  }
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, this->vbo);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(base_vertex * this->vertex_size),
+                  static_cast<GLsizeiptr>(vertex_count * this->vertex_size), vertices);
+}
+
+auto MeshArena::upload_indices(size_t index_offset, const void *indices,
+                               size_t index_bytes) const -> void {
+  afk_assert_debug(index_offset + index_bytes <= this->num_index_bytes,
+                   "Indices outside their range");
+
+  if (this->is_headless) {
+    return;
+  }
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, this->ibo);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(index_offset),
+                  static_cast<GLsizeiptr>(index_bytes), indices);
+}
+
+auto MeshArena::get_vao() const -> GLuint {
+  return this->vao;
+}
+
+auto MeshArena::get_vertex_size() const -> size_t {
+  return this->vertex_size;
+}
+
+auto MeshArena::get_num_vertices() const -> size_t {
+  return this->num_vertices;
+}
+
+auto MeshArena::get_num_index_bytes() const -> size_t {
+  return this->num_index_bytes;
+}
+
+auto MeshArena::reserve(size_t vertices, size_t index_bytes) -> void {
+  if (this->is_headless || this->vao == 0) {
+    return;
+  }
+
+  const auto is_vertex_full = this->vbo == 0 || vertices > this->vertex_capacity;
+  const auto is_index_full  = this->ibo == 0 || index_bytes > this->index_capacity;
+
+  if (!is_vertex_full && !is_index_full) {
+    return;
+  }
+
+  // Both buffers are VAO state, so replacing one means pointing the VAO at it.
+  glBindVertexArray(this->vao);
+
+  if (is_vertex_full) {
+    this->vertex_capacity =
+        get_capacity(this->vertex_capacity, MeshArena::INITIAL_VERTICES, vertices);
+    this->vbo = resize_buffer(this->vbo, this->num_vertices * this->vertex_size,
+                              this->vertex_capacity * this->vertex_size);
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+    this->set_attributes();
+  }
+
+  if (is_index_full) {
+    this->index_capacity =
+        get_capacity(this->index_capacity, MeshArena::INITIAL_INDEX_BYTES, index_bytes);
+    this->ibo = resize_buffer(this->ibo, this->num_index_bytes, this->index_capacity);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ibo);
+  }
+
+  glBindVertexArray(0);
+}
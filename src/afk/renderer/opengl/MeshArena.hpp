@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+namespace Afk {
+  namespace OpenGl {
+    /**
+     * Vertex and index buffers shared by every mesh of one vertex format,
+     * behind one VAO. Each mesh is handed a range of both, and is drawn with
+     * its first vertex as the base vertex, so drawing different meshes needs
+     * no buffer or VAO binds. Meshes are never freed, so ranges are handed
+     * out in order and the buffers double when they fill.
+     *
+     * Meshes pick their own index width, so the index buffer is sized in
+     * bytes, each range aligned for the widest index.
+     */
+    class MeshArena {
+    public:
+      /**
+       * Point the bound VAO's attributes at the bound vertex buffer, with
+       * offsets from its start
+       */
+      using SetAttributes = void (*)();
+
+      /**
+       * Where a mesh's vertices and indices start in the arena
+       */
+      struct Range {
+        std::size_t base_vertex  = {};
+        std::size_t index_offset = {};
+      };
+
+      static constexpr std::size_t INITIAL_VERTICES    = std::size_t{1} << 16;
+      static constexpr std::size_t INITIAL_INDEX_BYTES = std::size_t{1} << 20;
+      static constexpr std::size_t INDEX_ALIGNMENT     = 4;
+
+      MeshArena()                  = default;
+      MeshArena(const MeshArena &) = delete;
+      MeshArena(MeshArena &&)      = delete;
+      auto operator=(const MeshArena &) -> MeshArena & = delete;
+      auto operator=(MeshArena &&) -> MeshArena &      = delete;
+
+      /**
+       * Create the VAO and buffers. A headless arena only hands out ranges.
+       */
+      auto initialize(bool headless, std::size_t _vertex_size, SetAttributes _set_attributes)
+          -> void;
+      /**
+       * Reserve a range for a mesh, growing the buffers if it doesn't fit
+       */
+      auto allocate(std::size_t vertex_count, std::size_t index_bytes) -> Range;
+      auto upload_vertices(std::size_t base_vertex, const void *vertices,
+                           std::size_t vertex_count) const -> void;
+      auto upload_indices(std::size_t index_offset, const void *indices,
+                          std::size_t index_bytes) const -> void;
+
+      auto get_vao() const -> GLuint;
+      auto get_vertex_size() const -> std::size_t;
+      auto get_num_vertices() const -> std::size_t;
+      auto get_num_index_bytes() const -> std::size_t;
+
+    private:
+      std::size_t vertex_size      = {};
+      SetAttributes set_attributes = nullptr;
+      bool is_headless             = true;
+      GLuint vao                   = {};
+      GLuint vbo                   = {};
+      GLuint ibo                   = {};
+      std::size_t num_vertices     = {};
+      std::size_t num_index_bytes  = {};
+      std::size_t vertex_capacity  = {};
+      std::size_t index_capacity   = {};
+
+      /**
+       * Grow the buffers to hold at least this many vertices and index bytes,
+       * keeping what they already hold
+       */
+      auto reserve(std::size_t vertices, std::size_t index_bytes) -> void;
+    };
+  }
+}
@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <typeindex>
 #include <typeinfo>
 #include <vector>
@@ -11,7 +12,10 @@
 #include <glad/glad.h>
 
 #include "afk/physics/Transform.hpp"
+#include "afk/renderer/Bounds.hpp"
 #include "afk/renderer/Mesh.hpp"
+#include "afk/renderer/OcclusionBuffer.hpp"
+#include "afk/renderer/VertexFormat.hpp"
 #include "afk/renderer/opengl/TextureHandle.hpp"
 #include "afk/utility/ArrayOf.hpp"
 
@@ -27,7 +31,17 @@ namespace Afk {
      * Mesh handle - represents a loaded mesh
      */
     struct MeshHandle {
+      /**
+       * Range of the index buffer a level of detail is drawn from
+       */
+      struct Lod {
+        // Bytes into the arena's index buffer.
+        std::size_t offset      = {};
+        std::size_t num_indices = {};
+      };
+
       using Textures = std::vector<TextureHandle>;
+      using Lods     = std::vector<Lod>;
 
       static constexpr auto GL_INDICES =
           frozen::unordered_map<ctti::type_id_t, GLenum, 6, IndexHash>(
@@ -38,26 +52,46 @@ namespace Afk {
                {ctti::type_id<int32_t>(), GL_INT},
                {ctti::type_id<uint32_t>(), GL_UNSIGNED_INT}});
 
-      static constexpr auto INDEX = GL_INDICES.at(ctti::type_id<Index>());
+      static constexpr auto INDEX       = GL_INDICES.at(ctti::type_id<Index>());
+      static constexpr auto SHORT_INDEX = GL_INDICES.at(ctti::type_id<std::uint16_t>());
 
       enum class Buffer {
         Vertex = 0,
         Normal,
         Uv,
         Tangent,
-        Bitangent,
         BoneIndices,
-        BoneWeights
+        BoneWeights,
+        // Per-instance model matrix, a column per location.
+        InstanceModel = 8,
+        // Per-instance first skinning matrix.
+        InstanceBones = 12
       };
 
-      GLuint vao              = {};
-      GLuint vbo              = {};
-      GLuint ibo              = {};
-      GLuint bones            = {};
-      Textures textures       = {};
-      std::size_t num_indices = {};
+      // The arena's VAO, shared by every mesh of the vertex format.
+      GLuint vao               = {};
+      GLuint bones             = {};
+      Textures textures        = {};
+      std::size_t num_indices  = {};
+      VertexFormat format      = VertexFormat::Static;
+      // Arena vertex the mesh's indices count from.
+      GLint base_vertex        = {};
+      // Indices are 16 bit when the mesh has few enough vertices.
+      GLenum index_type        = INDEX;
+      // The full mesh then its coarser levels, each a range of the arena's indices.
+      Lods lods                = {};
+      std::uint32_t material   = {};
+      // Unique per loaded mesh, keys draws of the same mesh together.
+      std::uint32_t id         = {};
+      // Start of the mesh's bones in its model's skinning matrices.
+      std::uint32_t first_bone = {};
 
       Transform transform = {};
+      // Bounds of the vertices, before the mesh transform.
+      Aabb aabb                      = {};
+      BoundingSphere bounding_sphere = {};
+      // Triangles kept on the CPU if the mesh's model hides what's behind it.
+      std::shared_ptr<const OccluderMesh> occluder = {};
     };
   }
 }
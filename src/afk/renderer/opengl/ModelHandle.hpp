@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "afk/physics/Transform.hpp"
+#include "afk/renderer/Bounds.hpp"
 #include "afk/renderer/Renderer.hpp"
 
 namespace Afk {
@@ -14,6 +15,8 @@ namespace Afk {
       using Meshes = std::vector<MeshHandle>;
 
       Meshes meshes = {};
+      // Bounds of every mesh, in the model's space.
+      Aabb aabb = {};
     };
   }
 };
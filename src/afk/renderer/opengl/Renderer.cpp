@@ -1,10 +1,16 @@
 #include "afk/renderer/opengl/Renderer.hpp"
 
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstring>
 #include <filesystem>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -13,32 +19,38 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_precision.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
-#include <stb/stb_image.h>
 // Must be loaded after GLAD.
 #include <GLFW/glfw3.h>
 
 #include "afk/Afk.hpp"
 #include "afk/component/AnimComponent.hpp"
 #include "afk/debug/Assert.hpp"
+#include "afk/debug/Profiler.hpp"
 #include "afk/io/Log.hpp"
 #include "afk/io/Path.hpp"
 #include "afk/renderer/Bone.hpp"
+#include "afk/renderer/Bounds.hpp"
+#include "afk/renderer/Frustum.hpp"
 #include "afk/renderer/Mesh.hpp"
 #include "afk/renderer/Model.hpp"
+#include "afk/renderer/OcclusionBuffer.hpp"
+#include "afk/renderer/RenderQueue.hpp"
 #include "afk/renderer/Shader.hpp"
 #include "afk/renderer/ShaderProgram.hpp"
 #include "afk/renderer/Texture.hpp"
+#include "afk/renderer/TextureCache.hpp"
 #include "afk/renderer/opengl/ModelHandle.hpp"
 #include "afk/renderer/opengl/ShaderHandle.hpp"
 #include "afk/renderer/opengl/ShaderProgramHandle.hpp"
+#include "afk/renderer/opengl/TerrainHandle.hpp"
 #include "afk/renderer/opengl/TextureHandle.hpp"
 
 using namespace std::string_literals;
 using std::optional;
 using std::pair;
-using std::shared_ptr;
 using std::size_t;
 using std::string;
 using std::unordered_map;
@@ -47,19 +59,33 @@ using std::filesystem::path;
 
 using glm::ivec2;
 using glm::mat4;
+using glm::vec2;
 using glm::vec3;
 using glm::vec4;
 
+using Afk::Aabb;
 using Afk::Bone;
+using Afk::CookedTexture;
 using Afk::Engine;
+using Afk::OccluderMesh;
+using Afk::RenderItem;
+using Afk::RenderPass;
 using Afk::Shader;
 using Afk::ShaderProgram;
+using Afk::SkinnedVertex;
+using Afk::StaticVertex;
 using Afk::Texture;
+using Afk::TextureCache;
+using Afk::TextureFormat;
+using Afk::VertexFormat;
+using Afk::OpenGl::MeshArena;
 using Afk::OpenGl::ModelHandle;
 using Afk::OpenGl::Renderer;
 using Afk::OpenGl::ShaderHandle;
 using Afk::OpenGl::ShaderProgramHandle;
+using Afk::OpenGl::TerrainHandle;
 using Afk::OpenGl::TextureHandle;
+using Uniform = Afk::OpenGl::ShaderProgramHandle::Uniform;
 using Buffer = Afk::OpenGl::MeshHandle::Buffer;
 namespace Io = Afk::Io;
 
@@ -71,6 +97,37 @@ constexpr auto material_strings =
         {Texture::Type::Height, "texture_height"},
     });
 
+constexpr auto texture_uniforms =
+    frozen::make_unordered_map<Texture::Type, ShaderProgramHandle::Uniform>({
+        {Texture::Type::Diffuse, ShaderProgramHandle::Uniform::Diffuse},
+        {Texture::Type::Specular, ShaderProgramHandle::Uniform::Specular},
+        {Texture::Type::Normal, ShaderProgramHandle::Uniform::Normal},
+        {Texture::Type::Height, ShaderProgramHandle::Uniform::Height},
+    });
+
+// Names of the uniforms the renderer sets, in Uniform order.
+constexpr auto uniform_names =
+    std::array<const char *, static_cast<size_t>(ShaderProgramHandle::Uniform::Count)>{
+        "u_matrices.model", "u_textures.diffuse", "u_textures.specular",
+        "u_textures.normal", "u_textures.height", "u_terrain.heights",
+        "u_terrain.size",   "u_terrain.camera",   "u_terrain.offset",
+        "u_terrain.scale",  "u_terrain.morph",    "u_skin.bones",
+        "u_skin.offset"};
+
+// S3TC is an extension, so GLAD may not define its formats.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+constexpr auto gl_texture_formats = frozen::make_unordered_map<TextureFormat, GLenum>({
+    {TextureFormat::Bc1, GL_COMPRESSED_RGB_S3TC_DXT1_EXT},
+    {TextureFormat::Bc3, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT},
+    {TextureFormat::Bc5, GL_COMPRESSED_RG_RGTC2},
+});
+
 constexpr auto gl_shader_types = frozen::make_unordered_map<Shader::Type, GLenum>({
     {Shader::Type::Vertex, GL_VERTEX_SHADER},
     {Shader::Type::Fragment, GL_FRAGMENT_SHADER},
@@ -83,18 +140,88 @@ static auto resize_window_callback([[maybe_unused]] GLFWwindow *window,
   afk.renderer.set_viewport(0, 0, width, height);
 }
 
+static auto has_extension(const char *name) -> bool {
+  auto count = GLint{0};
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+  for (auto i = GLint{0}; i < count; ++i) {
+    const auto *extension = glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i));
+
+    if (std::strcmp(reinterpret_cast<const char *>(extension), name) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Point the bound VAO's attributes at a vertex buffer of a packed vertex
+ * format
+ */
+template<typename T>
+static auto set_vertex_attributes() -> void {
+  glEnableVertexAttribArray(static_cast<GLuint>(Buffer::Vertex));
+  glVertexAttribPointer(static_cast<GLuint>(Buffer::Vertex), 3, GL_FLOAT, GL_FALSE, sizeof(T),
+                        reinterpret_cast<void *>(offsetof(T, position)));
+
+  // Octahedral normals, decoded in the shader.
+  glEnableVertexAttribArray(static_cast<GLuint>(Buffer::Normal));
+  glVertexAttribPointer(static_cast<GLuint>(Buffer::Normal), 2, GL_SHORT, GL_TRUE, sizeof(T),
+                        reinterpret_cast<void *>(offsetof(T, normal)));
+
+  // UVs
+  glEnableVertexAttribArray(static_cast<GLuint>(Buffer::Uv));
+  glVertexAttribPointer(static_cast<GLuint>(Buffer::Uv), 2, GL_HALF_FLOAT, GL_FALSE, sizeof(T),
+                        reinterpret_cast<void *>(offsetof(T, uvs)));
+
+  // Octahedral tangents, read as integers to keep the bitangent's sign bit.
+  glEnableVertexAttribArray(static_cast<GLuint>(Buffer::Tangent));
+  glVertexAttribIPointer(static_cast<GLuint>(Buffer::Tangent), 2, GL_SHORT, sizeof(T),
+                         reinterpret_cast<void *>(offsetof(T, tangent)));
+
+  if constexpr (std::is_same_v<T, SkinnedVertex>) {
+    glEnableVertexAttribArray(static_cast<GLuint>(Buffer::BoneIndices));
+    glVertexAttribIPointer(static_cast<GLuint>(Buffer::BoneIndices), 4, GL_UNSIGNED_BYTE,
+                           sizeof(T), reinterpret_cast<void *>(offsetof(T, bone_indices)));
+
+    glEnableVertexAttribArray(static_cast<GLuint>(Buffer::BoneWeights));
+    glVertexAttribPointer(static_cast<GLuint>(Buffer::BoneWeights), 4, GL_UNSIGNED_SHORT,
+                          GL_TRUE, sizeof(T),
+                          reinterpret_cast<void *>(offsetof(T, bone_weights)));
+  }
+}
+
+static auto initialize_mesh_arenas(MeshArena *arenas, bool headless) -> void {
+  arenas[static_cast<size_t>(VertexFormat::Static)].initialize(
+      headless, sizeof(StaticVertex), set_vertex_attributes<StaticVertex>);
+  arenas[static_cast<size_t>(VertexFormat::Skinned)].initialize(
+      headless, sizeof(SkinnedVertex), set_vertex_attributes<SkinnedVertex>);
+}
+
 Renderer::Renderer()
   : models(0, PathHash{}, PathEquals{}), textures(0, PathHash{}, PathEquals{}),
     shaders(0, PathHash{}, PathEquals{}),
     shader_programs(0, PathHash{}, PathEquals{}) {}
 
 Renderer::~Renderer() {
-  glfwDestroyWindow(this->window);
-  glfwTerminate();
+  if (this->window != nullptr) {
+    glfwDestroyWindow(this->window);
+    glfwTerminate();
+  }
 }
 
-auto Renderer::initialize() -> void {
+auto Renderer::initialize(bool headless) -> void {
   afk_assert(!this->is_initialized, "Renderer already initialized");
+
+  if (headless) {
+    Io::log << "Renderer running headless.\n";
+    this->is_headless    = true;
+    this->is_initialized = true;
+    initialize_mesh_arenas(this->mesh_arenas.data(), true);
+    return;
+  }
+
   afk_assert(glfwInit(), "Failed to initialize GLFW");
 
   // FIXME: Give user an option to change graphics settings.
@@ -122,10 +249,62 @@ auto Renderer::initialize() -> void {
              "Failed to initialize GLAD");
   glfwSetFramebufferSizeCallback(this->window, resize_window_callback);
 
+  glGenBuffers(1, &this->instance_vbo);
+  afk_assert(this->instance_vbo > 0, "Instance VBO creation failed");
+  glGenBuffers(1, &this->instance_bone_vbo);
+  afk_assert(this->instance_bone_vbo > 0, "Instance bone VBO creation failed");
+
+  // Skinning matrices are read as four RGBA texels each.
+  glGenBuffers(1, &this->bone_buffer);
+  afk_assert(this->bone_buffer > 0, "Bone buffer creation failed");
+  glBindBuffer(GL_TEXTURE_BUFFER, this->bone_buffer);
+  glBufferData(GL_TEXTURE_BUFFER, sizeof(mat4), nullptr, GL_STREAM_DRAW);
+  glGenTextures(1, &this->bone_texture);
+  afk_assert(this->bone_texture > 0, "Bone texture creation failed");
+  glActiveTexture(GL_TEXTURE0 + Renderer::BONES_TEXTURE_UNIT);
+  glBindTexture(GL_TEXTURE_BUFFER, this->bone_texture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, this->bone_buffer);
+  glActiveTexture(GL_TEXTURE0);
+
+  initialize_mesh_arenas(this->mesh_arenas.data(), false);
+
+  // Every program's camera block reads the one buffer, rewritten each frame.
+  glGenBuffers(1, &this->camera_ubo);
+  afk_assert(this->camera_ubo > 0, "Camera UBO creation failed");
+  glBindBuffer(GL_UNIFORM_BUFFER, this->camera_ubo);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), nullptr, GL_DYNAMIC_DRAW);
+  glBindBufferBase(GL_UNIFORM_BUFFER, Renderer::CAMERA_BINDING, this->camera_ubo);
+
+#ifdef AFK_COMPRESS_TEXTURES
+  // RGTC is core, S3TC is an extension nearly every desktop driver has.
+  this->texture_formats.set(static_cast<size_t>(TextureFormat::Bc5));
+
+  if (has_extension("GL_EXT_texture_compression_s3tc")) {
+    this->texture_formats.set(static_cast<size_t>(TextureFormat::Bc1));
+    this->texture_formats.set(static_cast<size_t>(TextureFormat::Bc3));
+  }
+#endif
+
   this->is_initialized = true;
 }
 
+auto Renderer::get_is_headless() const -> bool {
+  return this->is_headless;
+}
+
+auto Renderer::get_draw_count() const -> size_t {
+  return this->draw_stats.commands;
+}
+
+auto Renderer::get_draw_stats() const -> const DrawStats & {
+  return this->draw_stats;
+}
+
 auto Renderer::set_option(GLenum option, bool state) const -> void {
+  if (this->is_headless) {
+    return;
+  }
+
   if (state) {
     glEnable(option);
   } else {
@@ -134,6 +313,10 @@ auto Renderer::set_option(GLenum option, bool state) const -> void {
 }
 
 auto Renderer::get_window_size() const -> ivec2 {
+  if (this->is_headless) {
+    return this->headless_size;
+  }
+
   auto width  = 0;
   auto height = 0;
   glfwGetFramebufferSize(this->window, &width, &height);
@@ -151,6 +334,10 @@ auto Renderer::clear_screen(vec4 clear_color) const -> void {
   afk_assert_debug(clear_color.w >= 0.0f && clear_color.w <= 1.0f,
                    "Alpha channel out of range");
 
+  if (this->is_headless) {
+    return;
+  }
+
   glClearColor(clear_color.x / 255.0f, clear_color.y / 255.0f,
                clear_color.z / 255.0f, clear_color.w);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -158,10 +345,18 @@ auto Renderer::clear_screen(vec4 clear_color) const -> void {
 }
 
 auto Renderer::set_viewport(int x, int y, int width, int height) const -> void {
+  if (this->is_headless) {
+    return;
+  }
+
   glViewport(x, y, static_cast<GLsizei>(width), static_cast<GLsizei>(height));
 }
 
 auto Renderer::swap_buffers() -> void {
+  if (this->is_headless) {
+    return;
+  }
+
   glfwSwapBuffers(this->window);
 }
 
@@ -216,78 +411,631 @@ auto Renderer::bind_texture(const TextureHandle &texture) const -> void {
 }
 
 auto Renderer::draw() -> void {
-  while (!this->draw_queue.empty()) {
-    const auto command  = this->draw_queue.front();
-    const auto &model   = this->get_model(command.model_path);
-    const auto &program = this->get_shader_program(command.shader_program_path);
+  afk_profile_zone("Renderer::draw");
+  const auto &packet         = this->frame_packets[this->front_packet];
+  const auto &commands       = packet.commands;
+  const auto view_projection = packet.projection * packet.view;
+  auto *arena                = &Afk::Engine::get().frame_arena;
+
+  auto programs = Memory::FrameVector<const ShaderProgramResource *>{
+      Memory::FrameAllocator<const ShaderProgramResource *>{arena}};
+  auto draws = Memory::FrameVector<MeshDraw>{Memory::FrameAllocator<MeshDraw>{arena}};
+  auto aabbs = Memory::FrameVector<Aabb>{Memory::FrameAllocator<Aabb>{arena}};
+  auto items = Memory::FrameVector<RenderItem>{Memory::FrameAllocator<RenderItem>{arena}};
+
+  programs.reserve(commands.size());
+
+  // Resolve every command once, then place each of its meshes in the world.
+  for (auto i = size_t{0}; i < commands.size(); ++i) {
+    const auto &command = commands[i];
+
+    programs.push_back(&this->find_shader_program(command.shader_program));
+
+    // Models still importing are drawn once they're uploaded, rather than
+    // stalling the frame to load them here.
+    if (this->importing_models.count(this->model_resources.get(command.model).file_path) == 1) {
+      continue;
+    }
 
-    this->draw_queue.pop();
-    this->draw_model(model, program, command.transform, command.game_object);
+    const auto &model = this->find_model(command.model);
+
+    for (const auto &mesh : model.meshes) {
+      const auto model_matrix = Renderer::get_model_matrix(command.transform, mesh.transform);
+      // Skinned meshes of models without a pose are drawn in their rest pose.
+      const auto first_bone = command.bones.has_value() && mesh.format == VertexFormat::Skinned
+                                  ? static_cast<GLint>(*command.bones + mesh.first_bone)
+                                  : GLint{-1};
+
+      draws.push_back({&mesh, static_cast<std::uint32_t>(i), model_matrix, 0, first_bone});
+      aabbs.push_back(Afk::transform_aabb(mesh.aabb, model_matrix));
+    }
   }
+
+  // Only key the meshes inside the view.
+  auto visible = Memory::FrameVector<std::uint8_t>(draws.size(), std::uint8_t{0},
+                                                   Memory::FrameAllocator<std::uint8_t>{arena});
+  const auto num_in_view =
+      Afk::cull_aabbs(Afk::make_frustum(view_projection), aabbs.data(), aabbs.size(),
+                      visible.data());
+  const auto num_dropped =
+      this->select_lods(packet, draws.data(), draws.size(), visible.data());
+  const auto num_occluded =
+      this->cull_occluded(view_projection, draws.data(), aabbs.data(), draws.size(),
+                          visible.data());
+  const auto num_visible = num_in_view - num_dropped - num_occluded;
+
+  items.reserve(num_visible);
+
+  for (auto i = size_t{0}; i < draws.size(); ++i) {
+    if (visible[i] == 0) {
+      continue;
+    }
+
+    const auto &draw = draws[i];
+    const auto clip  = view_projection * vec4{aabbs[i].get_center(), 1.0f};
+    const auto depth = clip.w > 0.0f ? clip.z / clip.w * 0.5f + 0.5f : 0.0f;
+    // Each level of detail is drawn separately, so is keyed as its own mesh.
+    const auto mesh = draw.mesh->id * static_cast<std::uint32_t>(Mesh::MAX_LODS) + draw.lod;
+    const auto key  =
+        Afk::make_sort_key(RenderPass::Opaque, commands[draw.command].shader_program.index,
+                           draw.mesh->material, mesh, depth);
+
+    items.push_back({key, static_cast<std::uint32_t>(i)});
+  }
+
+  auto scratch = Memory::FrameVector<RenderItem>(items.size(), RenderItem{},
+                                                 Memory::FrameAllocator<RenderItem>{arena});
+  Afk::radix_sort(items.data(), scratch.data(), items.size());
+
+  // Sorting leaves draws of the same mesh and program next to each other, so
+  // their model matrices are contiguous and each run can be one instanced draw.
+  auto model_matrices = Memory::FrameVector<mat4>(items.size(), mat4{1.0f},
+                                                  Memory::FrameAllocator<mat4>{arena});
+  auto first_bones    = Memory::FrameVector<GLint>(items.size(), GLint{-1},
+                                                   Memory::FrameAllocator<GLint>{arena});
+  auto is_instancing  = false;
+
+  for (auto i = size_t{0}; i < items.size(); ++i) {
+    const auto &draw = draws[items[i].draw];
+
+    model_matrices[i] = draw.model_matrix;
+    first_bones[i]    = draw.first_bone;
+    is_instancing     = is_instancing || programs[draw.command]->instanced != nullptr;
+  }
+
+  this->draw_stats          = DrawStats{};
+  this->draw_stats.commands = commands.size();
+  this->draw_stats.meshes   = draws.size();
+  this->draw_stats.culled   = draws.size() - num_in_view;
+  this->draw_stats.occluded = num_occluded;
+  this->draw_stats.dropped  = num_dropped;
+  this->draw_stats.bones    = packet.bones.size();
+
+  if (!this->is_headless) {
+    glPolygonMode(GL_FRONT_AND_BACK, packet.wireframe ? GL_LINE : GL_FILL);
+
+    const auto camera = CameraBlock{packet.view, packet.projection};
+    glBindBuffer(GL_UNIFORM_BUFFER, this->camera_ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraBlock), &camera);
+
+    if (is_instancing) {
+      // Reallocating every frame orphans the buffer the last frame drew from.
+      glBindBuffer(GL_ARRAY_BUFFER, this->instance_vbo);
+      glBufferData(GL_ARRAY_BUFFER, model_matrices.size() * sizeof(mat4),
+                   model_matrices.data(), GL_STREAM_DRAW);
+      glBindBuffer(GL_ARRAY_BUFFER, this->instance_bone_vbo);
+      glBufferData(GL_ARRAY_BUFFER, first_bones.size() * sizeof(GLint), first_bones.data(),
+                   GL_STREAM_DRAW);
+    }
+
+    if (!packet.bones.empty()) {
+      glBindBuffer(GL_TEXTURE_BUFFER, this->bone_buffer);
+      glBufferData(GL_TEXTURE_BUFFER, packet.bones.size() * sizeof(mat4), packet.bones.data(),
+                   GL_STREAM_DRAW);
+      glActiveTexture(GL_TEXTURE0 + Renderer::BONES_TEXTURE_UNIT);
+      glBindTexture(GL_TEXTURE_BUFFER, this->bone_texture);
+      glActiveTexture(GL_TEXTURE0);
+    }
+  }
+
+  // Only touch GL state when the sorted keys say it changed. Headless still
+  // counts the binds and draw calls it would have made.
+  const ShaderProgramHandle *bound_program = nullptr;
+  auto bound_material                      = std::optional<std::uint32_t>{};
+  auto bound_vao                           = std::optional<GLuint>{};
+  auto multi_draw                          = MultiDraw{};
+  multi_draw.counts  = Memory::FrameVector<GLsizei>{Memory::FrameAllocator<GLsizei>{arena}};
+  multi_draw.offsets =
+      Memory::FrameVector<const void *>{Memory::FrameAllocator<const void *>{arena}};
+  multi_draw.base_vertices = Memory::FrameVector<GLint>{Memory::FrameAllocator<GLint>{arena}};
+
+  for (auto first = size_t{0}; first < items.size();) {
+    const auto &draw     = draws[items[first].draw];
+    const auto *resource = programs[draw.command];
+    const auto &mesh     = *draw.mesh;
+    const auto &lod      = mesh.lods[draw.lod];
+    auto last            = first + 1;
+
+    while (last < items.size() && programs[draws[items[last].draw].command] == resource &&
+           draws[items[last].draw].mesh == &mesh && draws[items[last].draw].lod == draw.lod) {
+      ++last;
+    }
+
+    const auto count        = last - first;
+    const auto is_instanced = resource->instanced != nullptr && count >= Renderer::MIN_INSTANCES;
+    const auto *program     = is_instanced ? resource->instanced : resource->handle;
+
+    // Anything that changes state ends the batch drawn with the old state.
+    if (bound_program != nullptr &&
+        (program != bound_program || is_instanced || mesh.material != bound_material ||
+         mesh.vao != bound_vao || mesh.index_type != multi_draw.index_type)) {
+      this->draw_multi(*bound_program, multi_draw);
+    }
+
+    if (program != bound_program) {
+      bound_program  = program;
+      bound_material = std::nullopt;
+      ++this->draw_stats.program_binds;
+
+      if (!this->is_headless) {
+        this->use_shader(*program);
+      }
+    }
+
+    if (mesh.material != bound_material) {
+      bound_material = mesh.material;
+      this->draw_stats.texture_binds += mesh.textures.size();
+
+      if (!this->is_headless) {
+        this->bind_material(*program, mesh);
+      }
+    }
+
+    if (mesh.vao != bound_vao) {
+      bound_vao = mesh.vao;
+      ++this->draw_stats.vao_binds;
+
+      if (!this->is_headless) {
+        glBindVertexArray(mesh.vao);
+      }
+    }
+
+    this->draw_stats.triangles += count * lod.num_indices / 3;
+
+    if (is_instanced) {
+      ++this->draw_stats.draw_calls;
+
+      if (!this->is_headless) {
+        this->draw_mesh_instanced(mesh, lod, first, count);
+      }
+    } else {
+      // Meshes share the arena's buffers, so those drawn with the same model
+      // matrix and skinning matrices can go in one call.
+      for (auto i = first; i < last; ++i) {
+        if (!multi_draw.counts.empty() && (model_matrices[i] != multi_draw.model_matrix ||
+                                           first_bones[i] != multi_draw.first_bone)) {
+          this->draw_multi(*program, multi_draw);
+        }
+
+        multi_draw.model_matrix = model_matrices[i];
+        multi_draw.first_bone   = first_bones[i];
+        multi_draw.index_type   = mesh.index_type;
+        multi_draw.counts.push_back(static_cast<GLsizei>(lod.num_indices));
+        multi_draw.offsets.push_back(reinterpret_cast<const void *>(lod.offset));
+        multi_draw.base_vertices.push_back(mesh.base_vertex);
+      }
+    }
+
+    first = last;
+  }
+
+  if (bound_program != nullptr) {
+    this->draw_multi(*bound_program, multi_draw);
+  }
+
+  this->draw_terrain();
+
+  if (!this->is_headless) {
+    glBindVertexArray(0);
+    this->set_texture_unit(GL_TEXTURE0);
+  }
+}
+
+auto Renderer::resolve_model(const path &file_path) -> ModelId {
+  const auto lock = std::lock_guard{this->resolve_mutex};
+
+  if (const auto id = this->model_ids.find(file_path); id != this->model_ids.end()) {
+    return id->second;
+  }
+
+  const auto id = this->model_resources.add({file_path});
+  this->model_ids.emplace(file_path, id);
+
+  return id;
+}
+
+auto Renderer::resolve_shader_program(const path &file_path) -> ShaderProgramId {
+  const auto lock = std::lock_guard{this->resolve_mutex};
+
+  if (const auto id = this->shader_program_ids.find(file_path);
+      id != this->shader_program_ids.end()) {
+    return id->second;
+  }
+
+  const auto id = this->shader_program_resources.add({file_path});
+  this->shader_program_ids.emplace(file_path, id);
+
+  return id;
 }
 
 auto Renderer::queue_draw(DrawCommand command) -> void {
-  this->draw_queue.push(command);
+  this->frame_packets[1 - this->front_packet].commands.push_back(command);
 }
 
-auto Renderer::setup_view(const ShaderProgramHandle &shader_program) const -> void {
-  const auto &afk        = Engine::get();
-  const auto window_size = this->get_window_size();
-  const auto projection =
-      afk.camera.get_projection_matrix(window_size.x, window_size.y);
-  const auto view = afk.camera.get_view_matrix();
+auto Renderer::queue_terrain(TerrainCommand command) -> void {
+  this->frame_packets[1 - this->front_packet].terrain = std::move(command);
+}
 
-  this->set_uniform(shader_program, "u_matrices.projection", projection);
-  this->set_uniform(shader_program, "u_matrices.view", view);
+auto Renderer::queue_camera(const glm::mat4 &projection, const glm::mat4 &view) -> void {
+  auto &packet      = this->frame_packets[1 - this->front_packet];
+  packet.projection = projection;
+  packet.view       = view;
 }
 
-auto Renderer::draw_model(const ModelHandle &model,
-                          const ShaderProgramHandle &shader_program, Transform transform,
-                          optional<GameObject> game_object) const -> void {
-  glPolygonMode(GL_FRONT_AND_BACK, this->wireframe_enabled ? GL_LINE : GL_FILL);
-  this->use_shader(shader_program);
-  this->setup_view(shader_program);
+auto Renderer::queue_bones(size_t count) -> std::uint32_t {
+  auto &bones      = this->frame_packets[1 - this->front_packet].bones;
+  const auto first = static_cast<std::uint32_t>(bones.size());
+  bones.resize(bones.size() + count, mat4{1.0f});
 
-  const auto &afk = Afk::Engine::get();
+  return first;
+}
 
-  for (const auto &mesh : model.meshes) {
-    auto material_bound = vector<bool>(static_cast<size_t>(Texture::Type::Count));
+auto Renderer::get_queued_bones() -> mat4 * {
+  return this->frame_packets[1 - this->front_packet].bones.data();
+}
+
+auto Renderer::swap_frame_packets() -> void {
+  this->front_packet = 1 - this->front_packet;
+
+  auto &front     = this->frame_packets[this->front_packet];
+  auto &back      = this->frame_packets[1 - this->front_packet];
+  front.wireframe = this->wireframe_enabled;
+
+  // The back packet's commands were allocated in a frame the arena is about
+  // to recycle, so start it over in this frame's memory.
+  back.commands = Memory::FrameVector<DrawCommand>{
+      Memory::FrameAllocator<DrawCommand>{&Afk::Engine::get().frame_arena}};
+  back.commands.reserve(front.commands.size());
+  back.bones = Memory::FrameVector<mat4>{
+      Memory::FrameAllocator<mat4>{&Afk::Engine::get().frame_arena}};
+  back.bones.reserve(front.bones.size());
+  back.terrain = std::nullopt;
+}
+
+auto Renderer::get_model_bounds(ModelId id) -> optional<Aabb> {
+  const auto lock = std::lock_guard{this->resolve_mutex};
+  const auto aabb = this->model_bounds.find(this->model_resources.get(id).file_path);
+
+  if (aabb == this->model_bounds.end()) {
+    return std::nullopt;
+  }
+
+  return aabb->second;
+}
 
-    // Bind all of the textures to shader uniforms.
-    for (auto i = size_t{0}; i < mesh.textures.size(); ++i) {
-      this->set_texture_unit(GL_TEXTURE0 + i);
+auto Renderer::get_model_rig(ModelId id) -> std::shared_ptr<const Rig> {
+  const auto lock = std::lock_guard{this->resolve_mutex};
+  const auto rig  = this->model_rigs.find(this->model_resources.get(id).file_path);
 
-      auto name = material_strings.at(mesh.textures[i].type);
+  return rig != this->model_rigs.end() ? rig->second : nullptr;
+}
+
+auto Renderer::mark_occluder(const path &file_path) -> void {
+  const auto lock = std::lock_guard{this->resolve_mutex};
+  this->occluder_paths.insert(file_path);
+}
 
-      const auto index = static_cast<size_t>(mesh.textures[i].type);
+auto Renderer::cull_occluded(const mat4 &view_projection, const MeshDraw *draws,
+                             const Aabb *aabbs, size_t count, std::uint8_t *visible) -> size_t {
+  afk_profile_zone("Renderer::cull_occluded");
+  auto has_occluders = false;
 
-      afk_assert_debug(!material_bound[index], "Material "s + name + " already bound"s);
-      material_bound[index] = true;
+  for (auto i = size_t{0}; i < count && !has_occluders; ++i) {
+    has_occluders = visible[i] != 0 && draws[i].mesh->occluder != nullptr;
+  }
+
+  if (!has_occluders) {
+    return 0;
+  }
 
-      this->set_uniform(shader_program, "u_textures."s + name, static_cast<int>(i));
-      this->bind_texture(mesh.textures[i]);
+  this->occlusion_buffer.clear();
+
+  for (auto i = size_t{0}; i < count; ++i) {
+    if (visible[i] != 0 && draws[i].mesh->occluder != nullptr) {
+      this->occlusion_buffer.rasterize(view_projection * draws[i].model_matrix,
+                                       *draws[i].mesh->occluder);
     }
+  }
 
-    auto model_matrix = mat4{1.0f};
+  // Occluders are never tested, or they would hide themselves.
+  auto num_occluded = size_t{0};
 
-    // Apply parent tranformation.
-    model_matrix = glm::translate(model_matrix, transform.translation);
-    model_matrix *= glm::mat4_cast(transform.rotation);
-    model_matrix = glm::scale(model_matrix, transform.scale);
+  for (auto i = size_t{0}; i < count; ++i) {
+    if (visible[i] == 0 || draws[i].mesh->occluder != nullptr) {
+      continue;
+    }
 
-    // Apply local transformation.
-    model_matrix = glm::translate(model_matrix, mesh.transform.translation);
-    model_matrix *= glm::mat4_cast(mesh.transform.rotation);
-    model_matrix = glm::scale(model_matrix, mesh.transform.scale);
+    if (!this->occlusion_buffer.is_visible(view_projection, aabbs[i])) {
+      visible[i] = 0;
+      ++num_occluded;
+    }
+  }
 
-    this->set_uniform(shader_program, "u_matrices.model", model_matrix);
+  return num_occluded;
+}
 
-    // Draw the mesh.
-    glBindVertexArray(mesh.vao);
-    glDrawElements(GL_TRIANGLES, mesh.num_indices, MeshHandle::INDEX, nullptr);
-    glBindVertexArray(0);
+/**
+ * Pick the coarsest level of detail a screen size allows. A mesh has to pass
+ * a threshold by a margin to change level, so one near it doesn't flicker.
+ */
+static auto select_lod(float screen_size, size_t num_lods, size_t previous) -> size_t {
+  auto lod = size_t{0};
+
+  while (lod + 1 < num_lods) {
+    const auto threshold = Renderer::LOD_SCREEN_SIZES[lod];
+    const auto margin    = previous > lod ? 1.0f + Renderer::LOD_HYSTERESIS
+                                          : 1.0f - Renderer::LOD_HYSTERESIS;
+
+    if (screen_size >= threshold * margin) {
+      break;
+    }
+
+    ++lod;
+  }
+
+  return lod;
+}
+
+auto Renderer::select_lods(const FramePacket &packet, MeshDraw *draws, size_t count,
+                           std::uint8_t *visible) -> size_t {
+  afk_profile_zone("Renderer::select_lods");
+  auto num_dropped = size_t{0};
+
+  this->next_lod_levels.clear();
+
+  for (auto i = size_t{0}; i < count; ++i) {
+    if (visible[i] == 0) {
+      continue;
+    }
+
+    auto &draw          = draws[i];
+    const auto &mesh    = *draw.mesh;
+    const auto sphere   = Afk::transform_sphere(mesh.bounding_sphere, draw.model_matrix);
+    const auto distance = glm::length(vec3{packet.view * vec4{sphere.center, 1.0f}});
+    // Fraction of the screen's height the bounding sphere covers.
+    const auto screen_size = distance > sphere.radius
+                                 ? sphere.radius * packet.projection[1][1] / distance
+                                 : std::numeric_limits<float>::max();
+
+    if (screen_size < Renderer::MIN_SCREEN_SIZE) {
+      visible[i] = 0;
+      ++num_dropped;
+      continue;
+    }
+
+    const auto &game_object = packet.commands[draw.command].game_object;
+
+    if (!game_object.has_value()) {
+      draw.lod = static_cast<std::uint8_t>(select_lod(screen_size, mesh.lods.size(), 0));
+      continue;
+    }
+
+    const auto key =
+        (std::uint64_t{static_cast<ENTT_ID_TYPE>(*game_object)} << 32) | std::uint64_t{mesh.id};
+    const auto previous = this->lod_levels.find(key);
+
+    draw.lod = static_cast<std::uint8_t>(
+        select_lod(screen_size, mesh.lods.size(),
+                   previous != this->lod_levels.end() ? previous->second : size_t{0}));
+    this->next_lod_levels[key] = draw.lod;
+  }
+
+  // Entities not drawn this frame start over at the full mesh.
+  std::swap(this->lod_levels, this->next_lod_levels);
 
+  return num_dropped;
+}
+
+auto Renderer::draw_terrain() -> void {
+  const auto &packet = this->frame_packets[this->front_packet];
+
+  if (!packet.terrain.has_value() || !this->terrain.has_value()) {
+    return;
+  }
+
+  afk_profile_zone("Renderer::draw_terrain");
+  const auto &command  = *packet.terrain;
+  const auto &terrain  = *this->terrain;
+  const auto *program  = this->find_shader_program(command.shader_program).handle;
+  const auto per_index = terrain.quadrant_indices;
+
+  this->draw_stats.terrain_patches = command.patches.size();
+  ++this->draw_stats.program_binds;
+  ++this->draw_stats.texture_binds;
+  ++this->draw_stats.vao_binds;
+
+  if (!this->is_headless) {
+    // Patches morph by their distance to the camera in the terrain's space.
+    const auto camera = vec3{glm::inverse(command.model_matrix) * glm::inverse(packet.view)[3]};
+
+    this->use_shader(*program);
+    this->set_uniform(*program, Uniform::Model, command.model_matrix);
+    this->set_uniform(*program, Uniform::TerrainSize, vec2{terrain.size});
+    this->set_uniform(*program, Uniform::TerrainCamera, camera);
     this->set_texture_unit(GL_TEXTURE0);
+    this->set_uniform(*program, Uniform::TerrainHeights, 0);
+    glBindTexture(GL_TEXTURE_2D, terrain.heights);
+    glBindVertexArray(terrain.vao);
+  }
+
+  for (const auto &patch : command.patches) {
+    if (!this->is_headless) {
+      this->set_uniform(*program, Uniform::TerrainOffset, patch.offset);
+      this->set_uniform(*program, Uniform::TerrainScale,
+                        patch.size / static_cast<float>(terrain.patch_size));
+      this->set_uniform(*program, Uniform::TerrainMorph, patch.morph);
+    }
+
+    // The quadrants are in order in the index buffer, so each run of them is
+    // one draw.
+    for (auto quadrant = size_t{0}; quadrant < 4;) {
+      if ((patch.quadrants & (1u << quadrant)) == 0) {
+        ++quadrant;
+        continue;
+      }
+
+      auto last = quadrant + 1;
+
+      while (last < 4 && (patch.quadrants & (1u << last)) != 0) {
+        ++last;
+      }
+
+      const auto first_index = quadrant * per_index;
+      const auto num_indices = (last - quadrant) * per_index;
+
+      ++this->draw_stats.draw_calls;
+      this->draw_stats.triangles += num_indices / 3;
+
+      if (!this->is_headless) {
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(num_indices), MeshHandle::SHORT_INDEX,
+                       reinterpret_cast<void *>(first_index * sizeof(std::uint16_t)));
+      }
+
+      quadrant = last;
+    }
+  }
+}
+
+auto Renderer::find_model(ModelId id) -> const ModelHandle & {
+  auto &resource = this->model_resources.get(id);
+
+  if (resource.handle == nullptr) {
+    resource.handle = &this->get_model(resource.file_path);
+  }
+
+  return *resource.handle;
+}
+
+auto Renderer::find_shader_program(ShaderProgramId id) -> const ShaderProgramResource & {
+  auto &resource = this->shader_program_resources.get(id);
+
+  if (resource.handle == nullptr) {
+    const auto &file_path = resource.file_path;
+    const auto instanced_path =
+        file_path.parent_path() /
+        (file_path.stem().string() + "_instanced" + file_path.extension().string());
+
+    resource.handle = &this->get_shader_program(file_path);
+
+    if (std::filesystem::exists(Afk::get_absolute_path(instanced_path))) {
+      resource.instanced = &this->get_shader_program(instanced_path);
+    }
+  }
+
+  return resource;
+}
+
+auto Renderer::bind_material(const ShaderProgramHandle &shader_program,
+                             const MeshHandle &mesh) const -> void {
+  auto material_bound = std::bitset<static_cast<size_t>(Texture::Type::Count)>{};
+
+  // Bind all of the textures to shader uniforms.
+  for (auto i = size_t{0}; i < mesh.textures.size(); ++i) {
+    this->set_texture_unit(GL_TEXTURE0 + i);
+
+    [[maybe_unused]] const auto *name = material_strings.at(mesh.textures[i].type);
+
+    const auto index = static_cast<size_t>(mesh.textures[i].type);
+
+    afk_assert_debug(!material_bound[index], "Material "s + name + " already bound"s);
+    material_bound[index] = true;
+
+    this->set_uniform(shader_program, texture_uniforms.at(mesh.textures[i].type),
+                      static_cast<int>(i));
+    this->bind_texture(mesh.textures[i]);
+  }
+}
+
+auto Renderer::get_model_matrix(const Transform &transform, const Transform &local) -> mat4 {
+  // Apply the local transformation, then the parent's.
+  return transform.get_matrix() * local.get_matrix();
+}
+
+auto Renderer::draw_multi(const ShaderProgramHandle &shader_program, MultiDraw &multi_draw)
+    -> void {
+  if (multi_draw.counts.empty()) {
+    return;
+  }
+
+  ++this->draw_stats.draw_calls;
+
+  if (!this->is_headless) {
+    this->set_uniform(shader_program, Uniform::Model, multi_draw.model_matrix);
+    this->set_uniform(shader_program, Uniform::SkinOffset, multi_draw.first_bone);
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, multi_draw.counts.data(), multi_draw.index_type,
+                                  multi_draw.offsets.data(),
+                                  static_cast<GLsizei>(multi_draw.counts.size()),
+                                  multi_draw.base_vertices.data());
+  }
+
+  multi_draw.counts.clear();
+  multi_draw.offsets.clear();
+  multi_draw.base_vertices.clear();
+}
+
+auto Renderer::draw_mesh_instanced(const MeshHandle &mesh, const MeshHandle::Lod &lod,
+                                   size_t first_instance, size_t instance_count) const -> void {
+  const auto location = static_cast<GLuint>(Buffer::InstanceModel);
+
+  // GL 4.1 has no base instance, so point the matrix columns at this run.
+  glBindBuffer(GL_ARRAY_BUFFER, this->instance_vbo);
+
+  for (auto column = GLuint{0}; column < 4; ++column) {
+    const auto offset = first_instance * sizeof(mat4) + column * sizeof(vec4);
+
+    glEnableVertexAttribArray(location + column);
+    glVertexAttribPointer(location + column, 4, GL_FLOAT, GL_FALSE, sizeof(mat4),
+                          reinterpret_cast<void *>(offset));
+    glVertexAttribDivisor(location + column, 1);
+  }
+
+  const auto is_skinned    = mesh.format == VertexFormat::Skinned;
+  const auto bone_location = static_cast<GLuint>(Buffer::InstanceBones);
+
+  if (is_skinned) {
+    glBindBuffer(GL_ARRAY_BUFFER, this->instance_bone_vbo);
+    glEnableVertexAttribArray(bone_location);
+    glVertexAttribIPointer(bone_location, 1, GL_INT, sizeof(GLint),
+                           reinterpret_cast<void *>(first_instance * sizeof(GLint)));
+    glVertexAttribDivisor(bone_location, 1);
+  } else {
+    // Without the stream the shader reads the current value, which must not
+    // look like a palette offset.
+    glVertexAttribI1i(bone_location, -1);
+  }
+
+  glDrawElementsInstancedBaseVertex(
+      GL_TRIANGLES, static_cast<GLsizei>(lod.num_indices), mesh.index_type,
+      reinterpret_cast<void *>(lod.offset),
+      static_cast<GLsizei>(instance_count), mesh.base_vertex);
+
+  // Leave the VAO as non-instanced draws expect it.
+  for (auto column = GLuint{0}; column < 4; ++column) {
+    glDisableVertexAttribArray(location + column);
+  }
+
+  if (is_skinned) {
+    glDisableVertexAttribArray(bone_location);
   }
 }
 
@@ -304,83 +1052,207 @@ auto Renderer::load_mesh(const Mesh &mesh) -> MeshHandle {
                  std::to_string(mesh.indices.size()) + " requested, max "s +
                  std::to_string(std::numeric_limits<Afk::Index>::max()));
 
-  auto mesh_handle        = MeshHandle{};
-  mesh_handle.num_indices = mesh.indices.size();
-  mesh_handle.transform   = std::move(mesh.transform);
+  auto mesh_handle            = MeshHandle{};
+  mesh_handle.num_indices     = mesh.indices.size();
+  mesh_handle.transform       = std::move(mesh.transform);
+  mesh_handle.id              = this->mesh_count++;
+  mesh_handle.aabb            = mesh.aabb;
+  mesh_handle.bounding_sphere = mesh.bounding_sphere;
 
-  // Create new buffers.
-  glGenVertexArrays(1, &mesh_handle.vao);
-  glGenBuffers(1, &mesh_handle.vbo);
-  glGenBuffers(1, &mesh_handle.ibo);
+  // Indices are 16 bit whenever they can reach every vertex.
+  const auto is_short =
+      mesh.vertices.size() <= size_t{std::numeric_limits<std::uint16_t>::max()} + 1;
+  const auto index_size = is_short ? sizeof(std::uint16_t) : sizeof(Afk::Index);
 
-  afk_assert(mesh_handle.vao > 0, "Mesh VAO creation failed");
-  afk_assert(mesh_handle.vbo > 0, "Mesh VBO creation failed");
-  afk_assert(mesh_handle.ibo > 0, "Mesh IBO creation failed");
+  mesh_handle.format     = Afk::get_vertex_format(mesh);
+  mesh_handle.index_type = is_short ? MeshHandle::SHORT_INDEX : MeshHandle::INDEX;
 
-  // Load data into the vertex buffer.
-  glBindVertexArray(mesh_handle.vao);
-  glBindBuffer(GL_ARRAY_BUFFER, mesh_handle.vbo);
-  glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(Vertex),
-               mesh.vertices.data(), GL_STATIC_DRAW);
+  // The full mesh then each level of detail, back to back.
+  auto indices = mesh.indices;
+  mesh_handle.lods.push_back({0, mesh.indices.size()});
 
-  // Load index data into the index buffer.
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh_handle.ibo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(Afk::Index),
-               mesh.indices.data(), GL_STATIC_DRAW);
+  for (const auto &lod : mesh.lods) {
+    mesh_handle.lods.push_back({indices.size() * index_size, lod.size()});
+    indices.insert(indices.end(), lod.begin(), lod.end());
+  }
 
-  // Set the vertex attribute pointers.
-  glEnableVertexAttribArray(static_cast<GLuint>(Buffer::Vertex));
-  glVertexAttribPointer(static_cast<GLuint>(Buffer::Vertex), 3, GL_FLOAT,
-                        GL_FALSE, sizeof(Vertex), nullptr);
+  auto &arena      = this->mesh_arenas[static_cast<size_t>(mesh_handle.format)];
+  const auto range = arena.allocate(mesh.vertices.size(), indices.size() * index_size);
 
-  // Vertex normals
-  glEnableVertexAttribArray(static_cast<GLuint>(Buffer::Normal));
-  glVertexAttribPointer(static_cast<GLuint>(Buffer::Normal), 3, GL_FLOAT,
-                        GL_FALSE, sizeof(Vertex),
-                        reinterpret_cast<void *>(offsetof(Vertex, normal)));
+  mesh_handle.vao         = arena.get_vao();
+  mesh_handle.base_vertex = static_cast<GLint>(range.base_vertex);
 
-  // UVs
-  glEnableVertexAttribArray(static_cast<GLuint>(Buffer::Uv));
-  glVertexAttribPointer(static_cast<GLuint>(Buffer::Uv), 2, GL_FLOAT, GL_FALSE,
-                        sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, uvs)));
+  for (auto &lod : mesh_handle.lods) {
+    lod.offset += range.index_offset;
+  }
 
-  // Vertex tangent
-  glEnableVertexAttribArray(static_cast<GLuint>(Buffer::Tangent));
-  glVertexAttribPointer(static_cast<GLuint>(Buffer::Tangent), 3, GL_FLOAT,
-                        GL_FALSE, sizeof(Vertex),
-                        reinterpret_cast<void *>(offsetof(Vertex, tangent)));
-
-  // Vertex bitangent
-  glEnableVertexAttribArray(static_cast<GLuint>(Buffer::Bitangent));
-  glVertexAttribPointer(static_cast<GLuint>(Buffer::Bitangent), 3, GL_FLOAT,
-                        GL_FALSE, sizeof(Vertex),
-                        reinterpret_cast<void *>(offsetof(Vertex, bitangent)));
-
-  glEnableVertexAttribArray(static_cast<GLuint>(Buffer::BoneIndices));
-  glVertexAttribIPointer(static_cast<GLuint>(Buffer::BoneIndices), 4, GL_INT,
-                         sizeof(Vertex),
-                         reinterpret_cast<void *>(offsetof(Vertex, bone_indices)));
-
-  glEnableVertexAttribArray(static_cast<GLuint>(Buffer::BoneWeights));
-  glVertexAttribPointer(static_cast<GLuint>(Buffer::BoneWeights), 4, GL_FLOAT,
-                        GL_FALSE, sizeof(Vertex),
-                        reinterpret_cast<void *>(offsetof(Vertex, bone_weights)));
+  if (this->is_headless) {
+    return mesh_handle;
+  }
 
-  glBindVertexArray(0);
+  // Only skinned meshes pay for bone indices and weights.
+  if (mesh_handle.format == VertexFormat::Skinned) {
+    auto vertices = vector<SkinnedVertex>{};
+    vertices.reserve(mesh.vertices.size());
+
+    for (const auto &vertex : mesh.vertices) {
+      vertices.push_back(Afk::pack_skinned_vertex(vertex));
+    }
+
+    arena.upload_vertices(range.base_vertex, vertices.data(), vertices.size());
+  } else {
+    auto vertices = vector<StaticVertex>{};
+    vertices.reserve(mesh.vertices.size());
+
+    for (const auto &vertex : mesh.vertices) {
+      vertices.push_back(Afk::pack_static_vertex(vertex));
+    }
+
+    arena.upload_vertices(range.base_vertex, vertices.data(), vertices.size());
+  }
+
+  if (is_short) {
+    const auto short_indices = vector<std::uint16_t>(indices.begin(), indices.end());
+    arena.upload_indices(range.index_offset, short_indices.data(),
+                         short_indices.size() * index_size);
+  } else {
+    arena.upload_indices(range.index_offset, indices.data(), indices.size() * index_size);
+  }
 
   return mesh_handle;
 }
 
+auto Renderer::load_terrain(const HeightMap &height_map, int patch_size) -> void {
+  afk_assert(patch_size >= 2 && patch_size % 2 == 0, "Terrain patch size must be even");
+  afk_assert(patch_size < std::numeric_limits<std::uint8_t>::max(),
+             "Terrain patch size too large for 16 bit indices");
+  afk_assert(height_map.width >= 2, "Height map too small");
+  afk_assert(height_map.heights.size() % static_cast<size_t>(height_map.width) == 0,
+             "Height map isn't rectangular");
+
+  const auto length   = static_cast<int>(height_map.heights.size()) / height_map.width;
+  const auto quadrant = patch_size / 2;
+
+  auto terrain_handle             = TerrainHandle{};
+  terrain_handle.size             = {height_map.width, length};
+  terrain_handle.patch_size       = patch_size;
+  terrain_handle.quadrant_indices = static_cast<size_t>(quadrant * quadrant * 6);
+
+  if (this->is_headless) {
+    this->terrain = terrain_handle;
+    return;
+  }
+
+  if (this->terrain.has_value()) {
+    glDeleteVertexArrays(1, &this->terrain->vao);
+    glDeleteBuffers(1, &this->terrain->vbo);
+    glDeleteBuffers(1, &this->terrain->ibo);
+    glDeleteTextures(1, &this->terrain->heights);
+  }
+
+  // One grid of whole numbered vertices is shared by every patch.
+  const auto row = patch_size + 1;
+  auto grid      = vector<glm::u16vec2>{};
+  auto indices   = vector<std::uint16_t>{};
+  grid.reserve(static_cast<size_t>(row * row));
+  indices.reserve(terrain_handle.quadrant_indices * 4);
+
+  for (auto y = 0; y < row; ++y) {
+    for (auto x = 0; x < row; ++x) {
+      grid.emplace_back(static_cast<std::uint16_t>(x), static_cast<std::uint16_t>(y));
+    }
+  }
+
+  // Indices are grouped by quadrant, so patches can draw any of them.
+  for (auto i = 0; i < 4; ++i) {
+    const auto x0 = (i & 1) * quadrant;
+    const auto y0 = (i >> 1) * quadrant;
+
+    for (auto y = y0; y < y0 + quadrant; ++y) {
+      for (auto x = x0; x < x0 + quadrant; ++x) {
+        const auto start = y * row + x;
+
+        indices.push_back(static_cast<std::uint16_t>(start));
+        indices.push_back(static_cast<std::uint16_t>(start + row));
+        indices.push_back(static_cast<std::uint16_t>(start + 1));
+
+        indices.push_back(static_cast<std::uint16_t>(start + 1));
+        indices.push_back(static_cast<std::uint16_t>(start + row));
+        indices.push_back(static_cast<std::uint16_t>(start + 1 + row));
+      }
+    }
+  }
+
+  glGenVertexArrays(1, &terrain_handle.vao);
+  glGenBuffers(1, &terrain_handle.vbo);
+  glGenBuffers(1, &terrain_handle.ibo);
+  glGenTextures(1, &terrain_handle.heights);
+
+  afk_assert(terrain_handle.vao > 0, "Terrain VAO creation failed");
+  afk_assert(terrain_handle.vbo > 0, "Terrain VBO creation failed");
+  afk_assert(terrain_handle.ibo > 0, "Terrain IBO creation failed");
+  afk_assert(terrain_handle.heights > 0, "Terrain height texture creation failed");
+
+  glBindVertexArray(terrain_handle.vao);
+  glBindBuffer(GL_ARRAY_BUFFER, terrain_handle.vbo);
+  glBufferData(GL_ARRAY_BUFFER, grid.size() * sizeof(glm::u16vec2), grid.data(),
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, terrain_handle.ibo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(std::uint16_t), indices.data(),
+               GL_STATIC_DRAW);
+
+  const auto location = static_cast<GLuint>(TerrainHandle::Buffer::Grid);
+  glEnableVertexAttribArray(location);
+  glVertexAttribPointer(location, 2, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(glm::u16vec2), nullptr);
+  glBindVertexArray(0);
+
+  // Heights are sampled in the vertex shader, so the map never becomes a mesh.
+  glBindTexture(GL_TEXTURE_2D, terrain_handle.heights);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, height_map.width, length, 0, GL_RED, GL_FLOAT,
+               height_map.heights.data());
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  Io::log << "Loaded " << height_map.width << "x" << length << " terrain.\n";
+  this->terrain = terrain_handle;
+}
+
 auto Renderer::load_model(const Model &model) -> ModelHandle {
   const auto is_loaded = this->models.count(model.file_path) == 1;
 
   afk_assert(!is_loaded, "Model with path '"s + model.file_path.string() + "' already loaded"s);
 
   auto modelHandle = ModelHandle{};
+  auto is_occluder = false;
+
+  {
+    const auto lock = std::lock_guard{this->resolve_mutex};
+    is_occluder     = this->occluder_paths.count(model.file_path) == 1;
+  }
+
+  // Skinning matrices are laid out mesh by mesh, as the model's rig lays out its bones.
+  auto num_bones = std::uint32_t{0};
 
   // Load meshes and textures.
   for (const auto &mesh : model.meshes) {
-    auto mesh_handle = this->load_mesh(mesh);
+    auto mesh_handle       = this->load_mesh(mesh);
+    mesh_handle.first_bone = num_bones;
+    num_bones += static_cast<std::uint32_t>(mesh.bones.size());
+
+    if (is_occluder) {
+      auto occluder = OccluderMesh{};
+      occluder.positions.reserve(mesh.vertices.size());
+
+      for (const auto &vertex : mesh.vertices) {
+        occluder.positions.push_back(vertex.position);
+      }
+
+      occluder.indices     = mesh.indices;
+      mesh_handle.occluder = std::make_shared<const OccluderMesh>(std::move(occluder));
+    }
 
     for (const auto &texture : mesh.textures) {
       const auto &texture_handle = this->get_texture(texture.file_path);
@@ -394,9 +1266,25 @@ auto Renderer::load_model(const Model &model) -> ModelHandle {
       mesh_handle.textures.push_back(std::move(texture_handle));
     }
 
+    mesh_handle.material = this->get_material_id(mesh_handle);
+
+    const auto mesh_aabb = Afk::transform_aabb(mesh_handle.aabb, mesh.transform.get_matrix());
+    modelHandle.aabb     = modelHandle.meshes.empty()
+                               ? mesh_aabb
+                               : Afk::merge_aabbs(modelHandle.aabb, mesh_aabb);
+
     modelHandle.meshes.push_back(std::move(mesh_handle));
   }
 
+  {
+    const auto lock                     = std::lock_guard{this->resolve_mutex};
+    this->model_bounds[model.file_path] = modelHandle.aabb;
+
+    if (model.rig != nullptr) {
+      this->model_rigs[model.file_path] = model.rig;
+    }
+  }
+
   this->models[model.file_path] = std::move(modelHandle);
   afk_assert(this->animations.find(model.file_path) == this->animations.end(),
              "Found existing animations");
@@ -407,6 +1295,19 @@ auto Renderer::load_model(const Model &model) -> ModelHandle {
   return this->models[model.file_path];
 }
 
+auto Renderer::get_material_id(const MeshHandle &mesh) -> std::uint32_t {
+  auto texture_ids = vector<GLuint>{};
+  texture_ids.reserve(mesh.textures.size());
+
+  for (const auto &texture : mesh.textures) {
+    texture_ids.push_back(texture.id);
+  }
+
+  const auto next_id = static_cast<std::uint32_t>(this->material_ids.size());
+
+  return this->material_ids.try_emplace(std::move(texture_ids), next_id).first->second;
+}
+
 auto Renderer::load_texture(const Texture &texture) -> TextureHandle {
   const auto is_loaded = this->textures.count(texture.file_path) == 1;
   const auto abs_path  = Afk::get_absolute_path(texture.file_path);
@@ -415,29 +1316,56 @@ auto Renderer::load_texture(const Texture &texture) -> TextureHandle {
   afk_assert(std::filesystem::exists(abs_path),
              "Texture "s + texture.file_path.string() + " doesn't exist"s);
 
-  auto width    = 0;
-  auto height   = 0;
-  auto channels = 0;
-  auto image    = shared_ptr<unsigned char>{
-      stbi_load(abs_path.string().c_str(), &width, &height, &channels, STBI_rgb_alpha),
-      stbi_image_free};
+  if (this->is_headless) {
+    auto texture_handle               = TextureHandle{};
+    texture_handle.type               = texture.type;
+    this->textures[texture.file_path] = std::move(texture_handle);
+
+    return this->textures[texture.file_path];
+  }
 
-  afk_assert(image != nullptr,
-             "Failed to load image: '"s + texture.file_path.string() + "'"s);
+  auto cooked    = CookedTexture{};
+  auto is_cooked = false;
 
-  auto texture_handle     = TextureHandle{};
-  texture_handle.type     = texture.type;
-  texture_handle.width    = width;
-  texture_handle.height   = height;
-  texture_handle.channels = channels;
+  {
+    // Use the texture an import job already cooked, if there is one.
+    const auto lock = std::lock_guard{this->import_mutex};
+    auto node       = this->cooked_textures.extract(texture.file_path);
 
-  // Send the texture to the GPU.
+    if (!node.empty()) {
+      cooked    = std::move(node.mapped());
+      is_cooked = true;
+    }
+  }
+
+  if (!is_cooked) {
+    cooked = TextureCache::load(texture.file_path, texture.type, this->texture_formats);
+  }
+
+  auto texture_handle   = TextureHandle{};
+  texture_handle.type   = texture.type;
+  texture_handle.width  = cooked.get_width();
+  texture_handle.height = cooked.get_height();
+
+  // Send the texture to the GPU, every mip as it was cooked.
   glGenTextures(1, &texture_handle.id);
   afk_assert(texture_handle.id > 0, "Texture creation failed");
   glBindTexture(GL_TEXTURE_2D, texture_handle.id);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
-               GL_UNSIGNED_BYTE, image.get());
-  glGenerateMipmap(GL_TEXTURE_2D);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(cooked.mips.size()) - 1);
+
+  for (auto level = size_t{0}; level < cooked.mips.size(); ++level) {
+    const auto &mip   = cooked.mips[level];
+    const auto *data  = cooked.data.data() + mip.offset;
+    const auto gl_mip = static_cast<GLint>(level);
+
+    if (cooked.format == TextureFormat::Rgba8) {
+      glTexImage2D(GL_TEXTURE_2D, gl_mip, GL_RGBA, mip.width, mip.height, 0, GL_RGBA,
+                   GL_UNSIGNED_BYTE, data);
+    } else {
+      glCompressedTexImage2D(GL_TEXTURE_2D, gl_mip, gl_texture_formats.at(cooked.format),
+                             mip.width, mip.height, 0, static_cast<GLsizei>(mip.size), data);
+    }
+  }
 
   // Set texture parameters.
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -452,6 +1380,91 @@ auto Renderer::load_texture(const Texture &texture) -> TextureHandle {
   return this->textures[texture.file_path];
 }
 
+auto Renderer::import_model(const path &file_path, Thread::JobCounter &counter) -> void {
+  if (this->models.count(file_path) == 1 || !this->importing_models.insert(file_path).second) {
+    return;
+  }
+
+  Afk::Engine::get().job_system.run(
+      [this, file_path] {
+        afk_profile_zone("Renderer::import_model");
+        auto model = Model{file_path};
+        this->decode_textures(model);
+
+        const auto lock = std::lock_guard{this->import_mutex};
+        this->imported_models.push_back(std::move(model));
+      },
+      &counter);
+}
+
+auto Renderer::decode_textures(const Model &model) -> void {
+  // Headless rendering never reads the pixels.
+  if (this->is_headless) {
+    return;
+  }
+
+  for (const auto &mesh : model.meshes) {
+    for (const auto &texture : mesh.textures) {
+      {
+        // Models often share textures, only cook each once.
+        const auto lock = std::lock_guard{this->import_mutex};
+
+        if (!this->cooking_textures.insert(texture.file_path).second) {
+          continue;
+        }
+      }
+
+      auto cooked = TextureCache::load(texture.file_path, texture.type, this->texture_formats);
+
+      const auto lock = std::lock_guard{this->import_mutex};
+      this->cooked_textures.emplace(texture.file_path, std::move(cooked));
+    }
+  }
+}
+
+auto Renderer::request_model(const path &file_path) -> void {
+  const auto lock = std::lock_guard{this->import_mutex};
+  this->requested_models.push_back(file_path);
+}
+
+auto Renderer::upload_imported_models() -> void {
+  afk_profile_zone("Renderer::upload_imported_models");
+  auto imported  = vector<Model>{};
+  auto requested = vector<path>{};
+
+  {
+    const auto lock = std::lock_guard{this->import_mutex};
+    imported.swap(this->imported_models);
+    requested.swap(this->requested_models);
+  }
+
+  for (const auto &file_path : requested) {
+    this->import_model(file_path, this->requested_imports);
+  }
+
+  for (const auto &model : imported) {
+    this->importing_models.erase(model.file_path);
+
+    if (this->models.count(model.file_path) == 0) {
+      this->load_model(model);
+    }
+  }
+
+  // Drop textures that were already loaded once nothing is importing, so
+  // anything loaded from now on is read from the cache on demand again.
+  if (!this->importing_models.empty()) {
+    return;
+  }
+
+  const auto lock = std::lock_guard{this->import_mutex};
+  this->cooked_textures.clear();
+  this->cooking_textures.clear();
+}
+
+auto Renderer::wait_for_imports() -> void {
+  Afk::Engine::get().job_system.wait(this->requested_imports);
+}
+
 auto Renderer::compile_shader(const Shader &shader) -> ShaderHandle {
   const auto is_loaded = this->shaders.count(shader.file_path) == 1;
 
@@ -459,6 +1472,13 @@ auto Renderer::compile_shader(const Shader &shader) -> ShaderHandle {
 
   auto shader_handle = ShaderHandle{};
 
+  if (this->is_headless) {
+    shader_handle.type              = shader.type;
+    this->shaders[shader.file_path] = std::move(shader_handle);
+
+    return this->shaders[shader.file_path];
+  }
+
   const auto *shader_code_ptr = shader.code.c_str();
   shader_handle.id            = glCreateShader(gl_shader_types.at(shader.type));
   shader_handle.type          = shader.type;
@@ -498,6 +1518,13 @@ auto Renderer::link_shaders(const ShaderProgram &shader_program) -> ShaderProgra
 
   auto shader_program_handle = ShaderProgramHandle{};
 
+  if (this->is_headless) {
+    shader_program_handle.locations.fill(-1);
+    this->shader_programs[shader_program.file_path] = std::move(shader_program_handle);
+
+    return this->shader_programs[shader_program.file_path];
+  }
+
   shader_program_handle.id = glCreateProgram();
   afk_assert(shader_program_handle.id > 0, "Shader program creation failed");
 
@@ -524,6 +1551,8 @@ auto Renderer::link_shaders(const ShaderProgram &shader_program) -> ShaderProgra
                           "' linking failed: "s + error_msg.data());
   }
 
+  Renderer::reflect_uniforms(shader_program_handle);
+
   Io::log << "Shader program '" << shader_program.file_path.string()
           << "' linked with ID " << shader_program_handle.id << ".\n";
   this->shader_programs[shader_program.file_path] = std::move(shader_program_handle);
@@ -531,43 +1560,88 @@ auto Renderer::link_shaders(const ShaderProgram &shader_program) -> ShaderProgra
   return this->shader_programs[shader_program.file_path];
 }
 
-auto Renderer::set_uniform(const ShaderProgramHandle &program,
-                           const string &name, bool value) const -> void {
-  afk_assert_debug(program.id > 0, "Invalid shader program ID");
-  glUniform1i(glGetUniformLocation(program.id, name.c_str()),
-              static_cast<GLboolean>(value));
+auto Renderer::reflect_uniforms(ShaderProgramHandle &program) -> void {
+  auto count      = GLint{0};
+  auto max_length = GLint{0};
+  glGetProgramiv(program.id, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(program.id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+  auto name = vector<GLchar>(static_cast<size_t>(std::max(max_length, 1)));
+
+  for (auto i = GLint{0}; i < count; ++i) {
+    auto length = GLsizei{0};
+    auto size   = GLint{0};
+    auto type   = GLenum{0};
+    glGetActiveUniform(program.id, static_cast<GLuint>(i), max_length, &length, &size, &type,
+                       name.data());
+
+    // Uniforms in blocks have no location, they're set through buffers.
+    const auto location = glGetUniformLocation(program.id, name.data());
+
+    if (location >= 0) {
+      auto uniform = string{name.data(), static_cast<size_t>(length)};
+
+      // Arrays are reported by their first element, but set by their name.
+      if (size > 1 && uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0) {
+        uniform.resize(uniform.size() - 3);
+      }
+
+      program.uniforms.emplace(std::move(uniform), location);
+    }
+  }
+
+  for (auto i = size_t{0}; i < uniform_names.size(); ++i) {
+    program.locations[i] = Renderer::find_uniform(program, uniform_names[i]);
+  }
+
+  // Skinning matrices are always on the same unit, so the sampler is set once.
+  const auto bones = program.locations[static_cast<size_t>(Uniform::SkinBones)];
+
+  if (bones >= 0) {
+    glProgramUniform1i(program.id, bones, static_cast<GLint>(Renderer::BONES_TEXTURE_UNIT));
+  }
+
+  // GL 4.1 can't bind blocks in GLSL, so bind them by name here.
+  const auto camera_block = glGetUniformBlockIndex(program.id, "Camera");
+
+  if (camera_block != GL_INVALID_INDEX) {
+    glUniformBlockBinding(program.id, camera_block, Renderer::CAMERA_BINDING);
+  }
+}
+
+auto Renderer::find_uniform(const ShaderProgramHandle &program, const char *name) -> GLint {
+  const auto uniform = program.uniforms.find(name);
+
+  return uniform != program.uniforms.end() ? uniform->second : -1;
+}
+
+auto Renderer::upload_uniform(GLint location, bool value) -> void {
+  glUniform1i(location, static_cast<GLint>(value));
+}
+
+auto Renderer::upload_uniform(GLint location, int value) -> void {
+  glUniform1i(location, static_cast<GLint>(value));
 }
 
-auto Renderer::set_uniform(const ShaderProgramHandle &program,
-                           const string &name, int value) const -> void {
-  afk_assert_debug(program.id > 0, "Invalid shader program ID");
-  glUniform1i(glGetUniformLocation(program.id, name.c_str()), static_cast<GLint>(value));
+auto Renderer::upload_uniform(GLint location, float value) -> void {
+  glUniform1f(location, static_cast<GLfloat>(value));
 }
 
-auto Renderer::set_uniform(const ShaderProgramHandle &program,
-                           const string &name, float value) const -> void {
-  afk_assert_debug(program.id > 0, "Invalid shader program ID");
-  glUniform1f(glGetUniformLocation(program.id, name.c_str()), static_cast<GLfloat>(value));
+auto Renderer::upload_uniform(GLint location, const vec2 &value) -> void {
+  glUniform2fv(location, 1, glm::value_ptr(value));
 }
 
-auto Renderer::set_uniform(const ShaderProgramHandle &program,
-                           const string &name, vec3 value) const -> void {
-  afk_assert_debug(program.id > 0, "Invalid shader program ID");
-  glUniform3fv(glGetUniformLocation(program.id, name.c_str()), 1, glm::value_ptr(value));
+auto Renderer::upload_uniform(GLint location, const vec3 &value) -> void {
+  glUniform3fv(location, 1, glm::value_ptr(value));
 }
 
-auto Renderer::set_uniform(const ShaderProgramHandle &program,
-                           const string &name, mat4 value) const -> void {
-  afk_assert_debug(program.id > 0, "Invalid shader program ID");
-  glUniformMatrix4fv(glGetUniformLocation(program.id, name.c_str()), 1,
-                     GL_FALSE, glm::value_ptr(value));
+auto Renderer::upload_uniform(GLint location, const mat4 &value) -> void {
+  glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
 }
 
-auto Renderer::set_uniform(const ShaderProgramHandle &program, const string &name,
-                           const vector<mat4> &value) const -> void {
-  afk_assert_debug(program.id > 0, "Invalid shader program ID");
-  glUniformMatrix4fv(glGetUniformLocation(program.id, name.c_str()),
-                     value.size(), GL_FALSE, glm::value_ptr(value[0]));
+auto Renderer::upload_uniform(GLint location, const vector<mat4> &value) -> void {
+  glUniformMatrix4fv(location, static_cast<GLsizei>(value.size()), GL_FALSE,
+                     glm::value_ptr(value[0]));
 }
 
 auto Renderer::set_wireframe(bool status) -> void {
@@ -1,29 +1,47 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
-#include <queue>
 #include <string>
 #include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <glad/glad.h>
-#include <glm/fwd.hpp>
+#include <glm/glm.hpp>
 // Must be included after GLAD.
 #include <GLFW/glfw3.h>
 
 #include "afk/component/GameObject.hpp"
+#include "afk/debug/Assert.hpp"
+#include "afk/memory/FrameArena.hpp"
+#include "afk/physics/shape/HeightMap.hpp"
 #include "afk/renderer/Animation.hpp"
+#include "afk/renderer/Bounds.hpp"
 #include "afk/renderer/Model.hpp"
+#include "afk/renderer/OcclusionBuffer.hpp"
+#include "afk/renderer/ResourceRegistry.hpp"
+#include "afk/renderer/Rig.hpp"
 #include "afk/renderer/Shader.hpp"
+#include "afk/renderer/TerrainPatch.hpp"
+#include "afk/renderer/TextureCache.hpp"
+#include "afk/renderer/VertexFormat.hpp"
+#include "afk/renderer/opengl/MeshArena.hpp"
 #include "afk/renderer/opengl/MeshHandle.hpp"
 #include "afk/renderer/opengl/ModelHandle.hpp"
 #include "afk/renderer/opengl/ShaderHandle.hpp"
 #include "afk/renderer/opengl/ShaderProgramHandle.hpp"
+#include "afk/renderer/opengl/TerrainHandle.hpp"
 #include "afk/renderer/opengl/TextureHandle.hpp"
+#include "afk/thread/JobSystem.hpp"
 
 namespace Afk {
   struct Model;
@@ -39,7 +57,9 @@ namespace Afk {
       using ModelHandle         = OpenGl::ModelHandle;
       using ShaderHandle        = OpenGl::ShaderHandle;
       using ShaderProgramHandle = OpenGl::ShaderProgramHandle;
+      using TerrainHandle       = OpenGl::TerrainHandle;
       using TextureHandle       = OpenGl::TextureHandle;
+      using Uniform             = ShaderProgramHandle::Uniform;
 
       struct PathHash {
         auto operator()(const std::filesystem::path &p) const -> std::size_t {
@@ -54,11 +74,110 @@ namespace Afk {
         }
       };
 
+      /**
+       * Models and shader programs that can be drawn
+       */
+      static constexpr std::size_t MAX_MODELS          = 1024;
+      static constexpr std::size_t MAX_SHADER_PROGRAMS = 256;
+      /**
+       * Fewest draws of a mesh that are batched into one instanced draw, when
+       * its shader program has an instanced variant
+       */
+      static constexpr std::size_t MIN_INSTANCES = 2;
+      /**
+       * Screen sizes, as fractions of the screen's height, below which a
+       * mesh is drawn at each coarser level of detail
+       */
+      static constexpr std::array<float, Mesh::MAX_LODS - 1> LOD_SCREEN_SIZES = {0.3f, 0.15f,
+                                                                                 0.06f};
+      /**
+       * Fraction a mesh's screen size has to pass a threshold by to change
+       * level, so meshes near one don't flicker between levels
+       */
+      static constexpr float LOD_HYSTERESIS = 0.1f;
+      /**
+       * Screen size below which a mesh isn't drawn at all
+       */
+      static constexpr float MIN_SCREEN_SIZE = 0.005f;
+      /**
+       * Uniform buffer binding of the `Camera` block, which holds the view and
+       * projection matrices and is written once a frame
+       */
+      static constexpr GLuint CAMERA_BINDING = 0;
+      /**
+       * Texture unit every program's skinning matrices are read from, clear of
+       * the units materials use
+       */
+      static constexpr GLuint BONES_TEXTURE_UNIT = 15;
+
+      /**
+       * A model path resolved for drawing, loaded the first time it is drawn
+       */
+      struct ModelResource {
+        std::filesystem::path file_path = {};
+        const ModelHandle *handle       = nullptr;
+      };
+      /**
+       * A shader program path resolved for drawing, loaded the first time it
+       * is drawn along with its `_instanced` variant if there is one
+       */
+      struct ShaderProgramResource {
+        std::filesystem::path file_path      = {};
+        const ShaderProgramHandle *handle    = nullptr;
+        const ShaderProgramHandle *instanced = nullptr;
+      };
+
+      using ModelId         = ResourceId<ModelResource>;
+      using ShaderProgramId = ResourceId<ShaderProgramResource>;
+
+      /**
+       * A model to draw
+       */
       struct DrawCommand {
-        const std::filesystem::path model_path          = {};
-        const std::filesystem::path shader_program_path = {};
-        const Transform transform                       = {};
-        const std::optional<GameObject> game_object     = {};
+        const ModelId model                         = {};
+        const ShaderProgramId shader_program        = {};
+        const Transform transform                   = {};
+        const std::optional<GameObject> game_object = {};
+        // Where the model's skinning matrices start in the frame packet's bones.
+        const std::optional<std::uint32_t> bones    = {};
+      };
+      /**
+       * The patches of the loaded terrain to draw
+       */
+      struct TerrainCommand {
+        ShaderProgramId shader_program            = {};
+        glm::mat4 model_matrix                    = {1.0f};
+        Memory::FrameVector<TerrainPatch> patches = {};
+      };
+      /**
+       * What drawing the last frame cost
+       */
+      struct DrawStats {
+        std::size_t commands        = {};
+        std::size_t meshes          = {};
+        std::size_t program_binds   = {};
+        std::size_t texture_binds   = {};
+        std::size_t vao_binds       = {};
+        std::size_t draw_calls      = {};
+        std::size_t culled          = {};
+        std::size_t occluded        = {};
+        std::size_t dropped         = {};
+        std::size_t triangles       = {};
+        std::size_t terrain_patches = {};
+        std::size_t bones           = {};
+      };
+      /**
+       * Everything needed to draw a frame, copied out of the world so the
+       * next simulation step can run while this one is drawn
+       */
+      struct FramePacket {
+        Memory::FrameVector<DrawCommand> commands = {};
+        // Skinning matrices of every animated model, a model after another.
+        Memory::FrameVector<glm::mat4> bones      = {};
+        std::optional<TerrainCommand> terrain     = {};
+        glm::mat4 projection                      = {1.0f};
+        glm::mat4 view                            = {1.0f};
+        bool wireframe                            = false;
       };
 
       using Models =
@@ -69,7 +188,6 @@ namespace Afk {
           std::unordered_map<std::filesystem::path, ShaderHandle, PathHash, PathEquals>;
       using ShaderPrograms =
           std::unordered_map<std::filesystem::path, ShaderProgramHandle, PathHash, PathEquals>;
-      using DrawQueue = std::queue<DrawCommand>;
       using Animations =
           std::unordered_map<std::filesystem::path, Model::Animations, PathHash, PathEquals>;
 
@@ -84,7 +202,18 @@ namespace Afk {
       auto operator=(const Renderer &) -> Renderer & = delete;
       auto operator=(Renderer &&) -> Renderer & = delete;
 
-      auto initialize() -> void;
+      /**
+       * Initialize the renderer
+       * \param headless record draw commands without creating a window or
+       * issuing any GL calls
+       */
+      auto initialize(bool headless = false) -> void;
+      auto get_is_headless() const -> bool;
+      /**
+       * Get the number of draw commands submitted last frame
+       */
+      auto get_draw_count() const -> std::size_t;
+      auto get_draw_stats() const -> const DrawStats &;
       auto set_option(GLenum option, bool state) const -> void;
       auto check_errors() const -> void;
       auto get_window_size() const -> glm::ivec2;
@@ -93,12 +222,63 @@ namespace Afk {
       auto clear_screen(glm::vec4 clear_color = {255.0f, 255.0f, 255.0f, 1.0f}) const -> void;
       auto swap_buffers() -> void;
       auto set_viewport(int x, int y, int width, int height) const -> void;
+      /**
+       * Draw the front frame packet, sorting its meshes by state so GL state
+       * only changes when it has to
+       */
       auto draw() -> void;
+      /**
+       * Get the ID draw commands refer to a model by, without loading it.
+       * Safe to call from any thread.
+       */
+      auto resolve_model(const std::filesystem::path &file_path) -> ModelId;
+      /**
+       * Get the ID draw commands refer to a shader program by, without
+       * loading it. Safe to call from any thread.
+       */
+      auto resolve_shader_program(const std::filesystem::path &file_path) -> ShaderProgramId;
+      /**
+       * Get the bounds of a model in its own space, once it has loaded. Safe
+       * to call from any thread.
+       */
+      auto get_model_bounds(ModelId id) -> std::optional<Aabb>;
+      /**
+       * Get the rig poses of a model are sampled with, once it has loaded,
+       * null if it has none. Safe to call from any thread.
+       */
+      auto get_model_rig(ModelId id) -> std::shared_ptr<const Rig>;
+      /**
+       * Have a model's meshes hide what is behind them from drawing. Must be
+       * called before the model loads. Safe to call from any thread.
+       */
+      auto mark_occluder(const std::filesystem::path &file_path) -> void;
+      /**
+       * Add a draw command to the back frame packet
+       */
       auto queue_draw(DrawCommand command) -> void;
-      auto draw_model(const ModelHandle &model,
-                      const ShaderProgramHandle &shader_program, Transform transform,
-                      std::optional<GameObject> game_object) const -> void;
-      auto setup_view(const ShaderProgramHandle &shader_program) const -> void;
+      /**
+       * Draw patches of the loaded terrain in the back frame packet, replacing
+       * any queued before
+       */
+      auto queue_terrain(TerrainCommand command) -> void;
+      /**
+       * Set the camera matrices of the back frame packet
+       */
+      auto queue_camera(const glm::mat4 &projection, const glm::mat4 &view) -> void;
+      /**
+       * Make room for skinning matrices in the back frame packet, returning
+       * where they start
+       */
+      auto queue_bones(std::size_t count) -> std::uint32_t;
+      /**
+       * Get the skinning matrices of the back frame packet, to fill once
+       * every model's are queued
+       */
+      auto get_queued_bones() -> glm::mat4 *;
+      /**
+       * Make the back frame packet the one drawn, and start a new back packet
+       */
+      auto swap_frame_packets() -> void;
 
       // State management
       auto use_shader(const ShaderProgramHandle &shader) const -> void;
@@ -116,22 +296,64 @@ namespace Afk {
       auto load_model(const Model &model) -> ModelHandle;
       auto load_texture(const Texture &texture) -> TextureHandle;
       auto load_mesh(const Mesh &meshData) -> MeshHandle;
+      /**
+       * Upload a height map and the grid its patches are drawn with,
+       * replacing the terrain loaded before
+       * \param patch_size grid quads across a patch
+       */
+      auto load_terrain(const HeightMap &height_map, int patch_size) -> void;
       auto compile_shader(const Shader &shader) -> ShaderHandle;
       auto link_shaders(const ShaderProgram &shader_program) -> ShaderProgramHandle;
+      /**
+       * Import a model and decode its textures on a worker thread, leaving
+       * only the upload for upload_imported_models(). Models that are loaded
+       * or already importing are skipped.
+       * \param counter counter the import job is added to
+       */
+      auto import_model(const std::filesystem::path &file_path, Thread::JobCounter &counter)
+          -> void;
+      /**
+       * Ask for a model to be imported, without waiting for it. Safe to call
+       * from any thread; the import starts on the GL thread's next
+       * upload_imported_models(), and the model isn't drawn until it's done.
+       */
+      auto request_model(const std::filesystem::path &file_path) -> void;
+      /**
+       * Cook a model's textures, or read them from the texture cache, so
+       * loading it only has to upload them. Safe to call from any thread.
+       */
+      auto decode_textures(const Model &model) -> void;
+      /**
+       * Start importing every requested model, and upload every model
+       * import_model() has finished importing
+       */
+      auto upload_imported_models() -> void;
+      /**
+       * Wait for every requested model to finish importing
+       */
+      auto wait_for_imports() -> void;
 
       // Uniform management
-      auto set_uniform(const ShaderProgramHandle &program,
-                       const std::string &name, bool value) const -> void;
-      auto set_uniform(const ShaderProgramHandle &program,
-                       const std::string &name, int value) const -> void;
-      auto set_uniform(const ShaderProgramHandle &program,
-                       const std::string &name, float value) const -> void;
-      auto set_uniform(const ShaderProgramHandle &program,
-                       const std::string &name, glm::vec3 value) const -> void;
-      auto set_uniform(const ShaderProgramHandle &program,
-                       const std::string &name, glm::mat4 value) const -> void;
-      auto set_uniform(const ShaderProgramHandle &program, const std::string &name,
-                       const std::vector<glm::mat4> &value) const -> void;
+      /**
+       * Set a uniform the renderer knows of, at the location found when the
+       * program was linked
+       */
+      template<typename T>
+      auto set_uniform(const ShaderProgramHandle &program, Uniform uniform,
+                       const T &value) const -> void {
+        afk_assert_debug(program.id > 0, "Invalid shader program ID");
+        Renderer::upload_uniform(program.locations[static_cast<std::size_t>(uniform)], value);
+      }
+      /**
+       * Set any uniform by name, looking its location up in the program's
+       * reflected uniforms
+       */
+      template<typename T>
+      auto set_uniform(const ShaderProgramHandle &program, const char *name,
+                       const T &value) const -> void {
+        afk_assert_debug(program.id > 0, "Invalid shader program ID");
+        Renderer::upload_uniform(Renderer::find_uniform(program, name), value);
+      }
 
       auto set_wireframe(bool status) -> void;
       auto get_wireframe() const -> bool;
@@ -145,16 +367,175 @@ namespace Afk {
       const int opengl_major_version = 4;
       const int opengl_minor_version = 1;
       const bool enable_vsync        = true;
+      const glm::ivec2 headless_size = {1920, 1080};
 
       bool is_initialized    = false;
+      bool is_headless       = false;
       bool wireframe_enabled = false;
+      DrawStats draw_stats   = {};
+
+      /**
+       * A mesh of a draw command, placed in the world
+       */
+      struct MeshDraw {
+        const MeshHandle *mesh = nullptr;
+        std::uint32_t command  = {};
+        glm::mat4 model_matrix = {1.0f};
+        std::uint8_t lod       = {};
+        // First of the mesh's skinning matrices in the frame's bones, or -1.
+        GLint first_bone       = -1;
+      };
+      /**
+       * Non-instanced draws sharing a program, material and model matrix,
+       * submitted with one multi-draw call
+       */
+      struct MultiDraw {
+        glm::mat4 model_matrix                    = {1.0f};
+        GLint first_bone                          = -1;
+        GLenum index_type                         = {};
+        Memory::FrameVector<GLsizei> counts       = {};
+        Memory::FrameVector<const void *> offsets = {};
+        Memory::FrameVector<GLint> base_vertices  = {};
+      };
+
+      using LodLevels = std::unordered_map<std::uint64_t, std::uint8_t>;
+
+      // Level of detail each entity's meshes were drawn at, keyed by entity
+      // then mesh ID, to switch levels with hysteresis.
+      LodLevels lod_levels      = {};
+      LodLevels next_lod_levels = {};
+
+      std::optional<TerrainHandle> terrain = {};
+
+      /**
+       * The `Camera` uniform block, laid out as std140
+       */
+      struct CameraBlock {
+        glm::mat4 view       = {1.0f};
+        glm::mat4 projection = {1.0f};
+      };
+
+      static_assert(sizeof(CameraBlock) == 2 * 16 * sizeof(float),
+                    "Camera block must match its std140 layout");
+
+      GLuint camera_ubo = {};
+
+      // Model matrices and first bones of every mesh drawn this frame, streamed
+      // each frame.
+      GLuint instance_vbo      = {};
+      GLuint instance_bone_vbo = {};
+      std::uint32_t mesh_count = {};
+
+      // Skinning matrices of the frame, read through a buffer texture since
+      // GL 4.1 has no storage buffers.
+      GLuint bone_buffer  = {};
+      GLuint bone_texture = {};
+
+      using MeshArenas =
+          std::array<OpenGl::MeshArena, static_cast<std::size_t>(VertexFormat::Count)>;
+
+      // Every mesh's vertices and indices, so meshes of a vertex format share one VAO.
+      MeshArenas mesh_arenas = {};
 
       Models models                  = {};
       Textures textures              = {};
       Shaders shaders                = {};
       ShaderPrograms shader_programs = {};
-      DrawQueue draw_queue           = {};
       Animations animations          = {};
+
+      std::array<FramePacket, 2> frame_packets = {};
+      std::size_t front_packet                 = {};
+
+      using ModelResources         = ResourceRegistry<ModelResource, MAX_MODELS>;
+      using ShaderProgramResources = ResourceRegistry<ShaderProgramResource, MAX_SHADER_PROGRAMS>;
+      using ModelIds = std::unordered_map<std::filesystem::path, ModelId, PathHash, PathEquals>;
+      using ShaderProgramIds =
+          std::unordered_map<std::filesystem::path, ShaderProgramId, PathHash, PathEquals>;
+      using ModelBounds = std::unordered_map<std::filesystem::path, Aabb, PathHash, PathEquals>;
+      using ModelRigs   = std::unordered_map<std::filesystem::path, std::shared_ptr<const Rig>,
+                                           PathHash, PathEquals>;
+
+      // Paths are resolved to IDs once, so drawing only indexes an array.
+      ModelResources model_resources                  = {};
+      ShaderProgramResources shader_program_resources = {};
+      ModelIds model_ids                              = {};
+      ShaderProgramIds shader_program_ids             = {};
+      ModelBounds model_bounds                        = {};
+      ModelRigs model_rigs                            = {};
+      std::mutex resolve_mutex                        = {};
+
+      using PathSet = std::unordered_set<std::filesystem::path, PathHash, PathEquals>;
+
+      // Models whose meshes are rasterised into the occlusion buffer.
+      PathSet occluder_paths           = {};
+      OcclusionBuffer occlusion_buffer = {};
+
+      using CookedTextures =
+          std::unordered_map<std::filesystem::path, CookedTexture, PathHash, PathEquals>;
+
+      // Block formats the driver can upload, set once on initialisation.
+      TextureFormats texture_formats = {};
+
+      // Filled by import jobs and other threads, emptied on the GL thread.
+      std::vector<Model> imported_models                   = {};
+      std::vector<std::filesystem::path> requested_models = {};
+      CookedTextures cooked_textures                       = {};
+      PathSet cooking_textures                             = {};
+      std::mutex import_mutex                              = {};
+      // Only touched on the GL thread.
+      PathSet importing_models             = {};
+      Thread::JobCounter requested_imports = {};
+
+      // Meshes with the same textures share a material ID.
+      std::map<std::vector<GLuint>, std::uint32_t> material_ids = {};
+
+      static auto find_uniform(const ShaderProgramHandle &program, const char *name) -> GLint;
+      /**
+       * Find a linked program's uniforms and bind its uniform blocks
+       */
+      static auto reflect_uniforms(ShaderProgramHandle &program) -> void;
+      static auto upload_uniform(GLint location, bool value) -> void;
+      static auto upload_uniform(GLint location, int value) -> void;
+      static auto upload_uniform(GLint location, float value) -> void;
+      static auto upload_uniform(GLint location, const glm::vec2 &value) -> void;
+      static auto upload_uniform(GLint location, const glm::vec3 &value) -> void;
+      static auto upload_uniform(GLint location, const glm::mat4 &value) -> void;
+      static auto upload_uniform(GLint location, const std::vector<glm::mat4> &value) -> void;
+      auto get_material_id(const MeshHandle &mesh) -> std::uint32_t;
+      auto bind_material(const ShaderProgramHandle &shader_program, const MeshHandle &mesh) const
+          -> void;
+      static auto get_model_matrix(const Transform &transform, const Transform &local)
+          -> glm::mat4;
+      /**
+       * Draw and empty a batch of non-instanced draws, if it has any
+       */
+      auto draw_multi(const ShaderProgramHandle &shader_program, MultiDraw &multi_draw) -> void;
+      /**
+       * Draw instances of a mesh, their model matrices and first bones
+       * starting at an index into the instance buffers
+       */
+      auto draw_mesh_instanced(const MeshHandle &mesh, const MeshHandle::Lod &lod,
+                               std::size_t first_instance, std::size_t instance_count) const
+          -> void;
+      /**
+       * Pick the level of detail of each visible draw from its size on
+       * screen, hiding those too small to see, returning how many were hidden
+       */
+      auto select_lods(const FramePacket &packet, MeshDraw *draws, std::size_t count,
+                       std::uint8_t *visible) -> std::size_t;
+      /**
+       * Rasterise the visible occluders and hide the visible draws behind
+       * them, returning how many were hidden
+       */
+      auto cull_occluded(const glm::mat4 &view_projection, const MeshDraw *draws,
+                         const Aabb *aabbs, std::size_t count, std::uint8_t *visible)
+          -> std::size_t;
+      /**
+       * Draw the terrain patches of the front frame packet
+       */
+      auto draw_terrain() -> void;
+      auto find_model(ModelId id) -> const ModelHandle &;
+      auto find_shader_program(ShaderProgramId id) -> const ShaderProgramResource &;
     };
   }
 }
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
 #include <glad/glad.h>
 
 namespace Afk {
@@ -8,7 +13,34 @@ namespace Afk {
      * Shader program handle - represents a loaded shader
      */
     struct ShaderProgramHandle {
+      /**
+       * Uniforms the renderer sets while drawing
+       */
+      enum class Uniform : std::size_t {
+        Model = 0,
+        Diffuse,
+        Specular,
+        Normal,
+        Height,
+        TerrainHeights,
+        TerrainSize,
+        TerrainCamera,
+        TerrainOffset,
+        TerrainScale,
+        TerrainMorph,
+        SkinBones,
+        SkinOffset,
+        Count
+      };
+
+      using Uniforms  = std::unordered_map<std::string, GLint>;
+      using Locations = std::array<GLint, static_cast<std::size_t>(Uniform::Count)>;
+
       GLuint id = {};
+      // Every active uniform outside a block, found by reflection at link time.
+      Uniforms uniforms = {};
+      // Location of each uniform the renderer sets, -1 if the program lacks it.
+      Locations locations = {};
     };
   }
 }
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+namespace Afk {
+  namespace OpenGl {
+    /**
+     * Terrain handle - represents a loaded height map and the grid every
+     * patch of it is drawn with
+     */
+    struct TerrainHandle {
+      enum class Buffer { Grid = 0 };
+
+      GLuint vao     = {};
+      GLuint vbo     = {};
+      GLuint ibo     = {};
+      GLuint heights = {};
+      // Height map samples across and along.
+      glm::ivec2 size = {};
+      // Grid quads across a patch.
+      int patch_size = {};
+      // Indices of each quadrant of the grid, which are stored in order.
+      std::size_t quadrant_indices = {};
+    };
+  }
+}
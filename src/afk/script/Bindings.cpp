@@ -83,7 +83,9 @@ static auto vec_inverse(VecType *a) -> VecType {
 
 // todo move to keyboard mgmt
 static auto key_pressed(int key_code) -> bool {
-  return glfwGetKey(Afk::Engine::get().renderer.window, key_code) == GLFW_PRESS;
+  // Tracked from input events rather than asking GLFW, so replays see the
+  // recorded keys.
+  return Afk::Engine::get().event_manager.get_is_key_down(key_code);
 }
 
 static auto gameobject_get_entity(Afk::Asset::Asset *e) -> GameObjectWrapped {
@@ -187,7 +189,7 @@ auto Afk::add_engine_bindings(lua_State *lua) -> void {
 
       .beginClass<Afk::ModelSource>("model_component")
       .addFunction("parent", &get_parent<Afk::ModelSource>)
-      .addData("name", &Afk::ModelSource::name)
+      .addProperty("name", &Afk::ModelSource::get_name, &Afk::ModelSource::set_name)
       .endClass()
 
       .beginClass<Afk::BaseComponent>("component")
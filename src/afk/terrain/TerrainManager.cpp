@@ -8,12 +8,18 @@
 #include <FastNoiseSIMD/FastNoiseSIMD.h>
 #include <glm/glm.hpp>
 
+#include "afk/Afk.hpp"
 #include "afk/debug/Assert.hpp"
+#include "afk/debug/Profiler.hpp"
+#include "afk/memory/MemoryTracker.hpp"
+#include "afk/physics/Transform.hpp"
+#include "afk/renderer/Frustum.hpp"
 #include "afk/renderer/Mesh.hpp"
 
 using std::size_t;
 using std::vector;
 
+using glm::mat4;
 using glm::vec2;
 using glm::vec3;
 
@@ -21,6 +27,7 @@ using Afk::HeightMap;
 using Afk::Mesh;
 using Afk::Model;
 using Afk::TerrainManager;
+using Afk::TerrainPatch;
 using Afk::Texture;
 
 auto TerrainManager::generate_height_map(int width, int length, float roughness,
@@ -51,7 +58,7 @@ auto TerrainManager::generate_height_map(int width, int length, float roughness,
   delete noise;
 }
 
-auto TerrainManager::generate_flat_plane(int width, int length) -> void {
+auto TerrainManager::generate_flat_plane(int width, int length, Mesh &mesh) const -> void {
   afk_assert(width >= 1, "Invalid width");
   afk_assert(length >= 1, "Invalid length");
 
@@ -61,38 +68,44 @@ auto TerrainManager::generate_flat_plane(int width, int length) -> void {
   const auto num_vertices = static_cast<size_t>(w * l);
   const auto num_indices  = static_cast<size_t>((w - 1) * (l - 1) * 6);
 
-  this->mesh.vertices.resize(num_vertices);
-  this->mesh.indices.resize(num_indices);
+  mesh.vertices.resize(num_vertices);
+  mesh.indices.resize(num_indices);
+
+  auto &job_system = Afk::Engine::get().job_system;
+
+  // Every row writes its own vertices and quads, so rows can run in parallel.
+  job_system.parallel_for(0, static_cast<size_t>(l), [&](size_t row) {
+    const auto y = static_cast<int>(row);
 
-  auto vertexIndex = size_t{0};
-  for (auto y = 0; y < l; ++y) {
     for (auto x = 0; x < w; ++x) {
-      this->mesh.vertices[vertexIndex].position =
+      const auto vertexIndex = static_cast<size_t>(y * w + x);
+
+      mesh.vertices[vertexIndex].position =
           vec3{static_cast<float>(x) - static_cast<float>(width) / 2.0f, 0.0f,
                static_cast<float>(y) - static_cast<float>(length) / 2.0f};
 
       // FIXME
-      this->mesh.vertices[vertexIndex].uvs =
+      mesh.vertices[vertexIndex].uvs =
           vec2{static_cast<float>(x) / 2.0f, static_cast<float>(y) / 2.0f};
-
-      ++vertexIndex;
     }
-  }
+  });
+
+  job_system.parallel_for(0, static_cast<size_t>(l - 1), [&](size_t row) {
+    const auto y      = static_cast<int>(row);
+    auto indicesIndex = static_cast<size_t>(y * (w - 1) * 6);
 
-  auto indicesIndex = size_t{0};
-  for (auto y = 0; y < (l - 1); ++y) {
     for (auto x = 0; x < (w - 1); ++x) {
       auto start = y * w + x;
 
-      this->mesh.indices[indicesIndex++] = static_cast<Afk::Index>(start);
-      this->mesh.indices[indicesIndex++] = static_cast<Afk::Index>(start + w);
-      this->mesh.indices[indicesIndex++] = static_cast<Afk::Index>(start + 1);
+      mesh.indices[indicesIndex++] = static_cast<Afk::Index>(start);
+      mesh.indices[indicesIndex++] = static_cast<Afk::Index>(start + w);
+      mesh.indices[indicesIndex++] = static_cast<Afk::Index>(start + 1);
 
-      this->mesh.indices[indicesIndex++] = static_cast<Afk::Index>(start + 1);
-      this->mesh.indices[indicesIndex++] = static_cast<Afk::Index>(start + w);
-      this->mesh.indices[indicesIndex++] = static_cast<Afk::Index>(start + 1 + w);
+      mesh.indices[indicesIndex++] = static_cast<Afk::Index>(start + 1);
+      mesh.indices[indicesIndex++] = static_cast<Afk::Index>(start + w);
+      mesh.indices[indicesIndex++] = static_cast<Afk::Index>(start + 1 + w);
     }
-  }
+  });
 }
 
 auto TerrainManager::generate_terrain(int width, int length, float roughness,
@@ -100,17 +113,28 @@ auto TerrainManager::generate_terrain(int width, int length, float roughness,
   afk_assert(width >= 1, "Invalid width");
   afk_assert(length >= 1, "Invalid length");
 
-  this->generate_flat_plane(width, length);
-  this->generate_height_map(width, length, roughness, scaling);
+  const auto memory_tag = Afk::Memory::TagScope{Afk::Memory::Tag::Models};
 
-  for (auto i = std::size_t{0}; i < this->height_map.heights.size(); ++i) {
-    this->mesh.vertices[i].position.y += this->height_map.heights[i];
-  }
+  this->generate_height_map(width, length, roughness, scaling);
+  this->quad_tree.build(this->height_map);
 }
 
-auto TerrainManager::get_model() -> Model {
+auto TerrainManager::get_model() const -> Model {
+  const auto memory_tag = Afk::Memory::TagScope{Afk::Memory::Tag::Models};
+  const auto width      = this->height_map.width;
+  const auto length     = static_cast<int>(this->height_map.heights.size()) / width;
+
+  auto mesh = Mesh{};
+  this->generate_flat_plane(width, length, mesh);
+
+  Afk::Engine::get().job_system.parallel_for(
+      0, this->height_map.heights.size(),
+      [this, &mesh](size_t i) { mesh.vertices[i].position.y += this->height_map.heights[i]; });
+
+  mesh.update_bounds();
+
   auto model = Model{};
-  model.meshes.push_back(this->mesh);
+  model.meshes.push_back(std::move(mesh));
   model.meshes[0].transform.translation = glm::vec3{0.0f};
   model.file_path                       = "gen/terrain/terrain";
   model.file_dir                        = "gen/terrain";
@@ -118,6 +142,39 @@ auto TerrainManager::get_model() -> Model {
   return model;
 }
 
+auto TerrainManager::set_entity(GameObject _entity, const std::filesystem::path &shader_program)
+    -> void {
+  this->entity         = _entity;
+  this->shader_program = Afk::Engine::get().renderer.resolve_shader_program(shader_program);
+}
+
+auto TerrainManager::queue_draw(const mat4 &view_projection, const vec3 &camera) const -> void {
+  afk_profile_zone("TerrainManager::queue_draw");
+  auto &afk = Afk::Engine::get();
+
+  if (!this->entity.has_value() || !afk.registry.valid(*this->entity)) {
+    return;
+  }
+
+  const auto *transform = afk.registry.try_get<Afk::Transform>(*this->entity);
+
+  if (transform == nullptr) {
+    return;
+  }
+
+  // Select in the terrain's own space, where the tree's bounds are.
+  const auto model_matrix   = transform->get_matrix();
+  const auto terrain_camera = vec3{glm::inverse(model_matrix) * glm::vec4{camera, 1.0f}};
+
+  auto command = Renderer::TerrainCommand{
+      this->shader_program, model_matrix,
+      Memory::FrameVector<TerrainPatch>{Memory::FrameAllocator<TerrainPatch>{&afk.frame_arena}}};
+
+  this->quad_tree.select(Afk::make_frustum(view_projection * model_matrix), terrain_camera,
+                         command.patches);
+  afk.renderer.queue_terrain(std::move(command));
+}
+
 auto TerrainManager::initialize() -> void {
   afk_assert(!this->is_initialized, "Terrain manager already initialized");
 
@@ -1,9 +1,15 @@
 #pragma once
 
-#include <vector>
+#include <filesystem>
+#include <optional>
 
+#include <glm/glm.hpp>
+
+#include "afk/component/GameObject.hpp"
 #include "afk/physics/shape/HeightMap.hpp"
 #include "afk/renderer/Model.hpp"
+#include "afk/renderer/Renderer.hpp"
+#include "afk/terrain/TerrainQuadTree.hpp"
 
 namespace Afk {
   /**
@@ -11,8 +17,8 @@ namespace Afk {
    */
   class TerrainManager {
   public:
-    HeightMap height_map = {};
-    Mesh mesh            = {};
+    HeightMap height_map      = {};
+    TerrainQuadTree quad_tree = {};
 
     TerrainManager()                       = default;
     TerrainManager(TerrainManager &&)      = delete;
@@ -24,18 +30,30 @@ namespace Afk {
      */
     auto initialize() -> void;
     /**
-     * Get the current terrain model
+     * Build a model of the whole terrain at full detail. Drawing doesn't need
+     * it, so only build it for what needs the triangles, like nav mesh baking.
      */
-    auto get_model() -> Afk::Model;
+    auto get_model() const -> Afk::Model;
     /**
      * Generate a random terrain with the proivided parameters
      */
     auto generate_terrain(int width, int length, float roughness, float scaling) -> void;
+    /**
+     * Set the entity whose transform the terrain is drawn with
+     */
+    auto set_entity(GameObject entity, const std::filesystem::path &shader_program) -> void;
+    /**
+     * Queue the patches of the terrain in view for drawing
+     * \param camera camera position in the world
+     */
+    auto queue_draw(const glm::mat4 &view_projection, const glm::vec3 &camera) const -> void;
 
   private:
-    bool is_initialized = false;
+    bool is_initialized                      = false;
+    std::optional<GameObject> entity         = {};
+    Renderer::ShaderProgramId shader_program = {};
 
-    auto generate_flat_plane(int width, int length) -> void;
+    auto generate_flat_plane(int width, int length, Mesh &mesh) const -> void;
     auto generate_height_map(int width, int length, float roughness, float scaling) -> void;
   };
 }
@@ -0,0 +1,196 @@
+#include "afk/terrain/TerrainQuadTree.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "afk/debug/Assert.hpp"
+
+using glm::vec2;
+using glm::vec3;
+using std::size_t;
+
+using Afk::Aabb;
+using Afk::TerrainPatch;
+using Afk::TerrainQuadTree;
+
+auto TerrainQuadTree::build(const HeightMap &height_map, int _patch_size) -> void {
+  afk_assert(_patch_size >= 2 && _patch_size % 2 == 0, "Terrain patch size must be even");
+  afk_assert(height_map.width >= 2, "Height map too small");
+  afk_assert(height_map.heights.size() % static_cast<size_t>(height_map.width) == 0,
+             "Height map isn't rectangular");
+
+  this->patch_size = _patch_size;
+  this->width      = height_map.width;
+  this->length     = static_cast<int>(height_map.heights.size()) / height_map.width;
+  this->levels.clear();
+  this->ranges.clear();
+
+  afk_assert(this->length >= 2, "Height map too small");
+
+  // Leaves include the samples on the edges they share with their neighbours.
+  auto leaves   = Level{};
+  leaves.width  = (this->width - 2) / this->patch_size + 1;
+  leaves.length = (this->length - 2) / this->patch_size + 1;
+  leaves.bounds.resize(static_cast<size_t>(leaves.width * leaves.length));
+
+  for (auto y = 0; y < leaves.length; ++y) {
+    for (auto x = 0; x < leaves.width; ++x) {
+      const auto x0 = x * this->patch_size;
+      const auto y0 = y * this->patch_size;
+      const auto x1 = std::min(x0 + this->patch_size, this->width - 1);
+      const auto y1 = std::min(y0 + this->patch_size, this->length - 1);
+      auto bounds   = vec2{std::numeric_limits<float>::max(),
+                         std::numeric_limits<float>::lowest()};
+
+      for (auto sample_y = y0; sample_y <= y1; ++sample_y) {
+        for (auto sample_x = x0; sample_x <= x1; ++sample_x) {
+          const auto height = height_map.at({sample_x, sample_y});
+          bounds            = {std::min(bounds.x, height), std::max(bounds.y, height)};
+        }
+      }
+
+      leaves.bounds[static_cast<size_t>(y * leaves.width + x)] = bounds;
+    }
+  }
+
+  this->levels.push_back(std::move(leaves));
+
+  // Each parent covers up to four children, until one node covers it all.
+  while (this->levels.back().width > 1 || this->levels.back().length > 1) {
+    const auto &children = this->levels.back();
+    auto parents         = Level{};
+    parents.width        = (children.width + 1) / 2;
+    parents.length       = (children.length + 1) / 2;
+    parents.bounds.resize(static_cast<size_t>(parents.width * parents.length),
+                          vec2{std::numeric_limits<float>::max(),
+                               std::numeric_limits<float>::lowest()});
+
+    for (auto y = 0; y < children.length; ++y) {
+      for (auto x = 0; x < children.width; ++x) {
+        const auto &child = children.bounds[static_cast<size_t>(y * children.width + x)];
+        auto &parent      = parents.bounds[static_cast<size_t>((y / 2) * parents.width + x / 2)];
+        parent            = {std::min(parent.x, child.x), std::max(parent.y, child.y)};
+      }
+    }
+
+    this->levels.push_back(std::move(parents));
+  }
+
+  for (auto lod = size_t{0}; lod < this->levels.size(); ++lod) {
+    this->ranges.push_back(static_cast<float>(this->patch_size << lod) * DETAIL_DISTANCE);
+  }
+
+  // The root is always in range, so the whole terrain is drawn.
+  this->ranges.back() = std::numeric_limits<float>::max();
+}
+
+auto TerrainQuadTree::select(const Frustum &frustum, const vec3 &camera,
+                             Memory::FrameVector<TerrainPatch> &patches) const -> void {
+  if (this->levels.empty()) {
+    return;
+  }
+
+  this->select_node(this->get_lod_count() - 1, 0, 0, frustum, camera, patches);
+}
+
+auto TerrainQuadTree::get_patch_size() const -> int {
+  return this->patch_size;
+}
+
+auto TerrainQuadTree::get_lod_count() const -> int {
+  return static_cast<int>(this->levels.size());
+}
+
+auto TerrainQuadTree::get_range(int lod) const -> float {
+  return this->ranges[static_cast<size_t>(lod)];
+}
+
+auto TerrainQuadTree::get_aabb(int lod, int x, int y) const -> Aabb {
+  const auto &level  = this->levels[static_cast<size_t>(lod)];
+  const auto &bounds = level.bounds[static_cast<size_t>(y * level.width + x)];
+  const auto span    = this->patch_size << lod;
+  const auto x0      = x * span;
+  const auto y0      = y * span;
+  const auto x1      = std::min(x0 + span, this->width - 1);
+  const auto y1      = std::min(y0 + span, this->length - 1);
+  const auto half_x  = static_cast<float>(this->width) / 2.0f;
+  const auto half_z  = static_cast<float>(this->length) / 2.0f;
+
+  return {{static_cast<float>(x0) - half_x, bounds.x, static_cast<float>(y0) - half_z},
+          {static_cast<float>(x1) - half_x, bounds.y, static_cast<float>(y1) - half_z}};
+}
+
+auto TerrainQuadTree::get_quadrants(int lod, int x, int y) const -> std::uint8_t {
+  const auto span = this->patch_size << lod;
+  auto quadrants  = std::uint8_t{0};
+
+  for (auto quadrant = 0; quadrant < 4; ++quadrant) {
+    const auto x0 = x * span + (quadrant & 1) * span / 2;
+    const auto y0 = y * span + (quadrant >> 1) * span / 2;
+
+    if (x0 < this->width - 1 && y0 < this->length - 1) {
+      quadrants |= static_cast<std::uint8_t>(1 << quadrant);
+    }
+  }
+
+  return quadrants;
+}
+
+auto TerrainQuadTree::select_node(int lod, int x, int y, const Frustum &frustum,
+                                  const vec3 &camera,
+                                  Memory::FrameVector<TerrainPatch> &patches) const -> bool {
+  const auto aabb = this->get_aabb(lod, x, y);
+  const auto i    = static_cast<size_t>(lod);
+
+  // Out of range, so the parent draws this part of the terrain.
+  if (!Afk::intersects(aabb, {camera, this->ranges[i]})) {
+    return false;
+  }
+
+  if (!Afk::is_visible(frustum, aabb)) {
+    return true;
+  }
+
+  const auto span = static_cast<float>(this->patch_size << lod);
+  auto patch      = TerrainPatch{};
+  patch.offset    = vec2{static_cast<float>(x), static_cast<float>(y)} * span;
+  patch.size      = span;
+  patch.morph     = {this->ranges[i] * MORPH_START, this->ranges[i]};
+  patch.lod       = static_cast<std::uint8_t>(lod);
+
+  if (i == this->levels.size() - 1) {
+    patch.morph = vec2{std::numeric_limits<float>::max()};
+  }
+
+  // Nothing nearer needs more detail, so draw the whole node.
+  if (lod == 0 || !Afk::intersects(aabb, {camera, this->ranges[i - 1]})) {
+    patch.quadrants = this->get_quadrants(lod, x, y);
+    patches.push_back(patch);
+    return true;
+  }
+
+  // Children draw themselves where they're in range, this node fills in the
+  // quadrants they don't.
+  const auto &children = this->levels[i - 1];
+  patch.quadrants      = 0;
+
+  for (auto quadrant = 0; quadrant < 4; ++quadrant) {
+    const auto child_x = x * 2 + (quadrant & 1);
+    const auto child_y = y * 2 + (quadrant >> 1);
+
+    if (child_x >= children.width || child_y >= children.length) {
+      continue;
+    }
+
+    if (!this->select_node(lod - 1, child_x, child_y, frustum, camera, patches)) {
+      patch.quadrants |= static_cast<std::uint8_t>(1 << quadrant);
+    }
+  }
+
+  if (patch.quadrants != 0) {
+    patches.push_back(patch);
+  }
+
+  return true;
+}
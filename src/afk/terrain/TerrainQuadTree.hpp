@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "afk/memory/FrameArena.hpp"
+#include "afk/physics/shape/HeightMap.hpp"
+#include "afk/renderer/Bounds.hpp"
+#include "afk/renderer/Frustum.hpp"
+#include "afk/renderer/TerrainPatch.hpp"
+
+namespace Afk {
+  /**
+   * Quadtree over a height map choosing the patches to draw it with, in the
+   * style of continuous distance-dependent level of detail (CDLOD). Every
+   * level draws the same grid, each covering twice the samples of the level
+   * below, and nodes are drawn at the coarsest level whose range reaches the
+   * camera.
+   *
+   * Patches are in the terrain's own space, where sample (x, y) is at
+   * (x - width / 2, height, y - length / 2).
+   */
+  class TerrainQuadTree {
+  public:
+    /**
+     * Grid quads across a patch, which must be even
+     */
+    static constexpr int DEFAULT_PATCH_SIZE = 32;
+    /**
+     * Distance the finest level is drawn to, in patches
+     */
+    static constexpr float DETAIL_DISTANCE = 2.0f;
+    /**
+     * Fraction of a level's range vertices start morphing to the next at
+     */
+    static constexpr float MORPH_START = 0.7f;
+
+    /**
+     * Build the tree over a height map, replacing any tree built before
+     */
+    auto build(const HeightMap &height_map, int _patch_size = DEFAULT_PATCH_SIZE) -> void;
+    /**
+     * Get the patches of the terrain that may be in a frustum
+     * \param frustum frustum in the terrain's space
+     * \param camera camera position in the terrain's space
+     */
+    auto select(const Frustum &frustum, const glm::vec3 &camera,
+                Memory::FrameVector<TerrainPatch> &patches) const -> void;
+
+    auto get_patch_size() const -> int;
+    auto get_lod_count() const -> int;
+    /**
+     * Get how far from the camera a level of detail is drawn
+     */
+    auto get_range(int lod) const -> float;
+
+  private:
+    /**
+     * Height range of every node at a level of detail
+     */
+    struct Level {
+      int width                     = {};
+      int length                    = {};
+      std::vector<glm::vec2> bounds = {};
+    };
+
+    int patch_size            = DEFAULT_PATCH_SIZE;
+    int width                 = {};
+    int length                = {};
+    std::vector<Level> levels = {};
+    std::vector<float> ranges = {};
+
+    auto get_aabb(int lod, int x, int y) const -> Aabb;
+    /**
+     * Get the bits of the quadrants of a node that cover any of the terrain
+     */
+    auto get_quadrants(int lod, int x, int y) const -> std::uint8_t;
+    /**
+     * Add the patches of a node and its children
+     * \return whether the node was in range of its level, and so handled
+     */
+    auto select_node(int lod, int x, int y, const Frustum &frustum, const glm::vec3 &camera,
+                     Memory::FrameVector<TerrainPatch> &patches) const -> bool;
+  };
+}
@@ -0,0 +1,243 @@
+#include "afk/thread/JobSystem.hpp"
+
+#include <exception>
+#include <string>
+
+#include "afk/debug/Assert.hpp"
+#include "afk/debug/Profiler.hpp"
+#include "afk/io/Log.hpp"
+
+using Afk::Thread::JobCounter;
+using Afk::Thread::JobSystem;
+
+// The job system and worker index the current thread belongs to, if any.
+static thread_local const JobSystem *current_job_system = nullptr;
+static thread_local std::size_t current_worker          = {};
+
+auto JobCounter::is_done() const -> bool {
+  return this->value.load(std::memory_order_acquire) == 0;
+}
+
+JobSystem::~JobSystem() {
+  this->is_stopping.store(true);
+
+  {
+    const auto lock = std::lock_guard{this->sleep_mutex};
+    this->wake.notify_all();
+  }
+
+  for (auto &worker : this->workers) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+
+  if (current_job_system == this) {
+    current_job_system = nullptr;
+  }
+}
+
+auto JobSystem::initialize(std::optional<std::size_t> thread_count) -> void {
+  afk_assert(!this->is_initialized, "Job system already initialized");
+
+  const auto cores   = static_cast<std::size_t>(std::thread::hardware_concurrency());
+  const auto threads = thread_count.value_or(std::max(cores, std::size_t{2}) - 1);
+
+  // Create every worker before starting any, thieves walk the whole list.
+  for (auto i = std::size_t{0}; i <= threads; ++i) {
+    this->workers.push_back(std::make_unique<Worker>());
+  }
+
+  current_job_system = this;
+  current_worker     = 0;
+
+  for (auto i = std::size_t{1}; i <= threads; ++i) {
+    this->workers[i]->thread = std::thread{[this, i] { this->work(i); }};
+  }
+
+  this->is_initialized = true;
+}
+
+auto JobSystem::wait(JobCounter &counter) -> void {
+  while (!counter.is_done()) {
+    if (!this->help()) {
+      std::this_thread::yield();
+    }
+  }
+
+  if (counter.has_error.load(std::memory_order_acquire)) {
+    counter.has_error = false;
+    std::rethrow_exception(std::exchange(counter.error, nullptr));
+  }
+}
+
+auto JobSystem::help() -> bool {
+  auto *job = this->take();
+
+  if (job == nullptr) {
+    return false;
+  }
+
+  this->execute(job);
+
+  return true;
+}
+
+auto JobSystem::get_worker_count() const -> std::size_t {
+  return this->workers.size();
+}
+
+auto JobSystem::allocate() -> Job * {
+  afk_assert_debug(this->is_initialized, "Job system not initialized");
+
+  if (current_job_system != this) {
+    auto *job    = new Job{};
+    job->is_heap = true;
+    job->is_free = false;
+
+    return job;
+  }
+
+  auto &worker = *this->workers[current_worker];
+
+  while (true) {
+    auto &job = worker.jobs[worker.next_job++ & (MAX_JOBS - 1)];
+
+    if (job.is_free.load(std::memory_order_acquire)) {
+      job.is_free.store(false, std::memory_order_relaxed);
+      job.is_heap = false;
+
+      return &job;
+    }
+
+    // Still in flight from the last lap around the ring.
+    this->help();
+  }
+}
+
+auto JobSystem::submit(Job *job) -> void {
+  if (current_job_system == this) {
+    if (!this->workers[current_worker]->queue.push(job)) {
+      // Our queue is full, no point queueing more.
+      this->execute(job);
+      return;
+    }
+  } else {
+    const auto lock = std::lock_guard{this->injected_mutex};
+    this->injected_jobs.push(job);
+    ++this->injected_count;
+  }
+
+  ++this->queued_count;
+
+  if (this->sleeping_count > 0) {
+    const auto lock = std::lock_guard{this->sleep_mutex};
+    this->wake.notify_one();
+  }
+}
+
+auto JobSystem::take() -> Job * {
+  const auto is_worker = current_job_system == this;
+  const auto count     = this->workers.size();
+  auto *job            = static_cast<Job *>(nullptr);
+
+  if (is_worker) {
+    job = this->workers[current_worker]->queue.pop();
+  }
+
+  // Steal from everyone else, starting with our neighbour.
+  const auto start = is_worker ? current_worker + 1 : 0;
+  for (auto i = std::size_t{0}; job == nullptr && i < count; ++i) {
+    const auto victim = (start + i) % count;
+
+    if (!is_worker || victim != current_worker) {
+      job = this->workers[victim]->queue.steal();
+    }
+  }
+
+  if (job == nullptr && this->injected_count > 0) {
+    const auto lock = std::lock_guard{this->injected_mutex};
+
+    if (!this->injected_jobs.empty()) {
+      job = this->injected_jobs.front();
+      this->injected_jobs.pop();
+      --this->injected_count;
+    }
+  }
+
+  if (job != nullptr) {
+    --this->queued_count;
+  }
+
+  return job;
+}
+
+auto JobSystem::execute(Job *job) -> void {
+  auto error = std::exception_ptr{};
+
+  try {
+    job->invoke(job->storage);
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  job->destroy(job->storage);
+
+  // Release the job before the counter, a waiter may reuse either.
+  auto *counter = job->counter;
+
+  if (job->is_heap) {
+    delete job;
+  } else {
+    job->is_free.store(true, std::memory_order_release);
+  }
+
+  if (counter != nullptr) {
+    if (error != nullptr && !counter->has_error.exchange(true)) {
+      counter->error = error;
+    }
+
+    counter->value.fetch_sub(1, std::memory_order_acq_rel);
+  } else if (error != nullptr) {
+    // Nothing waits on the job to hear about it, and it mustn't unwind
+    // through a worker's loop.
+    try {
+      std::rethrow_exception(error);
+    } catch (const std::exception &exception) {
+      Afk::Io::log << "Job without a counter threw: " << exception.what() << '\n';
+    } catch (...) {
+      Afk::Io::log << "Job without a counter threw an unknown exception\n";
+    }
+
+    std::terminate();
+  }
+}
+
+auto JobSystem::work(std::size_t index) -> void {
+  constexpr auto spin_count = 64;
+
+  current_job_system = this;
+  current_worker     = index;
+  afk_profile_thread("Worker " + std::to_string(index));
+
+  while (!this->is_stopping) {
+    auto did_work = false;
+
+    for (auto i = 0; i < spin_count && !did_work; ++i) {
+      did_work = this->help();
+
+      if (!did_work) {
+        std::this_thread::yield();
+      }
+    }
+
+    if (did_work) {
+      continue;
+    }
+
+    auto lock = std::unique_lock{this->sleep_mutex};
+    ++this->sleeping_count;
+    this->wake.wait(lock, [this] { return this->is_stopping || this->queued_count > 0; });
+    --this->sleeping_count;
+  }
+}
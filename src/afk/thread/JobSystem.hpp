@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "afk/thread/WorkStealingQueue.hpp"
+
+namespace Afk {
+  namespace Thread {
+    /**
+     * Tracks a group of jobs, done once every job in the group has finished
+     */
+    class JobCounter {
+    public:
+      JobCounter()                   = default;
+      JobCounter(JobCounter &&)      = delete;
+      JobCounter(const JobCounter &) = delete;
+      auto operator=(const JobCounter &) -> JobCounter & = delete;
+      auto operator=(JobCounter &&) -> JobCounter & = delete;
+      /**
+       * Check if every job in the group has finished
+       */
+      auto is_done() const -> bool;
+
+    private:
+      std::atomic<int> value      = {0};
+      std::atomic<bool> has_error = {false};
+      std::exception_ptr error    = {};
+
+      friend class JobSystem;
+    };
+    /**
+     * Work-stealing job system. Each worker owns a lock-free deque it pushes
+     * and pops jobs from, idle workers steal from the others. The thread that
+     * initializes the job system becomes worker zero.
+     */
+    class JobSystem {
+    public:
+      /**
+       * Jobs in flight per worker
+       */
+      static constexpr std::size_t MAX_JOBS = 4096;
+      /**
+       * Largest callable stored inline in a job, anything bigger is boxed
+       */
+      static constexpr std::size_t JOB_STORAGE_SIZE = 64;
+
+      JobSystem() = default;
+      ~JobSystem();
+      JobSystem(JobSystem &&)      = delete;
+      JobSystem(const JobSystem &) = delete;
+      auto operator=(const JobSystem &) -> JobSystem & = delete;
+      auto operator=(JobSystem &&) -> JobSystem & = delete;
+      /**
+       * Start the worker threads, making the calling thread worker zero
+       * \param thread_count number of extra workers, by default one per core
+       * not counting the calling thread
+       */
+      auto initialize(std::optional<std::size_t> thread_count = std::nullopt) -> void;
+      /**
+       * Queue a job
+       * \param counter optional counter the job is added to
+       */
+      template<typename F>
+      auto run(F &&function, JobCounter *counter = nullptr) -> void;
+      /**
+       * Run jobs until every job in the counter has finished, rethrowing the
+       * first exception any of them threw
+       */
+      auto wait(JobCounter &counter) -> void;
+      /**
+       * Run a pending job if there is one
+       * \return true if a job was run
+       */
+      auto help() -> bool;
+      /**
+       * Call function(i) for every i in [begin, end) across all workers,
+       * returning once every call has finished
+       * \param grain indices per job, zero picks one from the worker count
+       */
+      template<typename F>
+      auto parallel_for(std::size_t begin, std::size_t end, F &&function,
+                        std::size_t grain = 0) -> void;
+      /**
+       * Get the number of workers, including the initializing thread
+       */
+      auto get_worker_count() const -> std::size_t;
+
+    private:
+      struct Job {
+        using Invoke  = void (*)(void *storage);
+        using Destroy = void (*)(void *storage);
+
+        alignas(std::max_align_t) unsigned char storage[JOB_STORAGE_SIZE];
+        Invoke invoke             = nullptr;
+        Destroy destroy           = nullptr;
+        JobCounter *counter       = nullptr;
+        bool is_heap              = false;
+        std::atomic<bool> is_free = {true};
+      };
+
+      struct Worker {
+        WorkStealingQueue<Job, MAX_JOBS> queue = {};
+        std::unique_ptr<Job[]> jobs            = std::make_unique<Job[]>(MAX_JOBS);
+        std::size_t next_job                   = {};
+        std::thread thread                     = {};
+      };
+
+      std::vector<std::unique_ptr<Worker>> workers = {};
+      bool is_initialized                          = false;
+
+      // Jobs queued from threads that aren't workers.
+      std::queue<Job *> injected_jobs          = {};
+      std::mutex injected_mutex                = {};
+      std::atomic<std::int64_t> injected_count = {0};
+
+      // Idle workers sleep until there is something to do.
+      std::atomic<std::int64_t> queued_count = {0};
+      std::atomic<int> sleeping_count        = {0};
+      std::atomic<bool> is_stopping          = {false};
+      std::mutex sleep_mutex                 = {};
+      std::condition_variable wake           = {};
+
+      auto allocate() -> Job *;
+      auto submit(Job *job) -> void;
+      auto take() -> Job *;
+      auto execute(Job *job) -> void;
+      auto work(std::size_t index) -> void;
+    };
+  }
+}
+
+template<typename F>
+auto Afk::Thread::JobSystem::run(F &&function, JobCounter *counter) -> void {
+  using Callable = std::decay_t<F>;
+
+  if constexpr (sizeof(Callable) > JOB_STORAGE_SIZE ||
+                alignof(Callable) > alignof(std::max_align_t)) {
+    this->run([boxed = std::make_unique<Callable>(std::forward<F>(function))] { (*boxed)(); },
+              counter);
+  } else {
+    auto *job = this->allocate();
+
+    new (job->storage) Callable(std::forward<F>(function));
+    job->invoke  = [](void *storage) { (*static_cast<Callable *>(storage))(); };
+    job->destroy = [](void *storage) { static_cast<Callable *>(storage)->~Callable(); };
+    job->counter = counter;
+
+    if (counter != nullptr) {
+      counter->value.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    this->submit(job);
+  }
+}
+
+template<typename F>
+auto Afk::Thread::JobSystem::parallel_for(std::size_t begin, std::size_t end,
+                                          F &&function, std::size_t grain) -> void {
+  if (begin >= end) {
+    return;
+  }
+
+  if (this->workers.empty()) {
+    // Not started yet, just run everything here.
+    for (auto i = begin; i < end; ++i) {
+      function(i);
+    }
+
+    return;
+  }
+
+  if (grain == 0) {
+    grain = std::max(std::size_t{1}, (end - begin) / (this->get_worker_count() * 4));
+  }
+
+  auto counter     = JobCounter{};
+  auto *body       = &function;
+  const auto first = std::min(begin + grain, end);
+  auto error       = std::exception_ptr{};
+
+  // Queued chunks point at the counter and the function, so whatever throws
+  // here is held until they've finished, as a worker's exception would be.
+  try {
+    for (auto chunk_begin = first; chunk_begin < end; chunk_begin += grain) {
+      const auto chunk_end = std::min(chunk_begin + grain, end);
+
+      this->run(
+          [body, chunk_begin, chunk_end] {
+            for (auto i = chunk_begin; i < chunk_end; ++i) {
+              (*body)(i);
+            }
+          },
+          &counter);
+    }
+
+    // Do the first chunk ourselves rather than sitting idle.
+    for (auto i = begin; i < first; ++i) {
+      function(i);
+    }
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  try {
+    this->wait(counter);
+  } catch (...) {
+    if (error == nullptr) {
+      throw;
+    }
+  }
+
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
@@ -0,0 +1,153 @@
+#include "afk/thread/SystemScheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include "afk/debug/Assert.hpp"
+
+using Afk::Thread::SystemScheduler;
+using System = Afk::Thread::SystemScheduler::System;
+
+static auto intersects(const std::vector<SystemScheduler::Resource> &lhs,
+                       const std::vector<SystemScheduler::Resource> &rhs) -> bool {
+  return std::any_of(lhs.begin(), lhs.end(), [&rhs](const auto &resource) {
+    return std::find(rhs.begin(), rhs.end(), resource) != rhs.end();
+  });
+}
+
+System::System(std::string _name, Function _function)
+  : name(std::move(_name)), function(std::move(_function)) {}
+
+auto System::exclusive() -> System & {
+  this->is_exclusive = true;
+  return *this;
+}
+
+auto System::on_main_thread() -> System & {
+  this->is_main_thread = true;
+  return *this;
+}
+
+auto System::conflicts_with(const System &other) const -> bool {
+  return this->is_exclusive || other.is_exclusive ||
+         intersects(this->write_set, other.write_set) ||
+         intersects(this->write_set, other.read_set) ||
+         intersects(this->read_set, other.write_set);
+}
+
+auto SystemScheduler::initialize(JobSystem *_job_system) -> void {
+  afk_assert(_job_system != nullptr, "Invalid job system");
+  this->job_system = _job_system;
+}
+
+auto SystemScheduler::add_system(System system) -> void {
+  const auto index = this->nodes.size();
+  auto node        = Node{std::move(system), {}, 0};
+
+  // Anything added earlier that touches the same data has to finish first.
+  for (auto i = std::size_t{0}; i < index; ++i) {
+    if (this->nodes[i].system.conflicts_with(node.system)) {
+      this->nodes[i].dependents.push_back(index);
+      ++node.dependency_count;
+    }
+  }
+
+  this->nodes.push_back(std::move(node));
+  this->remaining = std::make_unique<std::atomic<int>[]>(this->nodes.size());
+}
+
+auto SystemScheduler::run(float _dt) -> void {
+  afk_assert(this->job_system != nullptr, "System scheduler not initialized");
+
+  if (this->nodes.empty()) {
+    return;
+  }
+
+  this->dt      = _dt;
+  this->error   = nullptr;
+  this->pending = this->nodes.size();
+
+  for (auto i = std::size_t{0}; i < this->nodes.size(); ++i) {
+    this->remaining[i] = this->nodes[i].dependency_count;
+  }
+
+  for (auto i = std::size_t{0}; i < this->nodes.size(); ++i) {
+    if (this->nodes[i].dependency_count == 0) {
+      this->schedule(i);
+    }
+  }
+
+  // Run main thread systems as they become ready and help with everything
+  // else in between, until every system is done.
+  while (this->pending > 0) {
+    auto index = std::optional<std::size_t>{};
+
+    {
+      const auto lock = std::lock_guard{this->mutex};
+
+      if (!this->main_thread_ready.empty()) {
+        index = this->main_thread_ready.front();
+        this->main_thread_ready.pop();
+      }
+    }
+
+    if (index.has_value()) {
+      this->execute(*index);
+    } else if (!this->job_system->help()) {
+      std::this_thread::yield();
+    }
+  }
+
+  if (this->error != nullptr) {
+    std::rethrow_exception(this->error);
+  }
+}
+
+auto SystemScheduler::get_timings() const -> std::vector<Timing> {
+  auto timings = std::vector<Timing>{};
+  timings.reserve(this->nodes.size());
+
+  for (const auto &node : this->nodes) {
+    timings.push_back({node.system.name, node.seconds});
+  }
+
+  return timings;
+}
+
+auto SystemScheduler::schedule(std::size_t index) -> void {
+  if (this->nodes[index].system.is_main_thread) {
+    const auto lock = std::lock_guard{this->mutex};
+    this->main_thread_ready.push(index);
+  } else {
+    this->job_system->run([this, index] { this->execute(index); });
+  }
+}
+
+auto SystemScheduler::execute(std::size_t index) -> void {
+  using Clock      = std::chrono::steady_clock;
+  auto &node       = this->nodes[index];
+  const auto start = Clock::now();
+
+  try {
+    node.system.function(this->dt);
+  } catch (...) {
+    const auto lock = std::lock_guard{this->mutex};
+
+    if (this->error == nullptr) {
+      this->error = std::current_exception();
+    }
+  }
+
+  node.seconds = std::chrono::duration<float>(Clock::now() - start).count();
+
+  for (const auto dependent : node.dependents) {
+    if (--this->remaining[dependent] == 0) {
+      this->schedule(dependent);
+    }
+  }
+
+  --this->pending;
+}
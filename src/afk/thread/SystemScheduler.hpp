@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <ctti/type_id.hpp>
+
+#include "afk/thread/JobSystem.hpp"
+
+namespace Afk {
+  namespace Thread {
+    /**
+     * Runs engine systems each frame, in parallel wherever the components they
+     * declare access to don't conflict
+     */
+    class SystemScheduler {
+    public:
+      using Function = std::function<void(float dt)>;
+      using Resource = ctti::type_id_t;
+
+      /**
+       * How long a system took to run
+       */
+      struct Timing {
+        std::string_view name = {};
+        float seconds         = {};
+      };
+
+      /**
+       * A system and the resources it touches
+       */
+      class System {
+      public:
+        System(std::string _name, Function _function);
+        /**
+         * Declare the system reads T
+         */
+        template<typename T>
+        auto reads() -> System & {
+          this->read_set.push_back(ctti::type_id<T>());
+          return *this;
+        }
+        /**
+         * Declare the system writes T
+         */
+        template<typename T>
+        auto writes() -> System & {
+          this->write_set.push_back(ctti::type_id<T>());
+          return *this;
+        }
+        /**
+         * Declare the system may touch anything, so it never overlaps another
+         */
+        auto exclusive() -> System &;
+        /**
+         * Declare the system must run on the thread calling run()
+         */
+        auto on_main_thread() -> System &;
+        /**
+         * Check if this system must be ordered relative to another
+         */
+        auto conflicts_with(const System &other) const -> bool;
+
+        std::string name = {};
+
+      private:
+        Function function               = {};
+        std::vector<Resource> read_set  = {};
+        std::vector<Resource> write_set = {};
+        bool is_exclusive               = false;
+        bool is_main_thread             = false;
+
+        friend class SystemScheduler;
+      };
+
+      SystemScheduler()                        = default;
+      SystemScheduler(SystemScheduler &&)      = delete;
+      SystemScheduler(const SystemScheduler &) = delete;
+      auto operator=(const SystemScheduler &) -> SystemScheduler & = delete;
+      auto operator=(SystemScheduler &&) -> SystemScheduler & = delete;
+      /**
+       * Use the provided job system to run systems
+       */
+      auto initialize(JobSystem *_job_system) -> void;
+      /**
+       * Add a system, systems that conflict run in the order they were added
+       */
+      auto add_system(System system) -> void;
+      /**
+       * Run every system once and wait for them to finish
+       */
+      auto run(float dt) -> void;
+      /**
+       * Get how long each system took during the last run, in the order they
+       * were added
+       */
+      auto get_timings() const -> std::vector<Timing>;
+
+    private:
+      struct Node {
+        System system                      = {"", {}};
+        std::vector<std::size_t> dependents = {};
+        int dependency_count                = {};
+        float seconds                       = {};
+      };
+
+      JobSystem *job_system   = nullptr;
+      std::vector<Node> nodes = {};
+
+      // Per-frame state.
+      std::unique_ptr<std::atomic<int>[]> remaining = {};
+      std::atomic<std::size_t> pending              = {};
+      std::queue<std::size_t> main_thread_ready     = {};
+      std::exception_ptr error                      = {};
+      std::mutex mutex                              = {};
+      float dt                                      = {};
+
+      auto schedule(std::size_t index) -> void;
+      auto execute(std::size_t index) -> void;
+    };
+  }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Afk {
+  namespace Thread {
+    /**
+     * Fixed size Chase-Lev deque. The owning thread pushes and pops at the
+     * bottom, any other thread may steal from the top. Every operation is
+     * lock-free.
+     */
+    template<typename T, std::size_t Capacity>
+    class WorkStealingQueue {
+    public:
+      static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+      /**
+       * Push an item, only callable from the owning thread
+       * \return false if the queue is full
+       */
+      auto push(T *item) -> bool {
+        const auto b = this->bottom.load(std::memory_order_relaxed);
+        const auto t = this->top.load(std::memory_order_acquire);
+
+        if (b - t >= static_cast<std::int64_t>(Capacity)) {
+          return false;
+        }
+
+        this->items[static_cast<std::size_t>(b) & MASK].store(item, std::memory_order_relaxed);
+        this->bottom.store(b + 1, std::memory_order_release);
+
+        return true;
+      }
+      /**
+       * Pop the most recently pushed item, only callable from the owning thread
+       */
+      auto pop() -> T * {
+        const auto b = this->bottom.load(std::memory_order_relaxed) - 1;
+        this->bottom.store(b, std::memory_order_seq_cst);
+        auto t = this->top.load(std::memory_order_seq_cst);
+
+        if (t > b) {
+          // Empty.
+          this->bottom.store(b + 1, std::memory_order_relaxed);
+          return nullptr;
+        }
+
+        auto *item = this->items[static_cast<std::size_t>(b) & MASK].load(std::memory_order_relaxed);
+
+        if (t == b) {
+          // Last item, race any thieves for it.
+          if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                 std::memory_order_relaxed)) {
+            item = nullptr;
+          }
+
+          this->bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        return item;
+      }
+      /**
+       * Steal the least recently pushed item, callable from any thread
+       */
+      auto steal() -> T * {
+        auto t       = this->top.load(std::memory_order_seq_cst);
+        const auto b = this->bottom.load(std::memory_order_seq_cst);
+
+        if (t >= b) {
+          return nullptr;
+        }
+
+        auto *item = this->items[static_cast<std::size_t>(t) & MASK].load(std::memory_order_relaxed);
+
+        if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                               std::memory_order_relaxed)) {
+          return nullptr;
+        }
+
+        return item;
+      }
+
+    private:
+      static constexpr auto MASK = Capacity - 1;
+
+      // Keep the ends on separate cache lines, the owner and thieves hammer
+      // different ones.
+      alignas(64) std::atomic<std::int64_t> top    = {0};
+      alignas(64) std::atomic<std::int64_t> bottom = {0};
+      alignas(64) std::array<std::atomic<T *>, Capacity> items = {};
+    };
+  }
+}
@@ -1,6 +1,7 @@
 #include "afk/ui/Ui.hpp"
 
 #include <filesystem>
+#include <mutex>
 #include <vector>
 
 #include <imgui/examples/imgui_impl_glfw.h>
@@ -9,8 +10,10 @@
 
 #include "afk/Afk.hpp"
 #include "afk/debug/Assert.hpp"
+#include "afk/debug/Profiler.hpp"
 #include "afk/io/Log.hpp"
 #include "afk/io/Path.hpp"
+#include "afk/memory/MemoryTracker.hpp"
 #include "afk/renderer/Renderer.hpp"
 #include "afk/ai/DifficultyManager.hpp"
 #include "afk/ui/Unicode.hpp"
@@ -23,6 +26,10 @@ using std::vector;
 using std::filesystem::path;
 
 Ui::~Ui() {
+  if (!this->is_initialized) {
+    return;
+  }
+
   ImGui_ImplOpenGL3_Shutdown();
   ImGui_ImplGlfw_Shutdown();
   ImGui::DestroyContext();
@@ -76,12 +83,16 @@ auto Ui::draw() -> void {
   this->draw_model_viewer();
   this->draw_terrain_controller();
   this->draw_exit_screen();
+  this->draw_memory();
 
   if (this->show_imgui) {
     ImGui::ShowDemoWindow(&this->show_imgui);
   }
 
   ImGui::Render();
+}
+
+auto Ui::submit() const -> void {
   ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
@@ -114,6 +125,12 @@ auto Ui::draw_menu_bar() -> void {
       if (ImGui::MenuItem("Terrain controller")) {
         this->show_terrain_controller = true;
       }
+      if (ImGui::MenuItem("Memory")) {
+        this->show_memory = true;
+      }
+      if (ImGui::MenuItem("Save trace", nullptr, false, Afk::Profiler::is_enabled)) {
+        Afk::Profiler::get().save();
+      }
       ImGui::EndMenu();
     }
 
@@ -190,6 +207,24 @@ auto Ui::draw_stats() -> void {
                 static_cast<double>(pos.y), static_cast<double>(pos.z));
     ImGui::Text("Angles   {%.1f, %.1f}", static_cast<double>(angles.x),
                 static_cast<double>(angles.y));
+    ImGui::Separator();
+    const auto &draw_stats = afk.renderer.get_draw_stats();
+    ImGui::Text("Draws %zu (%zu meshes, %zu calls)", draw_stats.commands, draw_stats.meshes,
+                draw_stats.draw_calls);
+    ImGui::Text("Culled %zu of %zu meshes, %zu occluded, %zu too small", draw_stats.culled,
+                draw_stats.meshes, draw_stats.occluded, draw_stats.dropped);
+    ImGui::Text("Triangles %zu, %zu terrain patches", draw_stats.triangles,
+                draw_stats.terrain_patches);
+    const auto tree_stats = afk.render_tree.get_stats();
+    ImGui::Text("Render tree %zu static (height %d), %zu dynamic (height %d)",
+                tree_stats.static_objects, tree_stats.static_height,
+                tree_stats.dynamic_objects, tree_stats.dynamic_height);
+    ImGui::Text("Binds %zu programs, %zu textures, %zu VAOs", draw_stats.program_binds,
+                draw_stats.texture_binds, draw_stats.vao_binds);
+    ImGui::Separator();
+    ImGui::Text("Frame memory %.1f KiB (%.1f KiB overflow)",
+                static_cast<double>(afk.frame_arena.get_bytes_used()) / 1024.0,
+                static_cast<double>(afk.frame_arena.get_overflow_bytes()) / 1024.0);
 
     if (ImGui::BeginPopupContextWindow()) {
       if (ImGui::MenuItem("Custom", nullptr, corner == -1)) {
@@ -222,6 +257,9 @@ auto Ui::draw_log() -> void {
     return;
   }
 
+  // Workers append to the log under this lock, and drawing reads it.
+  const auto lock = std::lock_guard{Afk::Io::log.mutex};
+
   ImGui::SetNextWindowSize({500, 400});
   this->log.draw("Log", &this->show_log);
 }
@@ -263,10 +301,14 @@ auto Ui::draw_model_viewer() -> void {
         auto i = 0;
         for (const auto &mesh : model.meshes) {
           ImGui::TextWrapped("Mesh %d:\n", i);
-          ImGui::TextWrapped("VAO: %u\n", mesh.ibo);
-          ImGui::TextWrapped("VBO: %u\n", mesh.vbo);
-          ImGui::TextWrapped("IBO: %u\n", mesh.ibo);
+          ImGui::TextWrapped("VAO: %u\n", mesh.vao);
+          ImGui::TextWrapped("Base vertex: %d\n", mesh.base_vertex);
+          ImGui::TextWrapped("Index offset: %zu\n", mesh.lods.front().offset);
+          ImGui::TextWrapped("Index bits: %d\n", mesh.index_type == GL_UNSIGNED_SHORT ? 16 : 32);
           ImGui::TextWrapped("Indices: %zu\n", mesh.num_indices);
+          for (auto lod = std::size_t{1}; lod < mesh.lods.size(); ++lod) {
+            ImGui::TextWrapped("LOD %zu indices: %zu\n", lod, mesh.lods[lod].num_indices);
+          }
           ImGui::Separator();
           ++i;
         }
@@ -294,6 +336,72 @@ auto Ui::draw_terrain_controller() -> void {
   ImGui::End();
 }
 
+auto Ui::draw_memory() -> void {
+  if (!this->show_memory) {
+    return;
+  }
+
+  static constexpr auto KIB         = 1024.0f;
+  static constexpr auto SAMPLE_TIME = 0.5f;
+
+  auto &afk        = Engine::get();
+  const auto now   = Engine::get_time();
+  const auto since = now - this->last_memory_sample;
+
+  // Sample rates over a short window, per frame they are too noisy to read.
+  if (since >= SAMPLE_TIME) {
+    for (auto i = std::size_t{0}; i < Ui::MEMORY_TAG_COUNT; ++i) {
+      const auto allocations    = Memory::get_stats(static_cast<Memory::Tag>(i)).allocations;
+      const auto count          = allocations - this->last_allocations[i];
+      this->allocation_rates[i] = static_cast<float>(count) / since;
+      this->last_allocations[i] = allocations;
+    }
+
+    this->last_memory_sample = now;
+  }
+
+  ImGui::SetNextWindowSize({500, 300});
+
+  if (ImGui::Begin("Memory", &this->show_memory)) {
+    ImGui::Columns(4, "memory");
+    ImGui::Text("Subsystem");
+    ImGui::NextColumn();
+    ImGui::Text("Current KiB");
+    ImGui::NextColumn();
+    ImGui::Text("Peak KiB");
+    ImGui::NextColumn();
+    ImGui::Text("Allocs/s");
+    ImGui::NextColumn();
+    ImGui::Separator();
+
+    for (auto i = std::size_t{0}; i < Ui::MEMORY_TAG_COUNT; ++i) {
+      const auto tag   = static_cast<Memory::Tag>(i);
+      const auto stats = Memory::get_stats(tag);
+
+      ImGui::Text("%s", Memory::get_tag_name(tag));
+      ImGui::NextColumn();
+      ImGui::Text("%.1f", static_cast<float>(stats.current_bytes) / KIB);
+      ImGui::NextColumn();
+      ImGui::Text("%.1f", static_cast<float>(stats.peak_bytes) / KIB);
+      ImGui::NextColumn();
+      ImGui::Text("%.0f", this->allocation_rates[i]);
+      ImGui::NextColumn();
+    }
+
+    ImGui::Columns(1);
+    ImGui::Separator();
+    ImGui::Text("Frame arena %.1f KiB of %.1f KiB",
+                static_cast<float>(afk.frame_arena.get_bytes_used()) / KIB,
+                static_cast<float>(afk.frame_arena.get_capacity()) / KIB);
+
+    if (!Memory::is_tracking_global) {
+      ImGui::TextWrapped("General and Models only count new/delete when built with "
+                         "MemoryTracking");
+    }
+  }
+  ImGui::End();
+}
+
 auto Ui::draw_exit_screen() -> void {
   if (!this->show_exit_screen) {
     return;
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <memory>
 #include <unordered_map>
 
 #include <imgui/imgui.h>
 
+#include "afk/memory/MemoryTracker.hpp"
 #include "afk/renderer/Renderer.hpp"
 #include "afk/ui/Log.hpp"
 
@@ -30,7 +33,14 @@ namespace Afk {
     auto initialize(Renderer::Window _window) -> void;
     auto open() -> void;
     auto close() -> void;
+    /**
+     * Build this frame's UI, which may read anything in the engine
+     */
     auto draw() -> void;
+    /**
+     * Submit the UI built by draw() to the GPU
+     */
+    auto submit() const -> void;
     auto prepare() const -> void;
 
   private:
@@ -44,9 +54,19 @@ namespace Afk {
     bool show_model_viewer       = false;
     bool show_terrain_controller = false;
     bool show_exit_screen        = false;
+    bool show_memory             = false;
     bool is_initialized          = false;
     float scale                  = 1.5f;
 
+    static constexpr auto MEMORY_TAG_COUNT = static_cast<std::size_t>(Memory::Tag::Count);
+
+    /**
+     * Allocation counts at the last sample, to show allocation rates
+     */
+    std::array<std::size_t, MEMORY_TAG_COUNT> last_allocations = {};
+    std::array<float, MEMORY_TAG_COUNT> allocation_rates       = {};
+    float last_memory_sample                                   = {};
+
     std::unordered_map<std::string, ImFont *> fonts = {};
 
     auto draw_menu_bar() -> void;
@@ -56,5 +76,6 @@ namespace Afk {
     auto draw_model_viewer() -> void;
     auto draw_terrain_controller() -> void;
     auto draw_exit_screen() -> void;
+    auto draw_memory() -> void;
   };
 }
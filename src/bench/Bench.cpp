@@ -0,0 +1,587 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include <DetourCrowd.h>
+#include <glm/glm.hpp>
+
+#include "afk/Afk.hpp"
+#include "afk/asset/Asset.hpp"
+#include "afk/asset/AssetFactory.hpp"
+#include "afk/component/AgentComponent.hpp"
+#include "afk/component/AnimComponent.hpp"
+#include "afk/component/ScriptsComponent.hpp"
+#include "afk/component/TagComponent.hpp"
+#include "afk/debug/Assert.hpp"
+#include "afk/io/ModelLoader.hpp"
+#include "afk/io/ModelSource.hpp"
+#include "afk/io/Path.hpp"
+#include "afk/physics/PhysicsBody.hpp"
+#include "afk/physics/RigidBodyType.hpp"
+#include "afk/physics/shape/Capsule.hpp"
+#include "afk/renderer/MeshOptimizer.hpp"
+#include "afk/thread/JobSystem.hpp"
+
+using namespace std::string_literals;
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * What to benchmark
+ */
+struct Options {
+  std::string scene            = "agents";
+  std::size_t count            = 100;
+  int size                     = 128;
+  std::size_t frames           = 1000;
+  std::size_t warmup           = 60;
+  std::filesystem::path output = "bench.json";
+};
+
+/**
+ * Frame times in seconds, summarised
+ */
+struct Stats {
+  float mean = {};
+  float p50  = {};
+  float p95  = {};
+  float p99  = {};
+  float max  = {};
+};
+
+static auto summarise(std::vector<float> samples) -> Stats {
+  if (samples.empty()) {
+    return {};
+  }
+
+  std::sort(samples.begin(), samples.end());
+
+  // Nearest rank, same as replay stats.
+  const auto percentile = [&samples](float p) {
+    const auto rank = static_cast<std::size_t>(std::ceil(p * static_cast<float>(samples.size())));
+    return samples[std::max(rank, std::size_t{1}) - 1];
+  };
+
+  auto total = 0.0f;
+  for (const auto sample : samples) {
+    total += sample;
+  }
+
+  return {total / static_cast<float>(samples.size()), percentile(0.5f),
+          percentile(0.95f), percentile(0.99f), samples.back()};
+}
+
+static auto write_stats(std::ostream &out, const Stats &stats) -> void {
+  out << "{\"mean_ms\": " << stats.mean * 1000.0f << ", \"p50_ms\": " << stats.p50 * 1000.0f
+      << ", \"p95_ms\": " << stats.p95 * 1000.0f << ", \"p99_ms\": " << stats.p99 * 1000.0f
+      << ", \"max_ms\": " << stats.max * 1000.0f << "}";
+}
+
+/**
+ * Lay out count positions on a square grid centred on the origin
+ */
+static auto grid_position(std::size_t i, std::size_t count, float spacing, float height)
+    -> glm::vec3 {
+  const auto side   = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<float>(count))));
+  const auto offset = static_cast<float>(side - 1) * spacing * 0.5f;
+
+  return {static_cast<float>(i % side) * spacing - offset, height,
+          static_cast<float>(i / side) * spacing - offset};
+}
+
+static auto add_terrain(Afk::Engine &afk, const Options &options) -> void {
+  afk.terrain_manager.generate_terrain(options.size, options.size, 0.05f, 7.5f);
+  afk.renderer.load_terrain(afk.terrain_manager.height_map,
+                            afk.terrain_manager.quad_tree.get_patch_size());
+
+  auto terrain_entity           = afk.registry.create();
+  auto terrain_transform        = Afk::Transform{terrain_entity};
+  terrain_transform.translation = glm::vec3{0.0f, -10.0f, 0.0f};
+  afk.terrain_manager.set_entity(terrain_entity, "shader/terrain.prog");
+
+  // Only the nav mesh needs the terrain's triangles.
+  if (options.scene == "agents") {
+    afk.registry.assign<Afk::Model>(terrain_entity, terrain_entity,
+                                    afk.terrain_manager.get_model());
+  }
+
+  afk.registry.assign<Afk::Transform>(terrain_entity, terrain_transform);
+  afk.registry.assign<Afk::PhysicsBody>(terrain_entity, terrain_entity,
+                                        &afk.physics_body_system, terrain_transform,
+                                        0.3f, 0.0f, 0.0f, 0.0f, true,
+                                        Afk::RigidBodyType::STATIC,
+                                        afk.terrain_manager.height_map);
+  auto terrain_tags = Afk::TagComponent{terrain_entity};
+  terrain_tags.tags.insert(Afk::TagComponent::Tag::TERRAIN);
+  afk.registry.assign<Afk::TagComponent>(terrain_entity, terrain_tags);
+}
+
+static auto add_agents(Afk::Engine &afk, const Options &options) -> void {
+  afk_assert(afk.nav_mesh_manager.bake(), "Failed to bake nav mesh");
+  afk.crowds.init(afk.nav_mesh_manager.get_nav_mesh(), static_cast<int>(options.count));
+
+  const auto radius = static_cast<float>(options.size) * 0.25f;
+
+  for (auto i = std::size_t{0}; i < options.count; ++i) {
+    auto agent                  = afk.registry.create();
+    dtCrowdAgentParams p        = {};
+    p.radius                    = .1f;
+    p.maxSpeed                  = 1;
+    p.maxAcceleration           = 1;
+    p.height                    = 1;
+    auto agent_transform        = Afk::Transform{agent};
+    agent_transform.translation = grid_position(i, options.count, 1.0f, -10.0f);
+    agent_transform.scale       = {.1f, .1f, .1f};
+    afk.registry.assign<Afk::Transform>(agent, agent_transform);
+    afk.registry.assign<Afk::ModelSource>(agent, agent, "res/model/man/man.glb",
+                                          "shader/animation.prog");
+    afk.registry
+        .assign<Afk::AI::AgentComponent>(agent, agent, agent_transform.translation, p)
+        .wander(glm::vec3{0.0f, -10.0f, 0.0f}, radius, 5.0f);
+    afk.registry.assign<Afk::PhysicsBody>(agent, agent, &afk.physics_body_system,
+                                          agent_transform, 0.3f, 0.0f, 0.0f, 0.0f, true,
+                                          Afk::RigidBodyType::STATIC,
+                                          Afk::Capsule{0.3f, 1.0f});
+    afk.registry.assign<Afk::AnimComponent>(agent, agent, Afk::AnimComponent::Status::Playing,
+                                            "Walk", 0.0f);
+  }
+}
+
+static auto add_spheres(Afk::Engine &afk, const Options &options) -> void {
+  for (auto i = std::size_t{0}; i < options.count; ++i) {
+    const auto asset = Afk::Asset::game_asset_factory("asset/basketball.lua");
+    const auto ball  = std::get<Afk::Asset::Asset::Object>(asset.data).ent;
+
+    // Spread the balls out so they don't all spawn inside each other.
+    const auto position = grid_position(i, options.count, 3.0f, 20.0f);
+    afk.registry.get<Afk::Transform>(ball).translation = position;
+    afk.registry.get<Afk::PhysicsBody>(ball).set_pos(position);
+  }
+}
+
+static auto add_scripts(Afk::Engine &afk, const Options &options) -> void {
+  for (auto i = std::size_t{0}; i < options.count; ++i) {
+    auto entity           = afk.registry.create();
+    auto transform        = Afk::Transform{entity};
+    transform.translation = grid_position(i, options.count, 2.0f, 0.0f);
+    afk.registry.assign<Afk::Transform>(entity, transform);
+    afk.registry.assign<Afk::ScriptsComponent>(entity, entity, afk.lua)
+        .add_script("script/bench/bob.lua", &afk.event_manager);
+  }
+}
+
+/**
+ * A row of walls marked as occluders right in front of the camera, hiding a
+ * grid of models behind them that are all inside the view frustum
+ */
+static auto add_occluders(Afk::Engine &afk, const Options &options) -> void {
+  static constexpr auto wall_count  = 5;
+  static constexpr auto wall_width  = 20.0f;
+  static constexpr auto wall_height = 20.0f;
+  static constexpr auto spacing     = 3.0f;
+
+  // Looking down +x, so everything past the walls projects onto them.
+  afk.camera.set_position({0.0f, 2.0f, 0.0f});
+  afk.camera.set_angles({0.0f, 0.0f});
+
+  for (auto i = 0; i < wall_count; ++i) {
+    auto wall             = afk.registry.create();
+    auto transform        = Afk::Transform{wall};
+    transform.translation = {10.0f, 2.0f, (static_cast<float>(i) - 2.0f) * wall_width};
+    // The box is 2 units across.
+    transform.scale       = {1.0f, wall_height * 0.5f, wall_width * 0.5f};
+    afk.registry.assign<Afk::Transform>(wall, transform);
+    afk.registry.assign<Afk::ModelSource>(wall, wall, "res/model/box/box.obj",
+                                          "shader/default.prog", true);
+  }
+
+  const auto side   = std::ceil(std::sqrt(static_cast<float>(options.count)));
+  const auto extent = (side - 1.0f) * spacing * 0.5f;
+
+  for (auto i = std::size_t{0}; i < options.count; ++i) {
+    auto entity           = afk.registry.create();
+    auto transform        = Afk::Transform{entity};
+    transform.translation = grid_position(i, options.count, spacing, 2.0f) +
+                            glm::vec3{20.0f + extent, 0.0f, 0.0f};
+    afk.registry.assign<Afk::Transform>(entity, transform);
+    afk.registry.assign<Afk::ModelSource>(entity, entity, "res/model/basketball/basketball.fbx",
+                                          "shader/default.prog");
+  }
+}
+
+/**
+ * Optimise every model's meshes for the vertex cache, writing what that does
+ * to their simulated cache misses and how long it takes
+ */
+static auto bench_meshes(const Options &options) -> int {
+  static constexpr const char *extensions[] = {".obj", ".fbx", ".glb", ".gltf", ".dae"};
+
+  const auto root_dir = Afk::get_absolute_path("");
+  auto paths          = std::vector<std::filesystem::path>{};
+
+  for (const auto &entry :
+       std::filesystem::recursive_directory_iterator{Afk::get_absolute_path("res/model")}) {
+    const auto extension = entry.path().extension().string();
+
+    if (entry.is_regular_file() && std::find(std::begin(extensions), std::end(extensions),
+                                             extension) != std::end(extensions)) {
+      // Relative to the root, so textures are found beside the model.
+      paths.push_back(std::filesystem::relative(entry.path(), root_dir));
+    }
+  }
+
+  std::sort(paths.begin(), paths.end());
+
+  auto out = std::ofstream{options.output};
+
+  if (!out) {
+    std::cerr << "Unable to open '" << options.output.string() << "'\n";
+    return EXIT_FAILURE;
+  }
+
+  out << "{\n  \"scene\": \"" << options.scene << "\",\n  \"cache_size\": "
+      << Afk::VertexCacheStats::CACHE_SIZE << ",\n  \"models\": [";
+
+  auto first = true;
+  for (const auto &path : paths) {
+    auto loader            = Afk::ModelLoader{};
+    loader.optimize_meshes = false;
+    auto model             = loader.load(path);
+
+    auto before        = Afk::VertexCacheStats{};
+    auto after         = Afk::VertexCacheStats{};
+    auto optimize_time = 0.0f;
+
+    for (auto &mesh : model.meshes) {
+      const auto start        = Clock::now();
+      const auto optimization = Afk::optimize_mesh(mesh);
+      optimize_time += std::chrono::duration<float>(Clock::now() - start).count();
+
+      before.transformed += optimization.before.transformed;
+      before.triangles += optimization.before.triangles;
+      before.vertices += optimization.before.vertices;
+      after.transformed += optimization.after.transformed;
+      after.triangles += optimization.after.triangles;
+      after.vertices += optimization.after.vertices;
+    }
+
+    const auto name = path.lexically_relative("res/model");
+
+    out << (first ? "\n" : ",\n") << "    {\"model\": \"" << name.generic_string()
+        << "\", \"meshes\": " << model.meshes.size() << ", \"triangles\": " << before.triangles
+        << ", \"vertices\": " << before.vertices << ", \"acmr_before\": " << before.get_acmr()
+        << ", \"acmr_after\": " << after.get_acmr() << ", \"atvr_before\": " << before.get_atvr()
+        << ", \"atvr_after\": " << after.get_atvr()
+        << ", \"optimize_ms\": " << optimize_time * 1000.0f << "}";
+    first = false;
+
+    std::cerr << name.generic_string() << ": ACMR " << before.get_acmr() << " -> "
+              << after.get_acmr() << ", ATVR " << before.get_atvr() << " -> "
+              << after.get_atvr() << ", " << optimize_time * 1000.0f << " ms\n";
+  }
+
+  out << "\n  ]\n}\n";
+
+  std::cerr << options.scene << ": " << paths.size() << " models, written to "
+            << options.output.string() << '\n';
+
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Busy work standing in for the body of a job, a fraction of a microsecond
+ */
+static auto spin(std::size_t seed) -> float {
+  auto value = static_cast<float>(seed);
+
+  for (auto i = 0; i < 64; ++i) {
+    value = std::sqrt(value * 1.0001f + 1.0f);
+  }
+
+  return value;
+}
+
+/**
+ * Times for one job system size to run a frame's worth of separate jobs, and
+ * the same work through parallel_for
+ */
+struct JobScaling {
+  std::size_t workers           = {};
+  std::vector<float> jobs       = {};
+  std::vector<float> iterations = {};
+};
+
+static auto time_job_system(std::size_t workers, std::size_t items, const Options &options)
+    -> JobScaling {
+  auto scaling = JobScaling{workers};
+  auto results = std::vector<float>(items);
+  auto *data   = results.data();
+
+  scaling.jobs.reserve(options.frames);
+  scaling.iterations.reserve(options.frames);
+
+  // The thread that initializes a job system becomes its worker zero, so each
+  // size gets a thread of its own and the engine's job system is left alone.
+  auto thread = std::thread{[&] {
+    auto job_system = Afk::Thread::JobSystem{};
+    job_system.initialize(workers - 1);
+
+    for (auto frame = std::size_t{0}; frame < options.warmup + options.frames; ++frame) {
+      auto start   = Clock::now();
+      auto counter = Afk::Thread::JobCounter{};
+
+      for (auto i = std::size_t{0}; i < items; ++i) {
+        job_system.run([data, i] { data[i] = spin(i); }, &counter);
+      }
+
+      job_system.wait(counter);
+
+      const auto jobs_time = std::chrono::duration<float>(Clock::now() - start).count();
+
+      start = Clock::now();
+      job_system.parallel_for(0, items, [data](std::size_t i) { data[i] = spin(i); });
+
+      const auto iterations_time = std::chrono::duration<float>(Clock::now() - start).count();
+
+      if (frame >= options.warmup) {
+        scaling.jobs.push_back(jobs_time);
+        scaling.iterations.push_back(iterations_time);
+      }
+    }
+  }};
+
+  thread.join();
+
+  return scaling;
+}
+
+/**
+ * Run the same jobs through job systems of more and more workers, writing
+ * their throughput and how it scales from a single worker
+ */
+static auto bench_jobs(const Options &options) -> int {
+  const auto cores = std::max(std::size_t{1},
+                              static_cast<std::size_t>(std::thread::hardware_concurrency()));
+  const auto items = options.count * 100;
+
+  auto worker_counts = std::vector<std::size_t>{};
+  for (auto workers = std::size_t{1}; workers < cores; workers *= 2) {
+    worker_counts.push_back(workers);
+  }
+  worker_counts.push_back(cores);
+
+  auto out = std::ofstream{options.output};
+
+  if (!out) {
+    std::cerr << "Unable to open '" << options.output.string() << "'\n";
+    return EXIT_FAILURE;
+  }
+
+  out << "{\n  \"scene\": \"" << options.scene << "\",\n  \"count\": " << items
+      << ",\n  \"frames\": " << options.frames << ",\n  \"cores\": " << cores
+      << ",\n  \"workers\": [";
+
+  auto serial_jobs       = 0.0f;
+  auto serial_iterations = 0.0f;
+
+  for (const auto workers : worker_counts) {
+    const auto scaling    = time_job_system(workers, items, options);
+    const auto jobs       = summarise(scaling.jobs);
+    const auto iterations = summarise(scaling.iterations);
+
+    if (workers == 1) {
+      serial_jobs       = jobs.p50;
+      serial_iterations = iterations.p50;
+    }
+
+    const auto jobs_speedup       = serial_jobs / jobs.p50;
+    const auto iterations_speedup = serial_iterations / iterations.p50;
+
+    out << (workers == 1 ? "\n" : ",\n") << "    {\"workers\": " << workers
+        << ", \"jobs_per_s\": " << static_cast<float>(items) / jobs.p50
+        << ", \"jobs_speedup\": " << jobs_speedup
+        << ", \"parallel_for_per_s\": " << static_cast<float>(items) / iterations.p50
+        << ", \"parallel_for_speedup\": " << iterations_speedup << ", \"jobs\": ";
+    write_stats(out, jobs);
+    out << ", \"parallel_for\": ";
+    write_stats(out, iterations);
+    out << "}";
+
+    std::cerr << workers << " workers: jobs " << jobs.p50 * 1000.0f << " ms (x" << jobs_speedup
+              << "), parallel_for " << iterations.p50 * 1000.0f << " ms (x"
+              << iterations_speedup << ")\n";
+  }
+
+  out << "\n  ]\n}\n";
+
+  std::cerr << options.scene << ": " << items << " jobs a frame on up to " << cores
+            << " workers, written to " << options.output.string() << '\n';
+
+  return EXIT_SUCCESS;
+}
+
+static auto print_usage() -> void {
+  std::cerr << "Usage: afk_bench [--scene SCENE] [--count N] [--size M] [--frames N]\n"
+               "                 [--warmup N] [--output FILE] [--pipelined]\n"
+               "Scenes: agents, spheres, terrain, scripts, occlusion, meshes, jobs.\n"
+               "The jobs scene runs N * 100 jobs a frame on 1, 2, 4, ... workers.\n";
+}
+
+auto main(int argc, char **argv) -> int {
+  auto &afk    = Afk::Engine::get();
+  auto options = Options{};
+
+  for (auto i = 1; i < argc; ++i) {
+    const auto has_value = i + 1 < argc;
+
+    if (argv[i] == "--pipelined"s) {
+      afk.pipelined = true;
+    } else if (argv[i] == "--scene"s && has_value) {
+      options.scene = argv[++i];
+    } else if (argv[i] == "--count"s && has_value) {
+      options.count = std::stoul(argv[++i]);
+    } else if (argv[i] == "--size"s && has_value) {
+      options.size = std::stoi(argv[++i]);
+    } else if (argv[i] == "--frames"s && has_value) {
+      options.frames = std::stoul(argv[++i]);
+    } else if (argv[i] == "--warmup"s && has_value) {
+      options.warmup = std::stoul(argv[++i]);
+    } else if (argv[i] == "--output"s && has_value) {
+      options.output = argv[++i];
+    } else {
+      std::cerr << "Unknown argument '" << argv[i] << "'\n";
+      print_usage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (options.scene != "agents" && options.scene != "spheres" &&
+      options.scene != "terrain" && options.scene != "scripts" &&
+      options.scene != "occlusion" && options.scene != "meshes" && options.scene != "jobs") {
+    std::cerr << "Unknown scene '" << options.scene << "'\n";
+    print_usage();
+    return EXIT_FAILURE;
+  }
+
+  // Exactly one simulation step per frame, so frames are comparable between
+  // runs no matter how fast the machine is.
+  afk.headless            = true;
+  afk.default_scene       = false;
+  afk.fixed_timestep      = false;
+  afk.frame_time_override = 1.0f / afk.simulation_rate;
+  afk.initialize();
+
+  // Only needs the models, not a running scene.
+  if (options.scene == "meshes") {
+    const auto result = bench_meshes(options);
+    afk.shutdown();
+
+    return result;
+  }
+
+  if (options.scene == "jobs") {
+    const auto result = bench_jobs(options);
+    afk.shutdown();
+
+    return result;
+  }
+
+  const auto setup_start = Clock::now();
+
+  add_terrain(afk, options);
+
+  if (options.scene == "agents") {
+    add_agents(afk, options);
+  } else if (options.scene == "spheres") {
+    add_spheres(afk, options);
+  } else if (options.scene == "scripts") {
+    add_scripts(afk, options);
+  } else if (options.scene == "occlusion") {
+    add_occluders(afk, options);
+  }
+
+  afk.load_scene_models();
+
+  const auto setup_time = std::chrono::duration<float>(Clock::now() - setup_start).count();
+
+  auto frame_times  = std::vector<float>{};
+  auto system_times = std::map<std::string, std::vector<float>>{};
+  frame_times.reserve(options.frames);
+
+  for (auto frame = std::size_t{0}; frame < options.warmup + options.frames; ++frame) {
+    const auto start = Clock::now();
+    afk.update();
+    afk.render();
+    const auto frame_time = std::chrono::duration<float>(Clock::now() - start).count();
+
+    if (frame < options.warmup) {
+      continue;
+    }
+
+    frame_times.push_back(frame_time);
+
+    for (const auto &timing : afk.scheduler.get_timings()) {
+      system_times[std::string{timing.name}].push_back(timing.seconds);
+    }
+  }
+
+  auto out = std::ofstream{options.output};
+
+  if (!out) {
+    std::cerr << "Unable to open '" << options.output.string() << "'\n";
+    return EXIT_FAILURE;
+  }
+
+  const auto frame_stats = summarise(frame_times);
+  const auto &draw_stats  = afk.renderer.get_draw_stats();
+
+  out << "{\n  \"scene\": \"" << options.scene << "\",\n  \"count\": " << options.count
+      << ",\n  \"size\": " << options.size << ",\n  \"frames\": " << options.frames
+      << ",\n  \"pipelined\": " << (afk.pipelined ? "true" : "false")
+      << ",\n  \"workers\": " << afk.job_system.get_worker_count()
+      << ",\n  \"setup_ms\": " << setup_time * 1000.0f << ",\n  \"draw\": {\"commands\": "
+      << draw_stats.commands << ", \"meshes\": " << draw_stats.meshes
+      << ", \"program_binds\": " << draw_stats.program_binds
+      << ", \"texture_binds\": " << draw_stats.texture_binds
+      << ", \"vao_binds\": " << draw_stats.vao_binds
+      << ", \"draw_calls\": " << draw_stats.draw_calls << ", \"culled\": " << draw_stats.culled
+      << ", \"occluded\": " << draw_stats.occluded << ", \"dropped\": " << draw_stats.dropped
+      << ", \"triangles\": " << draw_stats.triangles
+      << ", \"terrain_patches\": " << draw_stats.terrain_patches
+      << ", \"bones\": " << draw_stats.bones << "},\n  \"frame\": ";
+  write_stats(out, frame_stats);
+  out << ",\n  \"systems\": {";
+
+  auto first = true;
+  for (const auto &[name, times] : system_times) {
+    out << (first ? "\n" : ",\n") << "    \"" << name << "\": ";
+    write_stats(out, summarise(times));
+    first = false;
+  }
+
+  out << "\n  }\n}\n";
+
+  std::cerr << options.scene << ": p50 " << frame_stats.p50 * 1000.0f << " ms, p95 "
+            << frame_stats.p95 * 1000.0f << " ms, p99 " << frame_stats.p99 * 1000.0f
+            << " ms, written to " << options.output.string() << '\n';
+
+  if (options.scene == "occlusion") {
+    std::cerr << options.scene << ": " << draw_stats.occluded << " of " << draw_stats.meshes
+              << " meshes occluded, " << draw_stats.culled << " outside the view\n";
+  }
+
+  afk.shutdown();
+
+  return EXIT_SUCCESS;
+}